@@ -72,6 +72,7 @@
 // Include oscilloscope
 // #define USE_I2S_INTERFACE             // I2S interface improves web based oscilloscope analog sampling (of a single signal) if ESP32 board has one
 // check INVERT_ADC1_GET_RAW and INVERT_I2S_READ #definitions in oscilloscope.h if the signals are inverted
+// #define OSCILLOSCOPE_ISOLATION_PROFILE OSC_ISOLATION_PINNED_YIELDING  // pin oscReader to APP_CPU, each oscReader reports the sampling jitter it has achieved to Serial Monitor when it stops
 #include "oscilloscope.h"
 
 
@@ -95,6 +96,12 @@ String httpRequestHandlerCallback (const char *httpRequest, httpServer_t::httpCo
 
     #define httpRequestIs(X) (strstr(httpRequest,X)==httpRequest)
 
+    // sampling jitter histogram of all the oscilloscopes since ESP32 has started, ?reset also starts measuring again
+    if (httpRequestIs ("GET /oscilloscope/jitter ") || httpRequestIs ("GET /oscilloscope/jitter?reset ")) {
+        hcn->setHttpReplyHeaderField ("Content-Type", "application/json");
+        return oscSamplingJitterJson (httpRequestIs ("GET /oscilloscope/jitter?reset "));
+    }
+
     #ifdef USE_FILE_SYSTEM
         // if HTTP request is GET /oscilloscope.html HTTP server will fetch the file but let us redirect GET / and GET /index.html to it as well
         if (httpRequestIs ("GET / ") || httpRequestIs ("GET /index.html ")) {
@@ -172,6 +179,10 @@ void setup () {
     // or simply call WiFi.begin ("YOUR STA SSID", "YOUR STA PASSWORD");
 
 
+    // Create oscReader tasks only once, they will be reused by all the oscilloscopes.
+    startOscReaderWorkers ();
+
+
     // Start the HTTP server. To save ~3 KB of RAM, the listener can run inside the
     // setup/loop task instead of its own task.
     // In this mode you must call httpServer->accept() manually from loop().
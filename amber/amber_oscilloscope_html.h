@@ -444,6 +444,148 @@
     "                            <span class='slider'></span>\n" \
     "                        </label>\n" \
     "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <!-- <label>logic analyzer</label> -->\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            logic analyzer\n" \
+    "                            <span class='tooltip-text'>Takes samples of up to 16 GPIOs at the same time. GPIO Selection is replaced by the list of GPIOs below, the first one is used for triggering.</span>\n" \
+    "                        </span>\n" \
+    "                        <label class='switch'>\n" \
+    "                            <input type='radio' name='mode' id='logic' onchange=\"\n" \
+    "                                drawBackgroundAndCalculateParameters();\n" \
+    "                                document.getElementById('sensitivity').disabled = true;\n" \
+    "                                document.getElementById('sensitivityLabel').style.color = 'gray';\n" \
+    "                                document.getElementById('position').disabled = true;\n" \
+    "                                document.getElementById('positionLabel').style.color = 'gray';\n" \
+    "                                document.getElementById('posTreshold').disabled = true;\n" \
+    "                                document.getElementById('posTriggerLabel').style.color = 'gray';\n" \
+    "                                document.getElementById('negTreshold').disabled = true;\n" \
+    "                                document.getElementById('negTriggerLabel').style.color = 'gray';\n" \
+    "                            \">\n" \
+    "                            <span class='slider'></span>\n" \
+    "                        </label>\n" \
+    "                    </div>\n" \
+    "                    <input type='text' id='logicGpios' value='4, 16' style='width:100%' onchange=\"\n" \
+    "                        drawBackgroundAndCalculateParameters();\n" \
+    "                    \">\n" \
+    "\n" \
+    "                    <div class='control-row' style='margin-top:15px'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Sample format:\n" \
+    "                            <span class='tooltip-text'>Continuously sampled (I2S) analog signal can be sent packed into 12 or 8 bits per sample, so more samples fit on one screen.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='sampleBits'>\n" \
+    "                            <option value='16' selected>16 bits</option>\n" \
+    "                            <option value='12'>12 bits</option>\n" \
+    "                            <option value='8'>8 bits</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            ADC values:\n" \
+    "                            <span class='tooltip-text'>ESP32 can correct nonlinear ADC readings with its calibration data and send analog values either calibrated(0 - 4095 = 0 - 3.3 V) or in mV.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='analogUnit'>\n" \
+    "                            <option value='0' selected>Raw</option>\n" \
+    "                            <option value='1'>Calibrated</option>\n" \
+    "                            <option value='2'>Millivolts</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            <input type='checkbox' id='peakDetect'>Peak detect\n" \
+    "                            <span class='tooltip-text'>Analog signal is sampled as fast as possible and each point on the screen shows min and max value between two samples, so short glitches are not lost at long screen widths.</span>\n" \
+    "                        </span>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Acquisition:\n" \
+    "                            <span class='tooltip-text'>With I2S interface ESP32 can combine more triggered screens into one before sending it: Average removes ADC noise, Envelope shows min and max of each sample and Persistence shows the envelope of all the screens, slowly fading back to the signal.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='acquisition' onchange='reconfigureOscilloscope();'>\n" \
+    "                            <option value='0' selected>Normal</option>\n" \
+    "                            <option value='1'>Average</option>\n" \
+    "                            <option value='2'>Envelope</option>\n" \
+    "                            <option value='3'>Persistence</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Screens:\n" \
+    "                            <span class='tooltip-text'>The number of screens combined into one, with Persistence how slowly the envelope fades.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='acquisitionFrames' onchange='reconfigureOscilloscope();'>\n" \
+    "                            <option value='4' selected>4 screens</option>\n" \
+    "                            <option value='16'>16 screens</option>\n" \
+    "                            <option value='64'>64 screens</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Spectrum:\n" \
+    "                            <span class='tooltip-text'>With I2S interface ESP32 can calculate the spectrum(FFT) of a single analog signal and send the frequency bins(from 0 to half of the sampling frequency, in dB relative to full scale sine) instead of the samples. Sample format decides if the bins are sent in 16 or 8 bits.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='spectrumWindow'>\n" \
+    "                            <option value='off' selected>off</option>\n" \
+    "                            <option value='1'>Hann</option>\n" \
+    "                            <option value='2'>Flat-top</option>\n" \
+    "                            <option value='3'>Blackman</option>\n" \
+    "                            <option value='0'>Rectangular</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Average:\n" \
+    "                            <span class='tooltip-text'>The powers of more spectra are averaged into each screen, which smooths the noise but slows down the screen refresh.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='spectrumAverage'>\n" \
+    "                            <option value='1' selected>1 spectrum</option>\n" \
+    "                            <option value='4'>4 spectra</option>\n" \
+    "                            <option value='16'>16 spectra</option>\n" \
+    "                            <option value='64'>64 spectra</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "                </div>\n" \
+    "\n" \
+    "                <!-- DEEP RECORD -->\n" \
+    "                <div class='card'>\n" \
+    "                    <h2>Record</h2>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Record length:\n" \
+    "                            <span class='tooltip-text'>With I2S interface and PSRAM ESP32 can take one long record of a single analog signal at the selected sampling rate and send it afterwards. Use Zoom and Position to look into it.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='recordLength'>\n" \
+    "                            <option value='0' selected>1 screen</option>\n" \
+    "                            <option value='65536'>64 K samples</option>\n" \
+    "                            <option value='262144'>256 K samples</option>\n" \
+    "                            <option value='1048576'>1 M samples</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "                    <div class='control-row' style='margin-top:15px'>\n" \
+    "                        <label>Zoom:</label>\n" \
+    "                        <span id='recordZoomLabel'>1 x</span>\n" \
+    "                    </div>\n" \
+    "                    <input type='range' id='recordZoom' min='0' max='10' value='0' onchange=\"\n" \
+    "                        document.getElementById('recordZoomLabel').textContent =(1 &lt;&lt; this.value) + ' x';\n" \
+    "                        drawDeepRecord();\n" \
+    "                    \">\n" \
+    "                    <div class='control-row' style='margin-top:15px'>\n" \
+    "                        <label>Position:</label>\n" \
+    "                        <span id='recordPositionLabel'>0 %</span>\n" \
+    "                    </div>\n" \
+    "                    <input type='range' id='recordPosition' min='0' max='100' value='0' onchange=\"\n" \
+    "                        document.getElementById('recordPositionLabel').textContent = this.value + ' %';\n" \
+    "                        drawDeepRecord();\n" \
+    "                    \">\n" \
     "                </div>\n" \
     "\n" \
     "                <!-- VERTICAL -->\n" \
@@ -475,13 +617,14 @@
     "                    <div class='control-row'>\n" \
     "                        <label>↑ CH 1 slope</label>\n" \
     "                        <label class='switch'>\n" \
-    "                            <input type='checkbox' id='posTrigger'>\n" \
+    "                            <input type='checkbox' id='posTrigger' onchange='reconfigureOscilloscope();'>\n" \
     "                            <span class='slider'></span>\n" \
     "                        </label>\n" \
     "                    </div>\n" \
     "                    <input type='range' id='posTreshold' min='1' max='4095' value='1000' disabled onchange=\"\n" \
     "                        document.getElementById('posTriggerLabel').textContent = 'on ' + this.value;\n" \
     "                        document.getElementById('posTrigger').checked = true;\n" \
+    "                        reconfigureOscilloscope();\n" \
     "                    \">\n" \
     "                    <div id='posTriggerLabel' style='margin-top:5px;'>on 1000</div>\n" \
     "\n" \
@@ -490,15 +633,111 @@
     "                    <div class='control-row'>\n" \
     "                        <label>↓ CH 1 slope</label>\n" \
     "                        <label class='switch'>\n" \
-    "                            <input type='checkbox' id='negTrigger'>\n" \
+    "                            <input type='checkbox' id='negTrigger' onchange='reconfigureOscilloscope();'>\n" \
     "                            <span class='slider'></span>\n" \
     "                        </label>\n" \
     "                    </div>\n" \
     "                    <input type='range' id='negTreshold' min='0' max='4094' value='3000' disabled onchange=\"\n" \
     "                        document.getElementById('negTriggerLabel').textContent = 'on ' + this.value;\n" \
     "                        document.getElementById('negTrigger').checked = true;\n" \
+    "                        reconfigureOscilloscope();\n" \
     "                    \">\n" \
     "                    <div id='negTriggerLabel' style='margin-top:5px;'>on 3000</div>\n" \
+    "\n" \
+    "                    <hr>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Pre-trigger\n" \
+    "                            <span class='tooltip-text'>How much of the screen shows the signal before the trigger condition occured.</span>\n" \
+    "                        </span>\n" \
+    "                        <span id='preTriggerLabel'>0 %</span>\n" \
+    "                    </div>\n" \
+    "                    <input type='range' id='preTrigger' min='0' max='100' step='5' value='0' onchange=\"\n" \
+    "                        document.getElementById('preTriggerLabel').textContent = this.value + ' %';\n" \
+    "                        reconfigureOscilloscope();\n" \
+    "                    \">\n" \
+    "\n" \
+    "                    <hr>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Type\n" \
+    "                            <span class='tooltip-text'>Edge triggers on the slopes above. Window and runt use both tresholds as the boundaries: window triggers when the signal enters or leaves them, runt when it crosses one of them and returns without crossing the other one. Pulse width triggers at the end of a pulse above ↑ treshold or below ↓ treshold.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='triggerType' onchange='reconfigureOscilloscope();'>\n" \
+    "                            <option value='0' selected>Edge</option>\n" \
+    "                            <option value='1'>Window enter</option>\n" \
+    "                            <option value='2'>Window exit</option>\n" \
+    "                            <option value='3'>Pulse longer than</option>\n" \
+    "                            <option value='4'>Pulse shorter than</option>\n" \
+    "                            <option value='5'>Runt</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Pulse width\n" \
+    "                            <span class='tooltip-text'>In us, used by pulse width triggers.</span>\n" \
+    "                        </span>\n" \
+    "                        <input type='number' id='pulseWidth' min='1' value='100' style='width:80px' onchange='reconfigureOscilloscope();'>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Source\n" \
+    "                            <span class='tooltip-text'>The signal that is checked for the trigger condition. Separate GPIO is a digital input that is not displayed (it can not be used with I2S interface).</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='triggerSource' onchange='reconfigureOscilloscope();'>\n" \
+    "                            <option value='0' selected>CH 1</option>\n" \
+    "                            <option value='1'>CH 2</option>\n" \
+    "                            <option value='2'>GPIO</option>\n" \
+    "                        </select>\n" \
+    "                        <input type='number' id='triggerGpio' min='0' max='39' value='0' style='width:50px' onchange='reconfigureOscilloscope();'>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Hysteresis\n" \
+    "                            <span class='tooltip-text'>How far the analog signal must get back from the treshold before it can cross it again, so noise doesn't trigger the screen.</span>\n" \
+    "                        </span>\n" \
+    "                        <span id='hysteresisLabel'>0</span>\n" \
+    "                    </div>\n" \
+    "                    <input type='range' id='hysteresis' min='0' max='500' step='10' value='0' onchange=\"\n" \
+    "                        document.getElementById('hysteresisLabel').textContent = this.value;\n" \
+    "                        reconfigureOscilloscope();\n" \
+    "                    \">\n" \
+    "\n" \
+    "                    <hr>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Mode\n" \
+    "                            <span class='tooltip-text'>Normal shows only the triggered screens. Auto also shows untriggered screen if the trigger condition doesn't occur in 100 ms. Single stops after the first triggered screen, Re-arm takes the next one.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='triggerMode' onchange='reconfigureOscilloscope();'>\n" \
+    "                            <option value='0' selected>Normal</option>\n" \
+    "                            <option value='1'>Auto</option>\n" \
+    "                            <option value='2'>Single</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Holdoff\n" \
+    "                            <span class='tooltip-text'>How long the trigger stays disarmed after a triggered screen, so bursts of events don't retrigger the screen.</span>\n" \
+    "                        </span>\n" \
+    "                        <select id='holdoff' onchange='reconfigureOscilloscope();'>\n" \
+    "                            <option value='0' selected>none</option>\n" \
+    "                            <option value='100'>100 us</option>\n" \
+    "                            <option value='1000'>1 ms</option>\n" \
+    "                            <option value='10000'>10 ms</option>\n" \
+    "                            <option value='100000'>100 ms</option>\n" \
+    "                            <option value='1000000'>1 s</option>\n" \
+    "                        </select>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <button id='rearmButton' class='button button2' style='width:100%; margin-top:10px' disabled onclick='reconfigureOscilloscope();'>Re-arm</button>\n" \
     "                </div>\n" \
     "\n" \
     "                <!-- HORIZONTAL -->\n" \
@@ -511,6 +750,7 @@
     "                    <input type='range' id='frequency' min='1' max='17' value='14' onchange=\"\n" \
     "                        document.getElementById('frequencyLabel').textContent = frequencyLabelFromFrequencySlider(this.value);\n" \
     "                        drawBackgroundAndCalculateParameters();\n" \
+    "                        reconfigureOscilloscope();\n" \
     "                    \">\n" \
     "                </div>\n" \
     "\n" \
@@ -529,6 +769,19 @@
     "                    </div>\n" \
     "\n" \
     "                    <div class='control-row'>\n" \
+    "                        <label>Measurements</label>\n" \
+    "                        <label class='switch'><input type='checkbox' id='measurements' onchange='reconfigureOscilloscope();'><span class='slider'></span></label>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
+    "                        <span class='tooltip'>\n" \
+    "                            Sampling jitter\n" \
+    "                            <span class='tooltip-text'>How much the actual intervals between the samples differ from the sampling time, over all the oscilloscopes since ESP32 has started(also available as JSON at /oscilloscope/jitter).</span>\n" \
+    "                        </span>\n" \
+    "                        <label class='switch'><input type='checkbox' id='jitter'><span class='slider'></span></label>\n" \
+    "                    </div>\n" \
+    "\n" \
+    "                    <div class='control-row'>\n" \
     "                        <label>Remember settings</label>\n" \
     "                        <label class='switch'><input type='checkbox' id='remember'><span class='slider'></span></label>\n" \
     "                    </div>\n" \
@@ -547,6 +800,10 @@
     "                            alert('Cannot digitalRead GPIO ' + document.getElementById('gpio1').value + '.');\n" \
     "                        } else if(document.getElementById('digital').checked &amp;&amp; document.getElementById('gpio2').value != '255' &amp;&amp;(',' + invalidDigitalInputs + ',').indexOf(',' + document.getElementById('gpio2').value + ',') != -1) {\n" \
     "                            alert('Cannot digitalRead GPIO ' + document.getElementById('gpio2').value + '.');\n" \
+    "                        } else if(document.getElementById('logic').checked &amp;&amp;(logicGpioList().length &lt; 1 || logicGpioList().length &gt; 16)) {\n" \
+    "                            alert('Logic analyzer can take samples of 1 to 16 GPIOs.');\n" \
+    "                        } else if(document.getElementById('logic').checked &amp;&amp; logicGpioList().some(g =&gt;(',' + invalidDigitalInputs + ',').indexOf(',' + g + ',') != -1)) {\n" \
+    "                            alert('Cannot digitalRead GPIO ' + logicGpioList().find(g =&gt;(',' + invalidDigitalInputs + ',').indexOf(',' + g + ',') != -1) + '.');\n" \
     "                        } else {\n" \
     "                            saveSettings();\n" \
     "                            drawBackgroundAndCalculateParameters();\n" \
@@ -578,7 +835,7 @@
     "            window.addEventListener('resize',(e) => {\n" \
     "                currentWidth = document.documentElement.clientWidth;\n" \
     "                // if oscilloscope is not running we can resize and redraw canvas right now\n" \
-    "                if(document.getElementById('stopButton').disabled == true) drawBackgroundAndCalculateParameters();\n" \
+    "                if(document.getElementById('stopButton').disabled == true) { if(deepRecord != null) drawDeepRecord(); else drawBackgroundAndCalculateParameters(); }\n" \
     "            });\n" \
     "            // correct canvas size\n" \
     "            function resizeCanvas() {\n" \
@@ -627,15 +884,35 @@
     "            v = getCookie('gpio1'); if(v != '') document.getElementById('gpio1').value = v;\n" \
     "            v = getCookie('gpio2'); if(v != '') document.getElementById('gpio2').value = v;\n" \
     "            v = getCookie('analog'); if(v == 'true') document.getElementById('analog').checked = true; else document.getElementById('digital').checked = true;\n" \
+    "            v = getCookie('logic'); if(v == 'true') document.getElementById('logic').checked = true;\n" \
+    "            v = getCookie('logicGpios'); if(v != '') document.getElementById('logicGpios').value = v;\n" \
+    "            v = getCookie('sampleBits'); if(v != '') document.getElementById('sampleBits').value = v;\n" \
+    "            v = getCookie('analogUnit'); if(v != '') document.getElementById('analogUnit').value = v;\n" \
+    "            v = getCookie('peakDetect'); if(v != '') document.getElementById('peakDetect').checked =(v == 'true');\n" \
+    "            v = getCookie('acquisition'); if(v != '') document.getElementById('acquisition').value = v;\n" \
+    "            v = getCookie('acquisitionFrames'); if(v != '') document.getElementById('acquisitionFrames').value = v;\n" \
+    "            v = getCookie('spectrumWindow'); if(v != '') document.getElementById('spectrumWindow').value = v;\n" \
+    "            v = getCookie('spectrumAverage'); if(v != '') document.getElementById('spectrumAverage').value = v;\n" \
+    "            v = getCookie('recordLength'); if(v != '') document.getElementById('recordLength').value = v;\n" \
     "            v = getCookie('sensitivity'); if(v != '') { document.getElementById('sensitivity').value = v; document.getElementById('sensitivityLabel').textContent = sensitivityLabelFromSensitivitySlider(v); }\n" \
     "            v = getCookie('position'); if(v != '') { document.getElementById('position').value = v; document.getElementById('positionLabel').textContent = v;}\n" \
     "            v = getCookie('posTrigger'); if(v == 'true') document.getElementById('posTrigger').checked = true;\n" \
     "            v = getCookie('posTreshold'); if(v != '') { document.getElementById('posTreshold').value = v; document.getElementById('posTriggerLabel').textContent = 'on ' + v; }\n" \
     "            v = getCookie('negTrigger'); if(v == 'true') document.getElementById('negTrigger').checked = true;\n" \
     "            v = getCookie('negTreshold'); if(v != '') { document.getElementById('negTreshold').value = v; document.getElementById('negTriggerLabel').textContent = 'on ' + v; }\n" \
+    "            v = getCookie('preTrigger'); if(v != '') { document.getElementById('preTrigger').value = v; document.getElementById('preTriggerLabel').textContent = v + ' %'; }\n" \
+    "            v = getCookie('triggerMode'); if(v != '') document.getElementById('triggerMode').value = v;\n" \
+    "            v = getCookie('holdoff'); if(v != '') document.getElementById('holdoff').value = v;\n" \
+    "            v = getCookie('triggerType'); if(v != '') document.getElementById('triggerType').value = v;\n" \
+    "            v = getCookie('pulseWidth'); if(v != '') document.getElementById('pulseWidth').value = v;\n" \
+    "            v = getCookie('triggerSource'); if(v != '') document.getElementById('triggerSource').value = v;\n" \
+    "            v = getCookie('triggerGpio'); if(v != '') document.getElementById('triggerGpio').value = v;\n" \
+    "            v = getCookie('hysteresis'); if(v != '') { document.getElementById('hysteresis').value = v; document.getElementById('hysteresisLabel').textContent = v; }\n" \
     "            v = getCookie('frequency'); if(v != '') { document.getElementById('frequency').value = v; document.getElementById('frequencyLabel').textContent = frequencyLabelFromFrequencySlider(v); }\n" \
     "            v = getCookie('lines'); if(v == 'false') document.getElementById('lines').checked = false;\n" \
     "            v = getCookie('markers'); if(v == 'false') document.getElementById('markers').checked = false;\n" \
+    "            v = getCookie('measurements'); if(v == 'true') document.getElementById('measurements').checked = true;\n" \
+    "            v = getCookie('jitter'); if(v == 'true') document.getElementById('jitter').checked = true;\n" \
     "            v = getCookie('remember'); if(v == 'true') document.getElementById('remember').checked = true;\n" \
     "\n" \
     "            enableDisableControls(false);\n" \
@@ -647,39 +924,248 @@
     "                    setCookie('gpio1', document.getElementById('gpio1').value, 3652);\n" \
     "                    setCookie('gpio2', document.getElementById('gpio2').value, 3652);\n" \
     "                    setCookie('analog', document.getElementById('analog').checked, 3652);\n" \
+    "                    setCookie('logic', document.getElementById('logic').checked, 3652);\n" \
+    "                    setCookie('logicGpios', document.getElementById('logicGpios').value, 3652);\n" \
+    "                    setCookie('sampleBits', document.getElementById('sampleBits').value, 3652);\n" \
+    "                    setCookie('analogUnit', document.getElementById('analogUnit').value, 3652);\n" \
+    "                    setCookie('peakDetect', document.getElementById('peakDetect').checked, 3652);\n" \
+    "                    setCookie('acquisition', document.getElementById('acquisition').value, 3652);\n" \
+    "                    setCookie('acquisitionFrames', document.getElementById('acquisitionFrames').value, 3652);\n" \
+    "                    setCookie('spectrumWindow', document.getElementById('spectrumWindow').value, 3652);\n" \
+    "                    setCookie('spectrumAverage', document.getElementById('spectrumAverage').value, 3652);\n" \
+    "                    setCookie('recordLength', document.getElementById('recordLength').value, 3652);\n" \
     "                    setCookie('sensitivity', document.getElementById('sensitivity').value, 3652);\n" \
     "                    setCookie('position', document.getElementById('position').value, 3652);\n" \
     "                    setCookie('posTrigger', document.getElementById('posTrigger').checked, 3652);\n" \
     "                    setCookie('posTreshold', document.getElementById('posTreshold').value, 3652);\n" \
     "                    setCookie('negTrigger', document.getElementById('negTrigger').checked, 3652);\n" \
     "                    setCookie('negTreshold', document.getElementById('negTreshold').value, 3652);\n" \
+    "                    setCookie('preTrigger', document.getElementById('preTrigger').value, 3652);\n" \
+    "                    setCookie('triggerMode', document.getElementById('triggerMode').value, 3652);\n" \
+    "                    setCookie('holdoff', document.getElementById('holdoff').value, 3652);\n" \
+    "                    setCookie('triggerType', document.getElementById('triggerType').value, 3652);\n" \
+    "                    setCookie('pulseWidth', document.getElementById('pulseWidth').value, 3652);\n" \
+    "                    setCookie('triggerSource', document.getElementById('triggerSource').value, 3652);\n" \
+    "                    setCookie('triggerGpio', document.getElementById('triggerGpio').value, 3652);\n" \
+    "                    setCookie('hysteresis', document.getElementById('hysteresis').value, 3652);\n" \
     "                    setCookie('frequency', document.getElementById('frequency').value, 3652);\n" \
     "                    setCookie('lines', document.getElementById('lines').checked, 3652);\n" \
     "                    setCookie('markers', document.getElementById('markers').checked, 3652);\n" \
+    "                    setCookie('measurements', document.getElementById('measurements').checked, 3652);\n" \
+    "                    setCookie('jitter', document.getElementById('jitter').checked, 3652);\n" \
     "                    setCookie('remember', document.getElementById('remember').checked, 3652);\n" \
     "                } else {\n" \
     "                    // delete cookies\n" \
     "                    setCookie('gpio1', '', -1);\n" \
     "                    setCookie('gpio2', '', -1);\n" \
     "                    setCookie('analog', '', -1);\n" \
+    "                    setCookie('logic', '', -1);\n" \
+    "                    setCookie('logicGpios', '', -1);\n" \
+    "                    setCookie('sampleBits', '', -1);\n" \
+    "                    setCookie('analogUnit', '', -1);\n" \
+    "                    setCookie('peakDetect', '', -1);\n" \
+    "                    setCookie('acquisition', '', -1);\n" \
+    "                    setCookie('acquisitionFrames', '', -1);\n" \
+    "                    setCookie('spectrumWindow', '', -1);\n" \
+    "                    setCookie('spectrumAverage', '', -1);\n" \
+    "                    setCookie('recordLength', '', -1);\n" \
     "                    setCookie('sensitivity', '', -1);\n" \
     "                    setCookie('position', '', -1);\n" \
     "                    setCookie('posTrigger', '', -1);\n" \
     "                    setCookie('posTreshold', '', -1);\n" \
     "                    setCookie('negTrigger', '', -1);\n" \
     "                    setCookie('negTreshold', '', -1);\n" \
+    "                    setCookie('preTrigger', '', -1);\n" \
+    "                    setCookie('triggerMode', '', -1);\n" \
+    "                    setCookie('holdoff', '', -1);\n" \
+    "                    setCookie('triggerType', '', -1);\n" \
+    "                    setCookie('pulseWidth', '', -1);\n" \
+    "                    setCookie('triggerSource', '', -1);\n" \
+    "                    setCookie('triggerGpio', '', -1);\n" \
+    "                    setCookie('hysteresis', '', -1);\n" \
     "                    setCookie('frequency', '', -1);\n" \
     "                    setCookie('lines', '', -1);\n" \
     "                    setCookie('markers', '', -1);\n" \
+    "                    setCookie('measurements', '', -1);\n" \
+    "                    setCookie('jitter', '', -1);\n" \
     "                    setCookie('remember', '', -1);\n" \
     "                }\n" \
     "            }\n" \
     "\n" \
     "            var webSocket = null;\n" \
     "\n" \
+    "            // binary control protocol: 4 bytes header(protocol version, opcode, length of parameters) followed by parameters(type, length, value) in browser's byte order,\n" \
+    "            // the upper 2 bits of parameter type tell the size of integers the value is made of: 0x00 = bytes, 0x40 = 16 bit integers, 0x80 = 32 bit integers\n" \
+    "            const OSC_PROTOCOL_VERSION = 1;\n" \
+    "            const OSC_CMD_GET_CAPABILITIES = 1, OSC_CMD_START = 2, OSC_CMD_STOP = 3, OSC_CMD_RECONFIGURE = 4;\n" \
+    "            const OSC_PARAM_READ_TYPE = 0x01, OSC_PARAM_GPIOS = 0x02, OSC_PARAM_TIME_UNIT = 0x03, OSC_PARAM_SAMPLING_TIME = 0x84, OSC_PARAM_SCREEN_WIDTH = 0x85, OSC_PARAM_POSITIVE_TRIGGER = 0x46,\n" \
+    "                  OSC_PARAM_NEGATIVE_TRIGGER = 0x47, OSC_PARAM_PRE_TRIGGER = 0x08, OSC_PARAM_SAMPLE_BITS = 0x09, OSC_PARAM_PEAK_DETECT = 0x0A, OSC_PARAM_RECORD_LENGTH = 0x8B,\n" \
+    "                  OSC_PARAM_TRIGGER_MODE = 0x0C, OSC_PARAM_HOLDOFF = 0x8D, OSC_PARAM_TRIGGER_TYPE = 0x0E, OSC_PARAM_TRIGGER_SOURCE = 0x0F, OSC_PARAM_TRIGGER_GPIO = 0x10,\n" \
+    "                  OSC_PARAM_HYSTERESIS = 0x51, OSC_PARAM_PULSE_WIDTH = 0x92, OSC_PARAM_SPECTRUM_WINDOW = 0x13, OSC_PARAM_SPECTRUM_AVERAGE = 0x14, OSC_PARAM_MEASUREMENTS = 0x15, OSC_PARAM_ACQUISITION = 0x16, OSC_PARAM_ACQUISITION_FRAMES = 0x17, OSC_PARAM_ANALOG_UNIT = 0x18;\n" \
+    "\n" \
+    "            function controlMessage(opcode, parameters) { // parameters = [[type, [values]], ...]\n" \
+    "                var length = 0;\n" \
+    "                for(const [type, values] of parameters) length += 2 + values.length * (1 << (type >> 6));\n" \
+    "                var message = new DataView(new ArrayBuffer(4 + length));\n" \
+    "                var littleEndian = new Uint8Array(new Uint16Array([1]).buffer) [0] == 1; // browser's byte order, ESP32 already knows it from endian identification\n" \
+    "                message.setUint8(0, OSC_PROTOCOL_VERSION);\n" \
+    "                message.setUint8(1, opcode);\n" \
+    "                message.setUint16(2, length, littleEndian);\n" \
+    "                var i = 4;\n" \
+    "                for(const [type, values] of parameters) {\n" \
+    "                    var size = 1 << (type >> 6);\n" \
+    "                    message.setUint8(i ++, type);\n" \
+    "                    message.setUint8(i ++, values.length * size);\n" \
+    "                    for(const v of values) {\n" \
+    "                        if(size == 1)       message.setUint8(i, v);\n" \
+    "                        else if(size == 2)  message.setInt16(i, v, littleEndian);\n" \
+    "                        else                message.setUint32(i, v, littleEndian);\n" \
+    "                        i += size;\n" \
+    "                    }\n" \
+    "                }\n" \
+    "                return message.buffer;\n" \
+    "            }\n" \
+    "\n" \
+    "            // ESP32 capabilities(key: value) as they arrive in the reply to OSC_CMD_GET_CAPABILITIES\n" \
+    "            const OSC_CAP_READERS = 2, OSC_CAP_SAMPLE_FORMATS = 3, OSC_CAP_DEEP_RECORD_MAX_SAMPLES = 11, OSC_CAP_TRIGGER_TYPES = 13, OSC_CAP_FFT_SIZE = 14, OSC_CAP_ADC_CALIBRATION = 15;\n" \
+    "            var capabilities = {};\n" \
+    "\n" \
+    "            // the settings ESP32 is actually using(sampling time and screen width may get corrected) as they arrive in frame -14\n" \
+    "            function receiveSettings(myInt16Array) {\n" \
+    "                var unit = myInt16Array [4] == 1 ? ' ms' : ' us';\n" \
+    "                var samplingTime = (myInt16Array [5] & 0xFFFF) * 65536 + (myInt16Array [6] & 0xFFFF);\n" \
+    "                var screenWidth = (myInt16Array [7] & 0xFFFF) * 65536 + (myInt16Array [8] & 0xFFFF);\n" \
+    "                document.getElementById('frequencyLabel').title = 'sampling every ' + samplingTime + unit + ', screen width = ' + screenWidth + unit;\n" \
+    "            }\n" \
+    "\n" \
+    "            function receiveCapabilities(myInt16Array) {\n" \
+    "                for(var i = 4; i + 2 < myInt16Array.length; i += 3) capabilities [myInt16Array [i]] = (myInt16Array [i + 1] & 0xFFFF) * 65536 + (myInt16Array [i + 2] & 0xFFFF);\n" \
+    "                // disable the settings ESP32 doesn't support\n" \
+    "                for(const o of document.getElementById('sampleBits').options) o.disabled = !(capabilities [OSC_CAP_SAMPLE_FORMATS] & { '16': 1, '12': 2, '8': 4 } [o.value]);\n" \
+    "                for(const o of document.getElementById('recordLength').options) o.disabled = o.value > capabilities [OSC_CAP_DEEP_RECORD_MAX_SAMPLES];\n" \
+    "                for(const o of document.getElementById('triggerType').options) o.disabled = o.value != '0' && !(capabilities [OSC_CAP_TRIGGER_TYPES] & (1 << o.value));\n" \
+    "                for(const o of document.getElementById('spectrumWindow').options) o.disabled = o.value != 'off' && !capabilities [OSC_CAP_FFT_SIZE];\n" \
+    "                for(const o of document.getElementById('acquisition').options) o.disabled = o.value != '0' && !(capabilities [OSC_CAP_READERS] & 0x0008); // I2S reader\n" \
+    "                for(const o of document.getElementById('analogUnit').options) o.disabled = o.value != '0' && !capabilities [OSC_CAP_ADC_CALIBRATION];\n" \
+    "            }\n" \
+    "\n" \
+    "            // analog values in the unit ESP32 sends them, sliders are always set in 0 - 4095 = 0 - 3.3 V\n" \
+    "            function analogValue(v) {\n" \
+    "                return document.getElementById('analogUnit').value == '2' ? Math.round(v * 3300 / 4095) : v;\n" \
+    "            }\n" \
+    "\n" \
+    "            // sampling parameters of OSC_CMD_START and OSC_CMD_RECONFIGURE as they are set in the controls\n" \
+    "            function startParameters() {\n" \
+    "                var gpios = [Number(document.getElementById('gpio1').value)];\n" \
+    "                if(document.getElementById('gpio2').value != 255) gpios.push(Number(document.getElementById('gpio2').value));\n" \
+    "                if(document.getElementById('logic').checked) gpios = logicGpioList().map(Number);\n" \
+    "                var samplingTime, screenWidth, timeUnit; // timeUnit: 0 = us, 1 = ms\n" \
+    "                switch(document.getElementById('frequency').value) {\n" \
+    "\n" \
+    "                    // real sampling times will be passed back to browser in 16 bit integers - take care that values are <= 2^15( = 32767) but it is better to keep it below 5000 to be on the safe side !\n" \
+    "\n" \
+    "                    // please note that oscilloscope reader can put in the output buffer  max 662(I2S analog signal) samples per screen,\n" \
+    "                    //                                                                    max 331(1 signal) samples per screen,\n" \
+    "                    //                                                                    max 220(2 signals) samples per screen\n" \
+    "                    // but the number may be significantly lower if ESP32 can not keep up to required sampling rate\n" \
+    "                    // for orientation, oscilloscope can make 1(1 signal) digital sample roughly every 1.6 us,\n" \
+    "                    //                                        1(2 signals) digital sample roughly every 2.5 us,\n" \
+    "                    //                                        1(1 signal) analog sample roughly every 70 us,\n" \
+    "                    //                                        1(2 signals) analog sample roughly every 150 us,\n" \
+    "                    //                                        max continuous analog sampling(1 signal only) frequency = 150 kHz(1 signal every 6,6 us)\n" \
+    "\n" \
+    "                    // 1 sample at a time mode, measurements in ms, actual sampling rate may be lower than specified here\n" \
+    "\n" \
+    "                    case '1':    // screen width = 10 s => horizontal frequency = 0,1 Hz, max 331(1 signal) samples per screen => sampling interval = 30 ms, sampling frequency = 33 Hz\n" \
+    "                        samplingTime = 30; screenWidth = 10000; timeUnit = 1;\n" \
+    "                        break;\n" \
+    "                    case '2':    // screen width = 5 s => horizontal frequency = 0,2 Hz, max 331(1 signal) samples per screen => sampling interval = 15 ms, sampling frequency = 66 Hz\n" \
+    "                        samplingTime = 15; screenWidth = 5000; timeUnit = 1;\n" \
+    "                        break;\n" \
+    "                    case '3':    // screen width = 2 s => horizontal frequency = 0,5 Hz, max 331(1 signal) samples per screen => sampling interval = 9 ms, sampling frequency = 165 Hz\n" \
+    "                        samplingTime = 6; screenWidth = 2000; timeUnit = 1;\n" \
+    "                        break;\n" \
+    "\n" \
+    "                    // 1 screen at a time mode from now on - measurements in us from now on, actual sampling rate may be lower than specified here\n" \
+    "\n" \
+    "                    case '4':    // screen width = 1 s => horizontal frequency = 1 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 1504 us, sampling frequency = 665 Hz\n" \
+    "                        samplingTime = 1504; screenWidth = 1000000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '5':    // screen width = 500 ms => horizontal frequency = 2 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 752 us, sampling frequency = 1.3 kHz\n" \
+    "                        samplingTime = 752; screenWidth = 500000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '6':    // screen width = 200 ms => horizontal frequency = 5 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 301 us, sampling frequency = 3.3 kHz\n" \
+    "                        samplingTime = 301; screenWidth = 200000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '7':    // screen width = 100 ms => horizontal frequency = 10 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 150 us, sampling frequency = 6.6 kHz\n" \
+    "                        samplingTime = 150; screenWidth = 100000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '8':    // screen width = 50 ms => horizontal frequency = 20 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 75 us, sampling frequency = 13 kHz\n" \
+    "                        samplingTime = 75; screenWidth = 50000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '9':    // screen width = 20 ms => horizontal frequency = 50 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 30 us, sampling frequency = 33 kHz\n" \
+    "                        samplingTime = 30; screenWidth = 20000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '10':    // screen width = 16 ms => horizontal frequency = 60 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 25 us, sampling frequency = 40 kHz\n" \
+    "                        samplingTime = 25; screenWidth = 16667; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '11':    // screen width = 10 ms => horizontal frequency = 100 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 15 us, sampling frequency = 66 kHz\n" \
+    "                        samplingTime = 15; screenWidth = 10000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '12':    // screen width = 5 ms => horizontal frequency = 200 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 7 us, sampling frequency = 140 kHz\n" \
+    "                        samplingTime = 7; screenWidth = 5000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "\n" \
+    "                    // ESP32 can not sample faster than 150 kHz, we can only reduce the number of samples per screen\n" \
+    "\n" \
+    "                    case '13':    // screen width = 2 ms => horizontal frequency = 500 Hz, max 285(1 signal) samples per screen => sampling interval = 9 us, sampling frequency = 140 kHz\n" \
+    "                        samplingTime = 7; screenWidth = 2000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '14':    // screen width = 1 ms => horizontal frequency = 1 kHz, max 142(1 signal) samples per screen => sampling interval = 7 us, sampling frequency = 142 kHz\n" \
+    "                        samplingTime = 7; screenWidth = 1000; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '15':    // screen width = 500 us => horizontal frequency = 2 kHz, max 71 samples per screen => sampling interval = 2 us, sampling frequency = 142 kHz\n" \
+    "                        samplingTime = 7; screenWidth = 500; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '16':    // screen width = 200 us => horizontal frequency = 5 kHz, max 28 samples per screen => sampling interval = 1 us, sampling frequency = 142 kHz\n" \
+    "                        samplingTime = 7; screenWidth = 200; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                    case '17':    // screen width = 100 us => horizontal frequency = 10 kHz, max 14 samples per screen => sampling interval = 1 us, sampling frequency = 142 kHz\n" \
+    "                        samplingTime = 7; screenWidth = 100; timeUnit = 0;\n" \
+    "                        break;\n" \
+    "                }\n" \
+    "                var parameters = [[OSC_PARAM_READ_TYPE, [document.getElementById('logic').checked ? 2 : document.getElementById('analog').checked ? 0 : 1]], [OSC_PARAM_GPIOS, gpios],\n" \
+    "                                  [OSC_PARAM_TIME_UNIT, [timeUnit]], [OSC_PARAM_SAMPLING_TIME, [samplingTime]], [OSC_PARAM_SCREEN_WIDTH, [screenWidth]]];\n" \
+    "                if(document.getElementById('posTrigger').checked) parameters.push([OSC_PARAM_POSITIVE_TRIGGER, [document.getElementById('analog').checked ? analogValue(Number(document.getElementById('posTreshold').value)) : 1]]);\n" \
+    "                if(document.getElementById('negTrigger').checked) parameters.push([OSC_PARAM_NEGATIVE_TRIGGER, [document.getElementById('analog').checked ? analogValue(Number(document.getElementById('negTreshold').value)) : 0]]);\n" \
+    "                if(document.getElementById('posTrigger').checked || document.getElementById('negTrigger').checked) parameters.push([OSC_PARAM_PRE_TRIGGER, [Number(document.getElementById('preTrigger').value)]], [OSC_PARAM_TRIGGER_MODE, [Number(document.getElementById('triggerMode').value)]], [OSC_PARAM_HOLDOFF, [Number(document.getElementById('holdoff').value)]]);\n" \
+    "                if(document.getElementById('posTrigger').checked || document.getElementById('negTrigger').checked) {\n" \
+    "                    var triggerType = Number(document.getElementById('triggerType').value);\n" \
+    "                    parameters.push([OSC_PARAM_TRIGGER_TYPE, [triggerType]], [OSC_PARAM_TRIGGER_SOURCE, [Number(document.getElementById('triggerSource').value)]]);\n" \
+    "                    if(document.getElementById('triggerSource').value == '2') parameters.push([OSC_PARAM_TRIGGER_GPIO, [Number(document.getElementById('triggerGpio').value)]]);\n" \
+    "                    if(document.getElementById('analog').checked) parameters.push([OSC_PARAM_HYSTERESIS, [analogValue(Number(document.getElementById('hysteresis').value))]]);\n" \
+    "                    if(triggerType == 3 || triggerType == 4) parameters.push([OSC_PARAM_PULSE_WIDTH, [Number(document.getElementById('pulseWidth').value)]]);\n" \
+    "                }\n" \
+    "                var spectrum = document.getElementById('analog').checked && document.getElementById('spectrumWindow').value != 'off';\n" \
+    "                if(document.getElementById('analog').checked && document.getElementById('sampleBits').value != '16' && !(spectrum && document.getElementById('sampleBits').value == '12')) parameters.push([OSC_PARAM_SAMPLE_BITS, [Number(document.getElementById('sampleBits').value)]]); // spectrum bins are sent in 16 or 8 bits\n" \
+    "                if(document.getElementById('analog').checked && document.getElementById('analogUnit').value != '0' && !(spectrum && document.getElementById('analogUnit').value == '2')) parameters.push([OSC_PARAM_ANALOG_UNIT, [Number(document.getElementById('analogUnit').value)]]); // spectrum is relative to full scale\n" \
+    "                if(spectrum) parameters.push([OSC_PARAM_SPECTRUM_WINDOW, [Number(document.getElementById('spectrumWindow').value)]], [OSC_PARAM_SPECTRUM_AVERAGE, [Number(document.getElementById('spectrumAverage').value)]]);\n" \
+    "                if(document.getElementById('analog').checked && document.getElementById('peakDetect').checked) parameters.push([OSC_PARAM_PEAK_DETECT, []]);\n" \
+    "                if(document.getElementById('analog').checked && document.getElementById('recordLength').value != '0') parameters.push([OSC_PARAM_RECORD_LENGTH, [Number(document.getElementById('recordLength').value)]]);\n" \
+    "                var acquisition = document.getElementById('analog').checked && timeUnit == 0 && samplingTime <= 1000 && !spectrum && !document.getElementById('peakDetect').checked && document.getElementById('recordLength').value == '0' && document.getElementById('gpio2').value == 255 ? Number(document.getElementById('acquisition').value) : 0;\n" \
+    "                if(acquisition != 0) parameters.push([OSC_PARAM_ACQUISITION, [acquisition]], [OSC_PARAM_ACQUISITION_FRAMES, [Number(document.getElementById('acquisitionFrames').value)]]);\n" \
+    "                if(document.getElementById('measurements').checked && document.getElementById('analog').checked && timeUnit == 0 && !spectrum && document.getElementById('recordLength').value == '0' && acquisition < 2) parameters.push([OSC_PARAM_MEASUREMENTS, []]); // measured on ESP32 over the samples of the screen from the trigger on\n" \
+    "                return parameters;\n" \
+    "            }\n" \
+    "\n" \
+    "            // change timebase or triggers of the running oscilloscope without closing the session, ESP32 acknowledges the new settings with frame -14\n" \
+    "            function reconfigureOscilloscope() {\n" \
+    "                if(webSocket != null && webSocket.readyState == WebSocket.OPEN) webSocket.send(controlMessage(OSC_CMD_RECONFIGURE, startParameters()));\n" \
+    "            }\n" \
+    "\n" \
     "            function stopOscilloscope() {\n" \
     "                if(webSocket != null) {\n" \
-    "                    webSocket.send('stop');\n" \
+    "                    webSocket.send(controlMessage(OSC_CMD_STOP, []));\n" \
     "                    webSocket.close();\n" \
     "                    webSocket = null;\n" \
     "                }\n" \
@@ -687,6 +1173,7 @@
     "\n" \
     "            function startOscilloscope() {\n" \
     "                stopOscilloscope();\n" \
+    "                deepRecord = null;\n" \
     "\n" \
     "                if('WebSocket' in window) {\n" \
     "                    // open a web socket\n" \
@@ -702,86 +1189,11 @@
     "                        endianArray = new Uint16Array(1); endianArray [0] = 0xAABB;\n" \
     "                        ws.send(endianArray);\n" \
     "\n" \
-    "                        // then send start command with sampling parameters\n" \
-    "                        var startCommand = 'start ' +(document.getElementById('analog').checked ? 'analog' : 'digital') + ' sampling on GPIO ' + document.getElementById('gpio1').value +(document.getElementById('gpio2').value == 255 ? '' : ', ' + document.getElementById('gpio2').value) + ' every ';\n" \
-    "                        switch(document.getElementById('frequency').value) {\n" \
-    "\n" \
-    "                            // real sampling times will be passed back to browser in 16 bit integers - take care that values are <= 2^15( = 32767) but it is better to keep it below 5000 to be on the safe side !\n" \
+    "                        // ask ESP32 what it can do, the reply will arrive as frame -13\n" \
+    "                        ws.send(controlMessage(OSC_CMD_GET_CAPABILITIES, []));\n" \
     "\n" \
-    "                            // please note that oscilloscope reader can put in the output buffer  max 666 - 1(I2S analog signal) samples per screen,\n" \
-    "                            //                                                                    max 333 - 1(1 signal) samples per screen,\n" \
-    "                            //                                                                    max 222 - 1(2 signals) samples per screen\n" \
-    "                            // but the number may be significantly lower if ESP32 can not keep up to required sampling rate\n" \
-    "                            // for orientation, oscilloscope can make 1(1 signal) digital sample roughly every 1.6 us,\n" \
-    "                            //                                        1(2 signals) digital sample roughly every 2.5 us,\n" \
-    "                            //                                        1(1 signal) analog sample roughly every 70 us,\n" \
-    "                            //                                        1(2 signals) analog sample roughly every 150 us,\n" \
-    "                            //                                        max continuous analog sampling(1 signal only) frequency = 150 kHz(1 signal every 6,6 us)\n" \
-    "\n" \
-    "                            // 1 sample at a time mode, measurements in ms, actual sampling rate may be lower than specified here\n" \
-    "\n" \
-    "                            case '1':    // screen width = 10 s => horizontal frequency = 0,1 Hz, max 331(1 signal) samples per screen => sampling interval = 30 ms, sampling frequency = 33 Hz\n" \
-    "                                startCommand += '30 ms screen width = 10000 ms';\n" \
-    "                                break;\n" \
-    "                            case '2':    // screen width = 5 s => horizontal frequency = 0,2 Hz, max 331(1 signal) samples per screen => sampling interval = 15 ms, sampling frequency = 66 Hz\n" \
-    "                                startCommand += '15 ms screen width = 5000 ms';\n" \
-    "                                break;\n" \
-    "                            case '3':    // screen width = 2 s => horizontal frequency = 0,5 Hz, max 331(1 signal) samples per screen => sampling interval = 9 ms, sampling frequency = 165 Hz\n" \
-    "                                startCommand += '6 ms screen width = 2000 ms';\n" \
-    "                                break;\n" \
-    "\n" \
-    "                            // 1 screen at a time mode from now on - measurements in us from now on, actual sampling rate may be lower than specified here\n" \
-    "\n" \
-    "                            case '4':    // screen width = 1 s => horizontal frequency = 1 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 1504 us, sampling frequency = 665 Hz\n" \
-    "                                startCommand += '1504 us screen width = 1000000 us';\n" \
-    "                                break;\n" \
-    "                            case '5':    // screen width = 500 ms => horizontal frequency = 2 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 752 us, sampling frequency = 1.3 kHz\n" \
-    "                                startCommand += '752 us screen width = 500000 us';\n" \
-    "                                break;\n" \
-    "                            case '6':    // screen width = 200 ms => horizontal frequency = 5 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 301 us, sampling frequency = 3.3 kHz\n" \
-    "                                startCommand += '301 us screen width = 200000 us';\n" \
-    "                                break;\n" \
-    "                            case '7':    // screen width = 100 ms => horizontal frequency = 10 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 150 us, sampling frequency = 6.6 kHz\n" \
-    "                                startCommand += '150 us screen width = 100000 us';\n" \
-    "                                break;\n" \
-    "                            case '8':    // screen width = 50 ms => horizontal frequency = 20 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 75 us, sampling frequency = 13 kHz\n" \
-    "                                startCommand += '75 us screen width = 50000 us';\n" \
-    "                                break;\n" \
-    "                            case '9':    // screen width = 20 ms => horizontal frequency = 50 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 30 us, sampling frequency = 33 kHz\n" \
-    "                                startCommand += '30 us screen width = 20000 us';\n" \
-    "                                break;\n" \
-    "                            case '10':    // screen width = 16 ms => horizontal frequency = 60 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 25 us, sampling frequency = 40 kHz\n" \
-    "                                startCommand += '25 us screen width = 16667 us';\n" \
-    "                                break;\n" \
-    "                            case '11':    // screen width = 10 ms => horizontal frequency = 100 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 15 us, sampling frequency = 66 kHz\n" \
-    "                                startCommand += '15 us screen width = 10000 us';\n" \
-    "                                break;\n" \
-    "                            case '12':    // screen width = 5 ms => horizontal frequency = 200 Hz, max 665(1 I2S signal) samples per screen => sampling interval = 7 us, sampling frequency = 140 kHz\n" \
-    "                                startCommand += '7 us screen width = 5000 us';\n" \
-    "                                break;\n" \
-    "\n" \
-    "                            // ESP32 can not sample faster than 150 kHz, we can only reduce the number of samples per screen\n" \
-    "\n" \
-    "                            case '13':    // screen width = 2 ms => horizontal frequency = 500 Hz, max 285(1 signal) samples per screen => sampling interval = 9 us, sampling frequency = 140 kHz\n" \
-    "                                startCommand += '7 us screen width = 2000 us';\n" \
-    "                                break;\n" \
-    "                            case '14':    // screen width = 1 ms => horizontal frequency = 1 kHz, max 142(1 signal) samples per screen => sampling interval = 7 us, sampling frequency = 142 kHz\n" \
-    "                                startCommand += '7 us screen width = 1000 us';\n" \
-    "                                break;\n" \
-    "                            case '15':    // screen width = 500 us => horizontal frequency = 2 kHz, max 71 samples per screen => sampling interval = 2 us, sampling frequency = 142 kHz\n" \
-    "                                startCommand += '7 us screen width = 500 us';\n" \
-    "                                break;\n" \
-    "                            case '16':    // screen width = 200 us => horizontal frequency = 5 kHz, max 28 samples per screen => sampling interval = 1 us, sampling frequency = 142 kHz\n" \
-    "                                startCommand += '7 us screen width = 200 us';\n" \
-    "                                break;\n" \
-    "                            case '17':    // screen width = 100 us => horizontal frequency = 10 kHz, max 14 samples per screen => sampling interval = 1 us, sampling frequency = 142 kHz\n" \
-    "                                startCommand += '7 us screen width = 100 us';\n" \
-    "                                break;\n" \
-    "                        }\n" \
-    "                        if(document.getElementById('posTrigger').checked) startCommand += ' set positive slope trigger to ' +(document.getElementById('analog').checked ? document.getElementById('posTreshold').value : 1);\n" \
-    "                        if(document.getElementById('negTrigger').checked) startCommand += ' set negative slope trigger to ' +(document.getElementById('analog').checked ? document.getElementById('negTreshold').value : 0);\n" \
-    "\n" \
-    "                        ws.send(startCommand);\n" \
+    "                        // then send start command with sampling parameters\n" \
+    "                        ws.send(controlMessage(OSC_CMD_START, startParameters()));\n" \
     "                    };\n" \
     "\n" \
     "                    ws.onmessage = function(evt) {\n" \
@@ -797,8 +1209,8 @@
     "                            var myFileReader = new FileReader();\n" \
     "                            myFileReader.onload = function(event) {\n" \
     "                                myArrayBuffer = event.target.result;\n" \
-    "                                myInt16Array = new Int16Array(myArrayBuffer);\n" \
-    "                                drawSignal(myInt16Array, 0, myInt16Array.length - 1);\n" \
+    "                                myInt16Array = new Int16Array(myArrayBuffer, 0, myArrayBuffer.byteLength >> 1); // logic analyzer frames with 1 byte samples may have odd length\n" \
+    "                                drawFrame(myInt16Array);\n" \
     "                            };\n" \
     "                            myFileReader.readAsArrayBuffer(evt.data);\n" \
     "                        }\n" \
@@ -827,12 +1239,19 @@
     "            var continuousSamplingTime; // only when continuous sampliong takes place\n" \
     "            var restartDrawingSignal;   // used for drawing the signal\n" \
     "            var screenTimeOffset;       // used for drawing the signal\n" \
+    "            var triggerShift = 0;       // the trace is shifted by the time the treshold has been crossed before the trigger sample, so repetitive signals stay steady\n" \
     "\n" \
     "            var xOffset;\n" \
     "            var xScale;\n" \
     "            var yOffset;\n" \
     "            var yScale;\n" \
     "            var yLast;\n" \
+    "            var logicLaneHeight;        // logic analyzer draws each signal in its own lane\n" \
+    "\n" \
+    "            // GPIOs that logic analyzer takes samples of, bit i of each sample belongs to the i-th GPIO in the list\n" \
+    "            function logicGpioList() {\n" \
+    "                return document.getElementById('logicGpios').value.split(',').map(g => g.trim()).filter(g => g != '');\n" \
+    "            }\n" \
     "\n" \
     "            function drawBackgroundAndCalculateParameters() {\n" \
     "\n" \
@@ -877,7 +1296,8 @@
     "\n" \
     "                    // signal sensitivity\n" \
     "\n" \
-    "                    yScale = -(canvas.height - 60) / 4096;\n" \
+    "                    var fullScale = document.getElementById('analogUnit').value == '2' ? 3300 : 4095; // in mV or ADC values\n" \
+    "                    yScale = -(canvas.height - 60) /(fullScale + 1);\n" \
     "                    yGridTick = 1000;\n" \
     "\n" \
     "                    switch(document.getElementById('sensitivity').value) {\n" \
@@ -890,11 +1310,11 @@
     "                    }\n" \
     "\n" \
     "                    yOffset = canvas.height - 50 - parseInt(document.getElementById('position').value) * yScale;\n" \
-    "                    gridTop = yOffset + yScale * 4095 + 5;\n" \
+    "                    gridTop = yOffset + yScale * fullScale + 5;\n" \
     "\n" \
     "                    // draw horizontal grid and scale\n" \
     "\n" \
-    "                    for(y = 0; y < 4096; y += yGridTick) {\n" \
+    "                    for(y = 0; y <= fullScale; y += yGridTick) {\n" \
     "                        j = yOffset + yScale * y;\n" \
     "                        ctx.strokeText(y.toString(), 5, j + 5);\n" \
     "                        ctx.beginPath();\n" \
@@ -903,6 +1323,22 @@
     "                        ctx.stroke();\n" \
     "                    }\n" \
     "\n" \
+    "                // draw logic analyzer grid, the first signal is at the bottom\n" \
+    "                } else if(document.getElementById('logic').checked) {\n" \
+    "                    var gpios = logicGpioList();\n" \
+    "                    logicLaneHeight =(canvas.height - 60) / Math.max(gpios.length, 1);\n" \
+    "                    yOffset = canvas.height - 50;\n" \
+    "                    yScale = -logicLaneHeight * 0.7;\n" \
+    "                    for(var k = 0; k < gpios.length; k++) {\n" \
+    "                        j = yOffset - k * logicLaneHeight;\n" \
+    "                        ctx.beginPath();\n" \
+    "                        ctx.moveTo(xOffset - 5, j);\n" \
+    "                        ctx.lineTo(canvas.width, j);\n" \
+    "                        ctx.stroke();\n" \
+    "                        ctx.strokeText(gpios [k], 5, j + yScale / 2 + 5);\n" \
+    "                    }\n" \
+    "                    gridTop = yOffset - gpios.length * logicLaneHeight + 5;\n" \
+    "\n" \
     "                // draw digital signal grid\n" \
     "                } else {\n" \
     "                    yOffset = canvas.height - 100;\n" \
@@ -1021,6 +1457,8 @@
     "                    ctx.stroke();\n" \
     "                }\n" \
     "                ctx.textAlign = 'left';\n" \
+    "\n" \
+    "                if(document.getElementById('jitter').checked) drawJitter();\n" \
     "            }\n" \
     "\n" \
     "            drawBackgroundAndCalculateParameters();\n" \
@@ -1029,32 +1467,125 @@
     "            var lastJ1; // signal 1\n" \
     "            var lastJ2; // signal 2\n" \
     "\n" \
-    "            var wordsPerSample = 1; // will be correctly initialized when dummy sample arrives: 2 for 1 signal, 3 for 2 signals\n" \
+    "            var wordsPerSample = 1; // will be correctly initialized when frame header arrives: 1 for continuous sampling, 2 for 1 signal, 3 for 2 signals\n" \
     "\n" \
-    "            function drawSignal(myInt16Array, startInd, endInd) {\n" \
-    "                if(startInd > endInd) return;\n" \
+    "            // each frame starts with 4 words header: frame type, sampling time (continuous sampling only), trigger position (-1 if none) and flags\n" \
+    "            function drawFrame(myInt16Array) {\n" \
+    "                if(myInt16Array.length < 4) return;\n" \
     "\n" \
-    "                // find dummy sample(the one with value < 0) which will tells javascript client to start drawing from beginning of the screen\n" \
-    "                for(var ind = startInd; ind <= endInd; ind += wordsPerSample) {\n" \
-    "                    if(myInt16Array [ind] < 0) { // if signal value < 0 this is a dummy value which also holds the information about how numbers are stored in the buffer\n" \
-    "                        switch(myInt16Array [ind]) {\n" \
-    "                            case -2:    wordsPerSample = 2;                             // 1 signal(analog or digital) with deltaTime\n" \
-    "                                        continuousSamplingTime = 0;                     // actual sampling wil be provided in the buffer\n" \
-    "                                        break;\n" \
-    "                            case -3:    wordsPerSample = 3;                             // 2 signals(analog or digital) with deltaTime\n" \
-    "                                        continuousSamplingTime = 0;                     // actual sampling wil be provided in the buffer\n" \
-    "                                        break;\n" \
-    "                            default:    // < 0                                          // continuous(analog) sampling\n" \
-    "                                        wordsPerSample = 1;\n" \
-    "                                        continuousSamplingTime = -myInt16Array [ind];   // sampling time is provided in the dummy sample\n" \
-    "                                        screenTimeOffset = -continuousSamplingTime;     // so that the first real continuous sample will start at 0\n" \
-    "                        }\n" \
-    "                        drawSignal(myInt16Array, startInd, ind - wordsPerSample); // to previuos sample\n" \
-    "                        drawBackgroundAndCalculateParameters();\n" \
-    "                        drawSignal(myInt16Array, ind + wordsPerSample, endInd); // from next sample on\n" \
-    "                        return;\n" \
+    "                switch(myInt16Array [0]) {\n" \
+    "                    case -2:    wordsPerSample = 2;                             // 1 signal(analog or digital) with deltaTime\n" \
+    "                                continuousSamplingTime = 0;                     // actual sampling wil be provided in the buffer\n" \
+    "                                break;\n" \
+    "                    case -3:    wordsPerSample = 3;                             // 2 signals(analog or digital) with deltaTime\n" \
+    "                                continuousSamplingTime = 0;                     // actual sampling wil be provided in the buffer\n" \
+    "                                break;\n" \
+    "                    case -8:                                                    // continuous(analog) sampling, 2 samples packed into 3 bytes\n" \
+    "                    case -9:                                                    // continuous(analog) sampling, upper 8 bits of each sample\n" \
+    "                                wordsPerSample = 1;\n" \
+    "                                continuousSamplingTime = myInt16Array [1];      // sampling time is provided in the header\n" \
+    "                                myInt16Array = unpackSamples(myInt16Array);\n" \
+    "                                break;\n" \
+    "                    case -7:                                                    // 1 or 2 digital signals, only transitions with levels(bit 0 = signal 1, bit 1 = signal 2) and deltaTime\n" \
+    "                                wordsPerSample = document.getElementById('gpio2').value == 255 ? 2 : 3;\n" \
+    "                                continuousSamplingTime = 0;                     // actual sampling wil be provided in the buffer\n" \
+    "                                myInt16Array = transitionsToSamples(myInt16Array, wordsPerSample); // draw transitions the same way as the samples\n" \
+    "                                break;\n" \
+    "                    case -10:                                                   // 1 analog signal(min, max) with deltaTime\n" \
+    "                    case -11:                                                   // 2 analog signals(min, max) with deltaTime\n" \
+    "                                wordsPerSample = myInt16Array [0] == -10 ? 3 : 5;\n" \
+    "                                continuousSamplingTime = 0;                     // actual sampling wil be provided in the buffer\n" \
+    "                                drawBackgroundAndCalculateParameters();\n" \
+    "                                drawMinMaxSignals(myInt16Array, myInt16Array [2] >= 0 ? 4 + myInt16Array [2] * wordsPerSample : -1);\n" \
+    "                                return;\n" \
+    "                    case -12:                                                   // one fragment of deep record(1 analog signal sampled continuously)\n" \
+    "                                receiveDeepRecordFragment(myInt16Array);\n" \
+    "                                return;\n" \
+    "                    case -13:                                                   // ESP32 capabilities\n" \
+    "                                receiveCapabilities(myInt16Array);\n" \
+    "                                return;\n" \
+    "                    case -14:                                                   // settings ESP32 is actually using\n" \
+    "                                receiveSettings(myInt16Array);\n" \
+    "                                return;\n" \
+    "                    case -15:                                                   // spectrum, frequency bins in 1/100 dB\n" \
+    "                    case -16:                                                   // spectrum, frequency bins in 0.5 dB steps below full scale\n" \
+    "                                drawSpectrum(myInt16Array);\n" \
+    "                                return;\n" \
+    "                    case -18:                                                   // continuous(analog) sampling,(min, max) of each sample over more screens\n" \
+    "                                wordsPerSample = 3;\n" \
+    "                                continuousSamplingTime = 0;                     // drawn the same way as(min, max) samples with deltaTime\n" \
+    "                                myInt16Array = envelopeToMinMaxSamples(myInt16Array);\n" \
+    "                                drawBackgroundAndCalculateParameters();\n" \
+    "                                drawMinMaxSignals(myInt16Array, myInt16Array [2] >= 0 ? 4 + myInt16Array [2] * wordsPerSample : -1);\n" \
+    "                                return;\n" \
+    "                    case -17:                                                   // measurements of the screen that has just been drawn\n" \
+    "                                drawMeasurements(myInt16Array);\n" \
+    "                                return;\n" \
+    "                    case -5:                                                    // logic analyzer, up to 8 signals in 1 byte per sample\n" \
+    "                    case -6:                                                    // logic analyzer, up to 16 signals in 2 bytes per sample\n" \
+    "                                continuousSamplingTime = myInt16Array [1];      // sampling time is provided in the header, in us or in ms (flag 0x0004)\n" \
+    "                                var screenInMilliseconds = Number(document.getElementById('frequency').value) <= 3; // the same condition as timeUnit = 1 in startParameters\n" \
+    "                                if((myInt16Array [3] & 0x0004) && !screenInMilliseconds) continuousSamplingTime *= 1000;\n" \
+    "                                if(!(myInt16Array [3] & 0x0004) && screenInMilliseconds) continuousSamplingTime /= 1000;\n" \
+    "                                drawBackgroundAndCalculateParameters();\n" \
+    "                                drawLogicSignals(myInt16Array [0] == -5 ? new Uint8Array(myInt16Array.buffer, 8) : new Uint16Array(myInt16Array.buffer, 8, myInt16Array.length - 4), myInt16Array [2]);\n" \
+    "                                return;\n" \
+    "                    default:    // -4                                           // continuous(analog) sampling\n" \
+    "                                wordsPerSample = 1;\n" \
+    "                                continuousSamplingTime = myInt16Array [1];      // sampling time is provided in the header\n" \
+    "                }\n" \
+    "                if(!(myInt16Array [3] & 0x0001)) drawBackgroundAndCalculateParameters(); // unless the frame continues the previous one, start drawing from the left of the screen\n" \
+    "                triggerShift = 0;\n" \
+    "                if(myInt16Array [2] >= 0) { // the upper byte of flags tells how far(in 1/256 of the interval before the trigger sample) the treshold has been crossed before the trigger sample\n" \
+    "                    var interval = continuousSamplingTime != 0 ? continuousSamplingTime : myInt16Array [4 + myInt16Array [2] * wordsPerSample + wordsPerSample - 1];\n" \
+    "                    triggerShift =((myInt16Array [3] >> 8) & 0xFF) / 256 * interval;\n" \
+    "                    screenTimeOffset += triggerShift;\n" \
+    "                }\n" \
+    "                drawSignal(myInt16Array, 4, myInt16Array.length - 1, myInt16Array [2] >= 0 ? 4 + myInt16Array [2] * wordsPerSample : -1);\n" \
+    "            }\n" \
+    "\n" \
+    "            // unpack 12 or 8 bit samples into 16 bit samples, the header stays the same\n" \
+    "            function unpackSamples(myInt16Array) {\n" \
+    "                var bytes = new Uint8Array(myInt16Array.buffer, 8);\n" \
+    "                var count = myInt16Array [0] == -9 ? bytes.length : Math.floor(bytes.length / 3) * 2 +(bytes.length % 3 == 2 ? 1 : 0); // with odd number of samples the last one takes 2 bytes\n" \
+    "                var samples = new Int16Array(4 + count);\n" \
+    "                samples.set(myInt16Array.subarray(0, 4));\n" \
+    "                if(myInt16Array [0] == -9) {\n" \
+    "                    for(var k = 0; k < count; k++) samples [4 + k] = bytes [k] << 4;\n" \
+    "                } else {\n" \
+    "                    for(var k = 0, b = 0; k < count; k += 2, b += 3) {\n" \
+    "                        samples [4 + k] = bytes [b] |((bytes [b + 1] & 0x0F) << 8);\n" \
+    "                        if(k + 1 < count) samples [5 + k] =(bytes [b + 1] >> 4) |(bytes [b + 2] << 4);\n" \
     "                    }\n" \
     "                }\n" \
+    "                return samples;\n" \
+    "            }\n" \
+    "\n" \
+    "            // unpack transitions into the samples with 1 or 2 signals and deltaTime, the header stays the same\n" \
+    "            function transitionsToSamples(myInt16Array, wordsPerSample) {\n" \
+    "                var samples = new Int16Array(4 +(myInt16Array.length - 4) / 2 * wordsPerSample);\n" \
+    "                samples.set(myInt16Array.subarray(0, 4));\n" \
+    "                for(var t = 4, ind = 4; t + 1 < myInt16Array.length; t += 2, ind += wordsPerSample) {\n" \
+    "                    samples [ind] = myInt16Array [t] & 1;                                   // signal 1\n" \
+    "                    if(wordsPerSample == 3) samples [ind + 1] =(myInt16Array [t] >> 1) & 1; // signal 2\n" \
+    "                    samples [ind + wordsPerSample - 1] = myInt16Array [t + 1];              // deltaTime\n" \
+    "                }\n" \
+    "                return samples;\n" \
+    "            }\n" \
+    "\n" \
+    "            function envelopeToMinMaxSamples(myInt16Array) {\n" \
+    "                var samples = new Int16Array(4 +(myInt16Array.length - 4) / 2 * 3);\n" \
+    "                samples.set(myInt16Array.subarray(0, 4));\n" \
+    "                for(var t = 4, ind = 4; t + 1 < myInt16Array.length; t += 2, ind += 3) {\n" \
+    "                    samples [ind] = myInt16Array [t];                                           // min\n" \
+    "                    samples [ind + 1] = myInt16Array [t + 1];                                   // max\n" \
+    "                    samples [ind + 2] = ind == 4 ? 0 : myInt16Array [1];                        // deltaTime, the pairs are equally spaced\n" \
+    "                }\n" \
+    "                return samples;\n" \
+    "            }\n" \
+    "\n" \
+    "            function drawSignal(myInt16Array, startInd, endInd, triggerInd) {\n" \
+    "                if(startInd > endInd) return;\n" \
     "\n" \
     "                var canvas = document.getElementById('oscilloscope');\n" \
     "                var ctx = canvas.getContext('2d');\n" \
@@ -1134,28 +1665,346 @@
     "                        ctx.stroke();\n" \
     "                    }\n" \
     "\n" \
+    "                    // trigger position\n" \
+    "                    if(ind == triggerInd) drawTriggerPosition(i - xScale * triggerShift); // at the treshold crossing\n" \
+    "\n" \
     "                    lastI = i;\n" \
     "                    lastJ1 = j1;\n" \
     "                    lastJ2 = j2;\n" \
     "                }\n" \
     "            }\n" \
     "\n" \
+    "            // each sample is drawn as a vertical bar from min to max value, so the peaks between the samples are visible as well\n" \
+    "            function drawMinMaxSignals(myInt16Array, triggerInd) {\n" \
+    "                var canvas = document.getElementById('oscilloscope');\n" \
+    "                var ctx = canvas.getContext('2d');\n" \
+    "\n" \
+    "                var signals = wordsPerSample == 3 ? 1 : 2;\n" \
+    "                var lines = document.getElementById('lines').checked;\n" \
+    "                var lastMinJ = [], lastMaxJ = [];\n" \
+    "\n" \
+    "                ctx.lineWidth = 2;\n" \
+    "\n" \
+    "                for(var ind = 4; ind + wordsPerSample <= myInt16Array.length; ind += wordsPerSample) {\n" \
+    "                    screenTimeOffset += myInt16Array [ind + wordsPerSample - 1]; // deltaTime is provided in the buffer\n" \
+    "                    i = xOffset + xScale * screenTimeOffset;\n" \
+    "\n" \
+    "                    for(var k = signals - 1; k >= 0; k--) {\n" \
+    "                        var minJ = yOffset + yScale * myInt16Array [ind + 2 * k];\n" \
+    "                        var maxJ = yOffset + yScale * myInt16Array [ind + 2 * k + 1];\n" \
+    "                        ctx.strokeStyle = k ? '#ff8000' : '#ffbf80';\n" \
+    "                        ctx.beginPath();\n" \
+    "                        if(lines && !restartDrawingSignal) {\n" \
+    "                            ctx.moveTo(lastI, lastMinJ [k]);\n" \
+    "                            ctx.lineTo(i, minJ);\n" \
+    "                            ctx.moveTo(lastI, lastMaxJ [k]);\n" \
+    "                            ctx.lineTo(i, maxJ);\n" \
+    "                        }\n" \
+    "                        ctx.moveTo(i, minJ);\n" \
+    "                        ctx.lineTo(i, maxJ - 1); // at least 1 pixel even if min == max\n" \
+    "                        ctx.stroke();\n" \
+    "                        lastMinJ [k] = minJ;\n" \
+    "                        lastMaxJ [k] = maxJ;\n" \
+    "                    }\n" \
+    "                    restartDrawingSignal = false;\n" \
+    "\n" \
+    "                    // trigger position\n" \
+    "                    if(ind == triggerInd) drawTriggerPosition(i);\n" \
+    "\n" \
+    "                    lastI = i;\n" \
+    "                }\n" \
+    "            }\n" \
+    "\n" \
+    "            var deepRecord = null;          // samples of deep record, put together from the fragments as they arrive\n" \
+    "            var deepRecordLength = 0;       // number of samples received so far\n" \
+    "            var deepRecordFragmentSize;     // number of samples in each fragment but the last one\n" \
+    "            var deepRecordSamplingTime;     // in us\n" \
+    "            var deepRecordTrigger = -1;     // index of the first sample after the trigger condition occured, -1 if there is no trigger in the record\n" \
+    "\n" \
+    "            // each fragment starts with 4 words after the frame header: fragment number, number of fragments, fragment with trigger(0xFFFF if none) and trigger position in this fragment\n" \
+    "            function receiveDeepRecordFragment(myInt16Array) {\n" \
+    "                if(myInt16Array.length < 8) return;\n" \
+    "                var fragmentHeader = new Uint16Array(myInt16Array.buffer, 8, 4);\n" \
+    "                var samples = myInt16Array.subarray(8);\n" \
+    "\n" \
+    "                if(fragmentHeader [0] == 0) { // the first fragment\n" \
+    "                    deepRecordFragmentSize = samples.length;\n" \
+    "                    deepRecord = new Int16Array(fragmentHeader [1] * deepRecordFragmentSize);\n" \
+    "                    deepRecordSamplingTime = myInt16Array [1];\n" \
+    "                    deepRecordTrigger = fragmentHeader [2] == 0xFFFF ? -1 : fragmentHeader [2] * deepRecordFragmentSize + fragmentHeader [3];\n" \
+    "                }\n" \
+    "                if(deepRecord == null) return;\n" \
+    "                deepRecord.set(samples, fragmentHeader [0] * deepRecordFragmentSize);\n" \
+    "                deepRecordLength = fragmentHeader [0] * deepRecordFragmentSize + samples.length;\n" \
+    "\n" \
+    "                if(fragmentHeader [0] + 1 < fragmentHeader [1]) { // show the progress\n" \
+    "                    var percent = Math.floor(100 *(fragmentHeader [0] + 1) / fragmentHeader [1]);\n" \
+    "                    if(percent != Math.floor(100 * fragmentHeader [0] / fragmentHeader [1])) {\n" \
+    "                        drawBackgroundAndCalculateParameters();\n" \
+    "                        var ctx = document.getElementById('oscilloscope').getContext('2d');\n" \
+    "                        ctx.strokeStyle = '#ffbf80';\n" \
+    "                        ctx.strokeText('receiving record ' + percent + ' %', xOffset + 10, 30);\n" \
+    "                    }\n" \
+    "                    return;\n" \
+    "                }\n" \
+    "\n" \
+    "                // the whole record has arrived, ESP32 takes only one record at a time\n" \
+    "                stopOscilloscope();\n" \
+    "                enableDisableControls(false);\n" \
+    "                drawDeepRecord();\n" \
+    "            }\n" \
+    "\n" \
+    "            function timeLabel(us) {\n" \
+    "                if(us < 1000) return us + ' us';\n" \
+    "                if(us < 1000000) return(us / 1000).toFixed(1) + ' ms';\n" \
+    "                return(us / 1000000).toFixed(2) + ' s';\n" \
+    "            }\n" \
+    "\n" \
+    "            // draw the part of deep record selected by Zoom and Position, if there are more samples than pixels each column shows min and max value of its samples\n" \
+    "            function drawDeepRecord() {\n" \
+    "                if(deepRecord == null || deepRecordLength < 2) return;\n" \
+    "\n" \
+    "                drawBackgroundAndCalculateParameters();\n" \
+    "                var canvas = document.getElementById('oscilloscope');\n" \
+    "                var ctx = canvas.getContext('2d');\n" \
+    "\n" \
+    "                var windowLength = Math.max(Math.floor(deepRecordLength /(1 << document.getElementById('recordZoom').value)), 2);\n" \
+    "                var first = Math.floor((deepRecordLength - windowLength) * document.getElementById('recordPosition').value / 100);\n" \
+    "                var samplesPerColumn = windowLength /(canvas.width - xOffset);\n" \
+    "\n" \
+    "                ctx.strokeStyle = '#ffbf80';\n" \
+    "                ctx.strokeText('record ' + timeLabel(deepRecordLength * deepRecordSamplingTime) + ', showing ' + timeLabel(windowLength * deepRecordSamplingTime) + ' from ' + timeLabel(first * deepRecordSamplingTime), xOffset + 10, 30);\n" \
+    "\n" \
+    "                ctx.lineWidth = 2;\n" \
+    "                ctx.beginPath();\n" \
+    "                if(samplesPerColumn <= 1) {\n" \
+    "                    for(var k = 0; k < windowLength; k++) {\n" \
+    "                        i = xOffset + k / samplesPerColumn;\n" \
+    "                        j1 = yOffset + yScale * deepRecord [first + k];\n" \
+    "                        if(k == 0) ctx.moveTo(i, j1); else ctx.lineTo(i, j1);\n" \
+    "                    }\n" \
+    "                } else {\n" \
+    "                    for(var c = 0; c < canvas.width - xOffset; c++) {\n" \
+    "                        var from = first + Math.floor(c * samplesPerColumn);\n" \
+    "                        var to = Math.min(first + Math.floor((c + 1) * samplesPerColumn), first + windowLength);\n" \
+    "                        var min = deepRecord [from], max = deepRecord [from];\n" \
+    "                        for(var k = from + 1; k < to; k++) { if(deepRecord [k] < min) min = deepRecord [k]; if(deepRecord [k] > max) max = deepRecord [k]; }\n" \
+    "                        ctx.moveTo(xOffset + c, yOffset + yScale * min);\n" \
+    "                        ctx.lineTo(xOffset + c, yOffset + yScale * max - 1); // at least 1 pixel even if min == max\n" \
+    "                    }\n" \
+    "                }\n" \
+    "                ctx.stroke();\n" \
+    "\n" \
+    "                // trigger position\n" \
+    "                if(deepRecordTrigger >= first && deepRecordTrigger < first + windowLength) drawTriggerPosition(xOffset +(deepRecordTrigger - first) / samplesPerColumn);\n" \
+    "            }\n" \
+    "\n" \
+    "            function frequencyLabel(hz) {\n" \
+    "                if(hz < 1000) return Math.round(hz) + ' Hz';\n" \
+    "                return(hz / 1000).toFixed(1) + ' kHz';\n" \
+    "            }\n" \
+    "\n" \
+    "            // frequency bins from 0 to half of the sampling frequency(sampling time is in the header), 0 dB is full scale sine\n" \
+    "            function drawSpectrum(myInt16Array) {\n" \
+    "                var bins = myInt16Array [0] == -15 ? myInt16Array.subarray(4) : new Uint8Array(myInt16Array.buffer, 8);\n" \
+    "                var maxFrequency = 500000 / myInt16Array [1]; // in Hz\n" \
+    "                if(bins.length < 2) return;\n" \
+    "\n" \
+    "                resizeCanvas();\n" \
+    "                var canvas = document.getElementById('oscilloscope');\n" \
+    "                var ctx = canvas.getContext('2d');\n" \
+    "                ctx.clearRect(0, 0, canvas.width, canvas.height);\n" \
+    "                ctx.fillStyle = 'hsl(82, 90%, 10%)';\n" \
+    "                ctx.fillRect(0, 0, canvas.width, canvas.height);\n" \
+    "\n" \
+    "                // dB grid and frequency grid\n" \
+    "                var i, j;\n" \
+    "                var left = 50, top = 10, bottom = canvas.height - 50;\n" \
+    "                var dBScale =(bottom - top) / 120; // from 0 dB down to -120 dB\n" \
+    "                ctx.strokeStyle = 'hsl(82, 90%, 40%)';\n" \
+    "                ctx.lineWidth = 1;\n" \
+    "                ctx.font = '16px Verdana';\n" \
+    "                for(var d = 0; d >= -120; d -= 20) {\n" \
+    "                    j = top - d * dBScale;\n" \
+    "                    ctx.strokeText(d.toString(), 5, j + 5);\n" \
+    "                    ctx.beginPath();\n" \
+    "                    ctx.moveTo(left - 5, j);\n" \
+    "                    ctx.lineTo(canvas.width, j);\n" \
+    "                    ctx.stroke();\n" \
+    "                }\n" \
+    "                ctx.font = canvas.width < 500 ? '10px Verdana' : canvas.width < 800 ? '14px Verdana' : '16px Verdana';\n" \
+    "                ctx.textAlign = 'center';\n" \
+    "                for(var f = 0; f < 10; f++) {\n" \
+    "                    i = left +(canvas.width - left) * f / 10;\n" \
+    "                    if(f % 2 == 0) ctx.strokeText(frequencyLabel(maxFrequency * f / 10), i, bottom + 25);\n" \
+    "                    ctx.beginPath();\n" \
+    "                    ctx.moveTo(i, bottom + 5);\n" \
+    "                    ctx.lineTo(i, top);\n" \
+    "                    ctx.stroke();\n" \
+    "                }\n" \
+    "                ctx.textAlign = 'left';\n" \
+    "                ctx.strokeStyle = '#ffbf80';\n" \
+    "                ctx.strokeText('bin width ' + frequencyLabel(maxFrequency / bins.length), left + 10, top + 20);\n" \
+    "\n" \
+    "                // bins\n" \
+    "                ctx.lineWidth = 2;\n" \
+    "                ctx.beginPath();\n" \
+    "                for(var k = 0; k < bins.length; k++) {\n" \
+    "                    var dB = myInt16Array [0] == -15 ? bins [k] / 100 : -bins [k] / 2;\n" \
+    "                    i = left +(canvas.width - left) * k / bins.length;\n" \
+    "                    j = top - Math.min(Math.max(dB, -120), 0) * dBScale;\n" \
+    "                    if(k == 0) ctx.moveTo(i, j); else ctx.lineTo(i, j);\n" \
+    "                }\n" \
+    "                ctx.stroke();\n" \
+    "            }\n" \
+    "\n" \
+    "            // sampling jitter statistics of ESP32, fetched once per second while Sampling jitter is checked and oscilloscope is running\n" \
+    "            var jitterStatistics = null;\n" \
+    "            setInterval(function() {\n" \
+    "                if(!document.getElementById('jitter').checked || webSocket == null) { jitterStatistics = null; return; }\n" \
+    "                fetch('/oscilloscope/jitter').then(response => response.json()).then(json => { jitterStatistics = json; }).catch(() => { jitterStatistics = null; });\n" \
+    "            }, 1000);\n" \
+    "\n" \
+    "            // mean deviation, max overrun, missed deadlines and histogram of deviations(logarithmic in both directions) in the upper right corner of the screen\n" \
+    "            function drawJitter() {\n" \
+    "                if(jitterStatistics == null || jitterStatistics.samples == 0) return;\n" \
+    "                var canvas = document.getElementById('oscilloscope');\n" \
+    "                var ctx = canvas.getContext('2d');\n" \
+    "                ctx.font = canvas.width < 500 ? '10px Verdana' : canvas.width < 800 ? '14px Verdana' : '16px Verdana';\n" \
+    "                ctx.textAlign = 'left';\n" \
+    "                ctx.lineWidth = 1;\n" \
+    "                ctx.strokeStyle = '#80bfff';\n" \
+    "                ctx.strokeText('jitter mean ' + jitterStatistics.meanUs + ' us   max overrun ' + jitterStatistics.maxOverrunUs + ' us   missed ' + jitterStatistics.missedDeadlines + ' of ' + jitterStatistics.samples, xOffset + 10, 55);\n" \
+    "\n" \
+    "                var h = jitterStatistics.histogram;\n" \
+    "                var barWidth = 8, barsHeight = 40, left = canvas.width - 20 - h.length * barWidth, bottom = 75;\n" \
+    "                var maxLog = Math.log10(Math.max(...h) + 1);\n" \
+    "                for(var k = 0; k < h.length; k++) {\n" \
+    "                    if(h [k] == 0) continue;\n" \
+    "                    var barHeight = Math.max(1, barsHeight * Math.log10(h [k] + 1) / maxLog);\n" \
+    "                    ctx.strokeRect(left + k * barWidth, bottom - barHeight, barWidth - 2, barHeight);\n" \
+    "                }\n" \
+    "                ctx.textAlign = 'right';\n" \
+    "                ctx.strokeText('>= ' + jitterStatistics.bucketsFromUs [h.length - 1] + ' us', canvas.width - 20, bottom + 20);\n" \
+    "                ctx.textAlign = 'left';\n" \
+    "                ctx.strokeText('0 us', left, bottom + 20);\n" \
+    "            }\n" \
+    "\n" \
+    "            // Vpp, Vrms, mean, frequency, duty cycle and rise time of channel 1, measured by ESP32 over the samples of the screen from the trigger on (analog values 0 - 4095 correspond to 0 V - 3.3 V unless they are in mV)\n" \
+    "            function drawMeasurements(myInt16Array) {\n" \
+    "                var m = new Uint16Array(myInt16Array.buffer, 8);\n" \
+    "                var volts = function(value) { return(document.getElementById('analogUnit').value == '2' ? value / 1000 : value * 3.3 / 4095).toFixed(2) + ' V'; };\n" \
+    "                var period =(m [5] * 65536 + m [6]) / 1e9; // in s\n" \
+    "                var riseTime = m [8] * 65536 + m [9]; // in ns\n" \
+    "                var text = 'Vpp ' + volts(myInt16Array [6] - myInt16Array [5]) + '   Vrms ' + volts(m [4] / 16) + '   mean ' + volts(m [3] / 16);\n" \
+    "                if(period > 0) text += '   f ' + frequencyLabel(1 / period) + '   duty ' +(m [7] / 10).toFixed(1) + ' %';\n" \
+    "                if(riseTime > 0) text += '   rise ' +(riseTime < 1000 ? riseTime + ' ns' : riseTime < 1000000 ?(riseTime / 1000).toFixed(1) + ' us' :(riseTime / 1000000).toFixed(1) + ' ms');\n" \
+    "                if(m [0] & 0x0003) text += '   CLIPPED';\n" \
+    "\n" \
+    "                var canvas = document.getElementById('oscilloscope');\n" \
+    "                var ctx = canvas.getContext('2d');\n" \
+    "                ctx.font = canvas.width < 500 ? '10px Verdana' : canvas.width < 800 ? '14px Verdana' : '16px Verdana';\n" \
+    "                ctx.textAlign = 'left';\n" \
+    "                ctx.lineWidth = 1;\n" \
+    "                ctx.strokeStyle = '#ffbf80';\n" \
+    "                ctx.strokeText(text, xOffset + 10, 30);\n" \
+    "            }\n" \
+    "\n" \
+    "            var lastLogicJ = []; // last drawn level of each logic analyzer signal\n" \
+    "\n" \
+    "            function drawLogicSignals(samples, triggerInd) {\n" \
+    "                var canvas = document.getElementById('oscilloscope');\n" \
+    "                var ctx = canvas.getContext('2d');\n" \
+    "\n" \
+    "                var signals = logicGpioList().length;\n" \
+    "                var lines = document.getElementById('lines').checked;\n" \
+    "                var markers = document.getElementById('markers').checked;\n" \
+    "\n" \
+    "                ctx.lineWidth = 2;\n" \
+    "\n" \
+    "                for(var ind = 0; ind < samples.length; ind++) {\n" \
+    "                    screenTimeOffset += continuousSamplingTime; // samples are equally spaced\n" \
+    "                    i = xOffset + xScale * screenTimeOffset;\n" \
+    "\n" \
+    "                    for(var k = 0; k < signals; k++) {\n" \
+    "                        var j = yOffset - k * logicLaneHeight + yScale *((samples [ind] >> k) & 1);\n" \
+    "                        ctx.strokeStyle = k & 1 ? '#ff8000' : '#ffbf80';\n" \
+    "                        if(lines && !restartDrawingSignal) {\n" \
+    "                            ctx.beginPath();\n" \
+    "                            ctx.moveTo(lastI, lastLogicJ [k]);\n" \
+    "                            ctx.lineTo(i, lastLogicJ [k]);\n" \
+    "                            ctx.lineTo(i, j);\n" \
+    "                            ctx.stroke();\n" \
+    "                        }\n" \
+    "                        if(markers) {\n" \
+    "                            ctx.beginPath();\n" \
+    "                            ctx.arc(i, j, 2, 0, 2 * Math.PI, false);\n" \
+    "                            ctx.stroke();\n" \
+    "                        }\n" \
+    "                        lastLogicJ [k] = j;\n" \
+    "                    }\n" \
+    "                    restartDrawingSignal = false;\n" \
+    "\n" \
+    "                    // trigger position\n" \
+    "                    if(ind == triggerInd) drawTriggerPosition(i);\n" \
+    "\n" \
+    "                    lastI = i;\n" \
+    "                }\n" \
+    "            }\n" \
+    "\n" \
+    "            function drawTriggerPosition(i) {\n" \
+    "                var canvas = document.getElementById('oscilloscope');\n" \
+    "                var ctx = canvas.getContext('2d');\n" \
+    "\n" \
+    "                ctx.save();\n" \
+    "                ctx.strokeStyle = 'hsl(82, 90%, 60%)';\n" \
+    "                ctx.lineWidth = 1;\n" \
+    "                ctx.setLineDash([5, 5]);\n" \
+    "                ctx.beginPath();\n" \
+    "                ctx.moveTo(i, 0);\n" \
+    "                ctx.lineTo(i, canvas.height);\n" \
+    "                ctx.stroke();\n" \
+    "                ctx.restore();\n" \
+    "            }\n" \
+    "\n" \
     "            // eneable and disable controls\n" \
     "            function enableDisableControls(workMode) {\n" \
     "                if(workMode) {\n" \
-    "                    // disable GPIO, analog/digital, trigger, frequency and start, enable stop\n" \
+    "                    // disable GPIO, analog/digital(and trigger, frequency for deep record) and start, enable stop\n" \
     "                    document.getElementById('gpio1').disabled = true;\n" \
     "                    document.getElementById('gpio2').disabled = true;\n" \
     "                    document.getElementById('analog').disabled = true;\n" \
     "                    document.getElementById('digital').disabled = true;\n" \
-    "                    document.getElementById('posTrigger').disabled = true;\n" \
-    "                    document.getElementById('posTreshold').disabled = true;\n" \
-    "                    document.getElementById('posTriggerLabel').style.color = 'gray';\n" \
-    "                    document.getElementById('negTrigger').disabled = true;\n" \
-    "                    document.getElementById('negTreshold').disabled = true;\n" \
-    "                    document.getElementById('negTriggerLabel').style.color = 'gray';\n" \
-    "                    document.getElementById('frequency').disabled = true;\n" \
-    "                    document.getElementById('frequencyLabel').style.color = 'gray';\n" \
+    "                    document.getElementById('logic').disabled = true;\n" \
+    "                    document.getElementById('logicGpios').disabled = true;\n" \
+    "                    document.getElementById('sampleBits').disabled = true;\n" \
+    "                    document.getElementById('analogUnit').disabled = true;\n" \
+    "                    document.getElementById('peakDetect').disabled = true;\n" \
+    "                    document.getElementById('spectrumWindow').disabled = true;\n" \
+    "                    document.getElementById('spectrumAverage').disabled = true;\n" \
+    "                    document.getElementById('recordLength').disabled = true;\n" \
+    "                    if(document.getElementById('recordLength').value != '0') { // triggers and timebase of a running oscilloscope can be changed, except for deep record that is taken only once\n" \
+    "                        document.getElementById('posTrigger').disabled = true;\n" \
+    "                        document.getElementById('posTreshold').disabled = true;\n" \
+    "                        document.getElementById('posTriggerLabel').style.color = 'gray';\n" \
+    "                        document.getElementById('negTrigger').disabled = true;\n" \
+    "                        document.getElementById('negTreshold').disabled = true;\n" \
+    "                        document.getElementById('negTriggerLabel').style.color = 'gray';\n" \
+    "                        document.getElementById('preTrigger').disabled = true;\n" \
+    "                        document.getElementById('preTriggerLabel').style.color = 'gray';\n" \
+    "                        document.getElementById('triggerMode').disabled = true;\n" \
+    "                        document.getElementById('holdoff').disabled = true;\n" \
+    "                        document.getElementById('triggerType').disabled = true;\n" \
+    "                        document.getElementById('pulseWidth').disabled = true;\n" \
+    "                        document.getElementById('triggerSource').disabled = true;\n" \
+    "                        document.getElementById('triggerGpio').disabled = true;\n" \
+    "                        document.getElementById('hysteresis').disabled = true;\n" \
+    "                        document.getElementById('hysteresisLabel').style.color = 'gray';\n" \
+    "                        document.getElementById('frequency').disabled = true;\n" \
+    "                        document.getElementById('frequencyLabel').style.color = 'gray';\n" \
+    "                    } else {\n" \
+    "                        document.getElementById('rearmButton').disabled = false;\n" \
+    "                    }\n" \
     "                    document.getElementById('startButton').disabled = true;\n" \
     "                    document.getElementById('stopButton').disabled = false;\n" \
     "                } else {\n" \
@@ -1164,8 +2013,27 @@
     "                    document.getElementById('gpio2').disabled = false;\n" \
     "                    document.getElementById('analog').disabled = false;\n" \
     "                    document.getElementById('digital').disabled = false;\n" \
+    "                    document.getElementById('logic').disabled = false;\n" \
+    "                    document.getElementById('logicGpios').disabled = false;\n" \
+    "                    document.getElementById('sampleBits').disabled = false;\n" \
+    "                    document.getElementById('analogUnit').disabled = false;\n" \
+    "                    document.getElementById('peakDetect').disabled = false;\n" \
+    "                    document.getElementById('spectrumWindow').disabled = false;\n" \
+    "                    document.getElementById('spectrumAverage').disabled = false;\n" \
+    "                    document.getElementById('recordLength').disabled = false;\n" \
     "                    document.getElementById('posTrigger').disabled = false;\n" \
     "                    document.getElementById('negTrigger').disabled = false;\n" \
+    "                    document.getElementById('preTrigger').disabled = false;\n" \
+    "                    document.getElementById('preTriggerLabel').style.color = 'black';\n" \
+    "                    document.getElementById('triggerMode').disabled = false;\n" \
+    "                    document.getElementById('holdoff').disabled = false;\n" \
+    "                    document.getElementById('triggerType').disabled = false;\n" \
+    "                    document.getElementById('pulseWidth').disabled = false;\n" \
+    "                    document.getElementById('triggerSource').disabled = false;\n" \
+    "                    document.getElementById('triggerGpio').disabled = false;\n" \
+    "                    document.getElementById('hysteresis').disabled = false;\n" \
+    "                    document.getElementById('hysteresisLabel').style.color = 'black';\n" \
+    "                    document.getElementById('rearmButton').disabled = true;\n" \
     "                    document.getElementById('frequency').disabled = false;\n" \
     "                    document.getElementById('frequencyLabel').style.color = 'black';\n" \
     "                    document.getElementById('startButton').disabled = false;\n" \
@@ -15,9 +15,30 @@
 // digitalRead
 #include "driver/gpio.h"
 #include "hal/gpio_hal.h"
+#include <soc/gpio_reg.h>     // GPIO_IN_REG and GPIO_IN1_REG to read all the GPIOs at once (logic analyzer)
+#include <soc/soc_caps.h>     // SOC_GPIO_PIN_COUNT
 // #include <soc/gpio_sig_map.h> // to digitalRead PWM and other GPIOs ...
 #include <driver/adc.h>       // to use adc1_get_raw instead of analogRead
 #include <driver/i2s.h>
+#if CONFIG_IDF_TARGET_ESP32
+    #include <hal/adc_ll.h>   // ADC digital controller pattern table to scan 2 ADC1 channels through I2S interface
+#endif
+#include <driver/gptimer.h>   // hardware timer that paces the samples
+#include <esp_timer.h>        // esp_timer_get_time for 64 bit us time stamps
+#include <esp_heap_caps.h>    // heap_caps_malloc for deep record in PSRAM
+#if __has_include (<esp_dsp.h>)
+    #include <esp_dsp.h>      // fixed-point FFT with ESP32 DSP and ESP32-S3 SIMD instructions (spectrum)
+#endif
+#if __has_include (<esp_adc_cal.h>)
+    #include <esp_adc_cal.h>  // calibration data from eFuses for ADC lookup tables
+#endif
+#include <esp_vfs_eventfd.h>  // oscReader wakes up oscSender through eventfd
+#include <sys/select.h>
+#include <unistd.h>
+#include <algorithm>          // std::rotate
+#include <math.h>             // window functions and dB of spectrum
+#include <type_traits>        // std::conditional
+#include <atomic>             // oscFrameQueue indices
 #include <ostream.hpp>
 #include <Cstring.hpp>
 #include <httpServer.h>
@@ -36,9 +57,19 @@
 
     // ----- TUNNING PARAMETERS -----
 
-    #define OSCILLOSCOPE_I2S_BUFFER_SIZE 666                          // max number of samples per screen, 720 samples (including 1 dummy sample) * 2 bytes per sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
-    #define OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE 333                      // max number of samples per screen, 333 samples (including 1 dummy sample) * 4 bytes per sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
-    #define OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE 222                     // max number of samples per screen, 222 samples (including 1 dummy sample) * 6 bytes per sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_I2S_BUFFER_SIZE 662                          // max number of samples per screen, 8 bytes of frame header + 662 samples * 2 bytes per sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_I2S_12BIT_BUFFER_SIZE 882                    // max number of samples per screen, 8 bytes of frame header + 882 samples * 1.5 bytes per (packed) sample = 1331 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_I2S_8BIT_BUFFER_SIZE 1324                    // max number of samples per screen, 8 bytes of frame header + 1324 samples * 1 byte per (packed) sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE 331                      // max number of samples per screen, 8 bytes of frame header + 331 samples * 4 bytes per sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE 220                     // max number of samples per screen, 8 bytes of frame header + 220 samples * 6 bytes per sample = 1328 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_1SIGNAL_MIN_MAX_BUFFER_SIZE 220               // max number of samples per screen, 8 bytes of frame header + 220 samples * 6 bytes per (min, max) sample = 1328 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_2SIGNALS_MIN_MAX_BUFFER_SIZE 132             // max number of samples per screen, 8 bytes of frame header + 132 samples * 10 bytes per (min, max) sample = 1328 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_ENVELOPE_BUFFER_SIZE 331                     // max number of (min, max) pairs per screen, 8 bytes of frame header + 331 pairs * 4 bytes per pair = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_TRANSITIONS_BUFFER_SIZE 331                  // max number of transitions per frame, 8 bytes of frame header + 331 transitions * 4 bytes per transition = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_LOGIC8_BUFFER_SIZE 1324                      // max number of samples per screen, 8 bytes of frame header + 1324 samples * 1 byte per sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_LOGIC16_BUFFER_SIZE 662                      // max number of samples per screen, 8 bytes of frame header + 662 samples * 2 bytes per sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_DEEP_RECORD_FRAGMENT_SIZE 658                // max number of samples per fragment of deep record, 8 bytes of frame header + 8 bytes of fragment header + 658 samples * 2 bytes per sample = 1332 bytes, which must be <= HTTP_WS_FRAME_MAX_SIZE - 8 (WebSocket header) = 1332
+    #define OSCILLOSCOPE_LOGIC_MAX_SIGNALS 16                         // logic analyzer packs the signals into 1 byte (up to 8 signals) or 2 bytes (up to 16 signals) per sample
 
 
     // some ESP32 boards read analog values inverted, uncomment the following line to invert read values back again 
@@ -53,9 +84,27 @@
     // define a correction factor for I2S sampling frequency if it needs to be corrected
     #define I2S_FREQ_CORRECTION (1.2)
 
+    #define OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH 256                    // max number of samples in one I2S DMA buffer (must be even and <= 1024), shorter DMA buffers are used at long sampling times to keep the latency low
+    #define OSCILLOSCOPE_I2S_DMA_BUFFER_COUNT 4                       // number of I2S DMA buffers, DMA is filling one while oscReader processes the others
+
+    #ifndef OSCILLOSCOPE_DEEP_RECORD_MAX_SAMPLES
+        #define OSCILLOSCOPE_DEEP_RECORD_MAX_SAMPLES 1048576          // max number of samples in deep record (I2S interface), 1 M samples * 2 bytes per sample = 2 MB of PSRAM
+    #endif
+
+    #ifndef OSCILLOSCOPE_FFT_SIZE
+        #define OSCILLOSCOPE_FFT_SIZE 1024                            // number of samples per FFT in spectrum mode (I2S interface), must be a power of 2, 8 bytes of frame header + 512 bins * 2 bytes per bin = 1032 bytes
+    #endif
+    #if OSCILLOSCOPE_FFT_SIZE < 16 || OSCILLOSCOPE_FFT_SIZE > 1024 || (OSCILLOSCOPE_FFT_SIZE & (OSCILLOSCOPE_FFT_SIZE - 1))
+        #error "OSCILLOSCOPE_FFT_SIZE must be a power of 2 between 16 and 1024 so that OSCILLOSCOPE_FFT_SIZE / 2 bins fit into one frame"
+    #endif
+
 
     #ifdef USE_I2S_INTERFACE
-        #pragma message "Oscilloscope will use I2S interface (for monitoring a single analog signal) and adc1_get_raw (for monitoring double analog signals)."
+        #if CONFIG_IDF_TARGET_ESP32
+            #pragma message "Oscilloscope will use I2S interface (for monitoring single and double analog signals)."
+        #else
+            #pragma message "Oscilloscope will use I2S interface (for monitoring a single analog signal) and adc1_get_raw (for monitoring double analog signals)."
+        #endif
     #else
         #pragma message "I2S interface not used or present, Oscilloscope will use adc1_get_raw (for monitoring single and double analog signals)."
     #endif
@@ -64,6 +113,69 @@
         #define OSCILLOSCOPE_READER_PRIORITY 1                        // normal priority if not define differently
     #endif
 
+    #ifndef OSCILLOSCOPE_READER_WORKERS
+        #define OSCILLOSCOPE_READER_WORKERS 2                         // number of oscReader tasks (= max number of oscilloscopes running at the same time), they are created only once and then reused
+    #endif
+
+    // isolation profiles of oscReader tasks, each oscReader reports the sampling jitter it has achieved when it stops, so the profile can be chosen for each board
+    #define OSC_ISOLATION_NONE 0                                      // oscReader tasks run on any core at OSCILLOSCOPE_READER_PRIORITY
+    #define OSC_ISOLATION_PINNED 1                                    // oscReader tasks are pinned to APP_CPU at OSCILLOSCOPE_ISOLATED_READER_PRIORITY, WiFi and lwIP tasks stay pinned to PRO_CPU and busy oscReader pushes unpinned HTTP and FTP tasks there as well
+    #define OSC_ISOLATION_PINNED_YIELDING 2                           // the same, but busy-waiting oscReader yields for 1 tick after OSCILLOSCOPE_READER_BUSY_BUDGET so the idle task of APP_CPU can feed the watchdog
+
+    #ifndef OSCILLOSCOPE_ISOLATION_PROFILE
+        #define OSCILLOSCOPE_ISOLATION_PROFILE OSC_ISOLATION_NONE     // oscReader tasks are not isolated if not defined differently
+    #endif
+
+    #ifndef OSCILLOSCOPE_ISOLATED_READER_PRIORITY
+        #define OSCILLOSCOPE_ISOLATED_READER_PRIORITY 15              // above HTTP and FTP tasks but below lwIP (18) and WiFi (23) tasks in case they are not pinned to PRO_CPU
+    #endif
+
+    #ifndef OSCILLOSCOPE_READER_BUSY_BUDGET
+        #define OSCILLOSCOPE_READER_BUSY_BUDGET 50000                 // in us, how long OSC_ISOLATION_PINNED_YIELDING oscReader may busy-wait for the samples before it yields
+    #endif
+
+    #ifndef OSCILLOSCOPE_FRAME_QUEUE_DEPTH
+        #define OSCILLOSCOPE_FRAME_QUEUE_DEPTH 4                      // number of frame slots between oscReader and oscSenders, oscReader always fills one of them so up to 3 frames can wait to be sent
+    #endif
+
+    #ifndef OSCILLOSCOPE_MAX_VIEWERS
+        #define OSCILLOSCOPE_MAX_VIEWERS 4                            // max number of javascript clients with identical settings that share the same oscReader
+    #endif
+
+    #ifndef OSCILLOSCOPE_MAX_EVENTFDS
+        #define OSCILLOSCOPE_MAX_EVENTFDS 8                           // max number of eventfds (1 per viewer), if there are more viewers their oscSenders fall back to polling
+    #endif
+
+    #ifndef OSCILLOSCOPE_TIMER_MIN_SAMPLING_TIME
+        #define OSCILLOSCOPE_TIMER_MIN_SAMPLING_TIME 20               // in us, shorter sampling times are still busy-waited since waking up oscReader task (~ 10 us) would take most of the sampling time
+    #endif
+
+    #ifndef OSCILLOSCOPE_PEAK_DETECT_SAMPLING_TIME
+        #define OSCILLOSCOPE_PEAK_DETECT_SAMPLING_TIME 20             // in us, how often raw samples are taken in peak detect acquisition mode (they are reduced to min and max of each sampling time)
+    #endif
+
+    #ifndef OSCILLOSCOPE_AUTO_TRIGGER_TIMEOUT
+        #define OSCILLOSCOPE_AUTO_TRIGGER_TIMEOUT 100                 // in ms, how long Auto trigger mode waits for the trigger condition before it shows untriggered screen
+    #endif
+
+    #ifndef OSCILLOSCOPE_RECONFIGURE_TIMEOUT
+        #define OSCILLOSCOPE_RECONFIGURE_TIMEOUT 250                  // in ms, how long OSC_CMD_RECONFIGURE waits for oscReader to finish the frame it is filling before it stops oscReader anyway
+    #endif
+
+    #ifndef OSCILLOSCOPE_ADC_ATTENUATION
+        #define OSCILLOSCOPE_ADC_ATTENUATION ADC_ATTEN_DB_12          // attenuation of ADC1 channels, ADC calibration tables are built for this attenuation
+    #endif
+    #ifndef OSCILLOSCOPE_ADC_DEFAULT_VREF
+        #define OSCILLOSCOPE_ADC_DEFAULT_VREF 1100                    // in mV, ADC reference voltage used for the calibration if there is none in eFuses
+    #endif
+    #ifndef OSCILLOSCOPE_ADC_FULL_SCALE_MV
+        #define OSCILLOSCOPE_ADC_FULL_SCALE_MV 3300                   // in mV, the voltage that corresponds to calibrated value 4095
+    #endif
+
+    #ifndef OSCILLOSCOPE_MEASUREMENT_MIN_AMPLITUDE
+        #define OSCILLOSCOPE_MEASUREMENT_MIN_AMPLITUDE 64             // in analog values, signals with smaller peak to peak amplitude are considered as noise, their frequency and rise time are not measured
+    #endif
+
 
     // ----- CODE -----
 
@@ -72,6 +184,13 @@
         .dev = GPIO_HAL_GET_HW (GPIO_PORT_0)
     };        
 
+    // for analog reading
+    #ifdef INVERT_ADC1_GET_RAW
+        constexpr bool __oscInvertAdc1__ = true;
+    #else
+        constexpr bool __oscInvertAdc1__ = false;
+    #endif
+
     // oscilloscope samples
     struct oscI2sSample {                       // one sample
         int16_t signal1;                        // signal value of 1st GPIO read by analogRead or digialRead   
@@ -87,38 +206,314 @@
         int16_t signal2;                        // signal value of 2nd GPIO if requested   
         int16_t deltaTime;                      // sample time - offset from previous sample in ms or us  
     }; // = 6 bytes per sample
+
+    struct osc1SignalMinMaxSample {             // one sample in peak detect acquisition mode
+        int16_t signal1Min;                     // min value of 1st GPIO read by analogRead during the sampling time
+        int16_t signal1Max;                     // max value of 1st GPIO read by analogRead during the sampling time
+        int16_t deltaTime;                      // sample time - offset from previous sample in us  
+    }; // = 6 bytes per sample
+
+    struct osc2SignalsMinMaxSample {            // one sample in peak detect acquisition mode
+        int16_t signal1Min;                     // min value of 1st GPIO read by analogRead during the sampling time
+        int16_t signal1Max;                     // max value of 1st GPIO read by analogRead during the sampling time
+        int16_t signal2Min;                     // min value of 2nd GPIO read by analogRead during the sampling time
+        int16_t signal2Max;                     // max value of 2nd GPIO read by analogRead during the sampling time
+        int16_t deltaTime;                      // sample time - offset from previous sample in us  
+    }; // = 10 bytes per sample
+
+    struct oscEnvelopeSample {                  // one equally spaced sample of combined I2S screens in envelope and persistence acquisition modes
+        int16_t signal1Min;                     // min value of the sample over the combined screens
+        int16_t signal1Max;                     // max value of the sample over the combined screens
+    }; // = 4 bytes per sample
+
+    struct oscTransitionSample {                // one sample where any of the digital levels has changed
+        int16_t levels;                         // bit 0 = level of 1st GPIO, bit 1 = level of 2nd GPIO if requested
+        int16_t deltaTime;                      // offset from previous transition in us
+    }; // = 4 bytes per transition
+
+    struct oscDeepRecordFragment {              // a part of deep record that fits into one frame, the record itself is kept in PSRAM
+        uint16_t fragment;                      // fragment number, 0 for the first one
+        uint16_t fragments;                     // number of all fragments in the record
+        uint16_t triggerFragment;               // fragment number with the first sample after the trigger condition occured, 0xFFFF if there is no trigger in the record
+        uint16_t triggerPosition;               // index of the first sample after the trigger condition occured within triggerFragment
+        oscI2sSample samples [OSCILLOSCOPE_DEEP_RECORD_FRAGMENT_SIZE];
+    }; // = 8 bytes + 2 bytes per sample
+
+    typedef uint8_t osc8LogicSignalsSample;     // one sample of up to 8 digital signals, bit i holds the level of i-th GPIO = 1 byte per sample
+    typedef uint16_t osc16LogicSignalsSample;   // one sample of up to 16 digital signals, bit i holds the level of i-th GPIO = 2 bytes per sample
     
+    // each frame sent to javascript client starts with a header that tells it how to draw the samples that follow
+    #define OSC_FRAME_1_SIGNAL -2                       // 1 signal with deltaTime in each sample
+    #define OSC_FRAME_2_SIGNALS -3                      // 2 signals with deltaTime in each sample
+    #define OSC_FRAME_1_SIGNAL_EQUALLY_SPACED -4        // 1 signal sampled continuously (I2S), sampling time is in the header
+    #define OSC_FRAME_8_LOGIC_SIGNALS -5                // up to 8 digital signals packed in 1 byte per sample (logic analyzer), sampling time is in the header
+    #define OSC_FRAME_16_LOGIC_SIGNALS -6               // up to 16 digital signals packed in 2 bytes per sample (logic analyzer), sampling time is in the header
+    #define OSC_FRAME_TRANSITIONS -7                    // 1 or 2 digital signals, only the samples where any level has changed, with deltaTime from previous transition
+    #define OSC_FRAME_1_SIGNAL_PACKED_12_BITS -8        // 1 signal sampled continuously (I2S), 2 samples packed into 3 bytes, sampling time is in the header
+    #define OSC_FRAME_1_SIGNAL_PACKED_8_BITS -9         // 1 signal sampled continuously (I2S), only the upper 8 bits of each sample in 1 byte, sampling time is in the header
+    #define OSC_FRAME_1_SIGNAL_MIN_MAX -10              // 1 signal with (min, max) and deltaTime in each sample (peak detect)
+    #define OSC_FRAME_2_SIGNALS_MIN_MAX -11             // 2 signals with (min, max) and deltaTime in each sample (peak detect)
+    #define OSC_FRAME_DEEP_RECORD -12                   // one fragment of deep record of 1 signal sampled continuously (I2S), sampling time is in the header
+
+    #define OSC_FRAME_CAPABILITIES -13                  // reply to OSC_CMD_GET_CAPABILITIES, (key, value high word, value low word) triplets follow the header
+    #define OSC_FRAME_SETTINGS -14                      // acknowledges OSC_CMD_START or OSC_CMD_RECONFIGURE with the settings (corrected by oscReader) that are actually used
+
+    #define OSC_FRAME_SPECTRUM -15                      // OSCILLOSCOPE_FFT_SIZE / 2 frequency bins of 1 signal (I2S) in 1/100 dB relative to full scale sine, sampling time is in the header
+    #define OSC_FRAME_SPECTRUM_8_BITS -16               // the same, but 1 byte per bin in 0.5 dB steps below full scale sine (0 = 0 dB, 255 = -127.5 dB or less)
+    #define OSC_FRAME_MEASUREMENTS -17                  // follows the frame with OSC_FRAME_MEASURED flag, oscMeasurementRecord of its samples follows the header
+    #define OSC_FRAME_ENVELOPE -18                      // 1 signal sampled continuously (I2S), (min, max) of each sample over more screens, sampling time is in the header
+
+    #define OSC_FRAME_CONTINUED 0x0001                  // flag: samples continue the screen of the previous frame ('sample at a time' mode), don't start drawing from the left of the screen
+    #define OSC_FRAME_MEASURED 0x0002                   // flag: OSC_FRAME_MEASUREMENTS with the measurements of the screen will follow this frame
+    #define OSC_FRAME_MILLISECONDS 0x0004               // flag: samplingTime in the header is in ms instead of us (logic analyzer with ms time unit, where us may not fit in int16_t)
+    #define OSC_FRAME_TRIGGER_FRACTION 0xFF00           // the upper byte of flags: how far before the trigger sample the treshold has been crossed, in 1/256 of the interval between the trigger sample and the one before it
+
+    // Binary control protocol. After the endian identification (0xAABB) javascript client sends control messages in its own byte order: oscControlHeader followed
+    // by typed parameters (TLV: 1 byte type, 1 byte length, value). The upper 2 bits of the type tell the size of integers the value is made of, so ESP32 can put
+    // even the parameters it doesn't know into its own byte order and skip them. This way newer javascript clients can still talk to older ESP32s.
+    #define OSC_PROTOCOL_VERSION 1
+
+    #define OSC_CMD_GET_CAPABILITIES 1                  // ESP32 replies with OSC_FRAME_CAPABILITIES
+    #define OSC_CMD_START 2                             // start sampling with the parameters that follow
+    #define OSC_CMD_STOP 3                              // stop sampling, the session ends
+    #define OSC_CMD_RECONFIGURE 4                       // change sampling parameters (the same as with OSC_CMD_START) of the running oscilloscope, they take effect at the next frame
+
+    #define OSC_PARAM_8 0x00                            // the value is made of bytes
+    #define OSC_PARAM_16 0x40                           // the value is made of 16 bit integers
+    #define OSC_PARAM_32 0x80                           // the value is made of 32 bit integers
+
+    #define OSC_PARAM_READ_TYPE         (OSC_PARAM_8 | 1)   // OSC_READ_ANALOG, OSC_READ_DIGITAL or OSC_READ_LOGIC
+    #define OSC_PARAM_GPIOS             (OSC_PARAM_8 | 2)   // 1 or 2 GPIOs (analog, digital) or up to OSCILLOSCOPE_LOGIC_MAX_SIGNALS GPIOs (logic)
+    #define OSC_PARAM_TIME_UNIT         (OSC_PARAM_8 | 3)   // OSC_UNIT_US or OSC_UNIT_MS, for sampling time and screen width
+    #define OSC_PARAM_SAMPLING_TIME     (OSC_PARAM_32 | 4)  // time between samples
+    #define OSC_PARAM_SCREEN_WIDTH      (OSC_PARAM_32 | 5)  // oscilloscope screen width
+    #define OSC_PARAM_POSITIVE_TRIGGER  (OSC_PARAM_16 | 6)  // positive slope trigger treshold
+    #define OSC_PARAM_NEGATIVE_TRIGGER  (OSC_PARAM_16 | 7)  // negative slope trigger treshold
+    #define OSC_PARAM_PRE_TRIGGER       (OSC_PARAM_8 | 8)   // 0 - 100 % of the screen before the trigger condition
+    #define OSC_PARAM_SAMPLE_BITS       (OSC_PARAM_8 | 9)   // 16, 12 or 8 bits per (I2S) sample
+    #define OSC_PARAM_PEAK_DETECT       (OSC_PARAM_8 | 10)  // no value, peak detect acquisition
+    #define OSC_PARAM_RECORD_LENGTH     (OSC_PARAM_32 | 11) // number of samples in deep record
+    #define OSC_PARAM_TRIGGER_MODE      (OSC_PARAM_8 | 12)  // OSC_TRIGGER_NORMAL (default), OSC_TRIGGER_AUTO or OSC_TRIGGER_SINGLE
+    #define OSC_PARAM_HOLDOFF           (OSC_PARAM_32 | 13) // in us, how long the trigger stays disarmed after a triggered screen
+    #define OSC_PARAM_TRIGGER_TYPE      (OSC_PARAM_8 | 14)  // OSC_TRIGGER_EDGE (default), OSC_TRIGGER_WINDOW_ENTER, ...
+    #define OSC_PARAM_TRIGGER_SOURCE    (OSC_PARAM_8 | 15)  // OSC_TRIGGER_SOURCE_CH1 (default), OSC_TRIGGER_SOURCE_CH2 or OSC_TRIGGER_SOURCE_GPIO
+    #define OSC_PARAM_TRIGGER_GPIO      (OSC_PARAM_8 | 16)  // external trigger input with OSC_TRIGGER_SOURCE_GPIO
+    #define OSC_PARAM_HYSTERESIS        (OSC_PARAM_16 | 17) // how far (in analog values) the signal must get back from the treshold before it can cross it again
+    #define OSC_PARAM_PULSE_WIDTH       (OSC_PARAM_32 | 18) // in us, for pulse width triggers
+    #define OSC_PARAM_SPECTRUM_WINDOW   (OSC_PARAM_8 | 19)  // OSC_WINDOW_..., send the spectrum instead of the samples
+    #define OSC_PARAM_SPECTRUM_AVERAGE  (OSC_PARAM_8 | 20)  // number of spectra (1 - 64) averaged into one frame
+    #define OSC_PARAM_MEASUREMENTS      (OSC_PARAM_8 | 21)  // no value, send OSC_FRAME_MEASUREMENTS after each screen
+    #define OSC_PARAM_ACQUISITION       (OSC_PARAM_8 | 22)  // OSC_ACQUISITION_NORMAL (default), OSC_ACQUISITION_AVERAGE, OSC_ACQUISITION_ENVELOPE or OSC_ACQUISITION_PERSISTENCE
+    #define OSC_PARAM_ACQUISITION_FRAMES (OSC_PARAM_8 | 23) // number of screens (1 - 64) combined into one, or the decay of persistence
+    #define OSC_PARAM_ANALOG_UNIT       (OSC_PARAM_8 | 24)  // OSC_ANALOG_RAW (default), OSC_ANALOG_CALIBRATED or OSC_ANALOG_MILLIVOLTS, also the unit of trigger tresholds and hysteresis
+
+    #define OSC_READ_ANALOG 0
+    #define OSC_READ_DIGITAL 1
+    #define OSC_READ_LOGIC 2
+
+    #define OSC_UNIT_US 0
+    #define OSC_UNIT_MS 1
+
+    #define OSC_TRIGGER_NORMAL 0                        // show only the triggered screens
+    #define OSC_TRIGGER_AUTO 1                          // show untriggered screen if the trigger condition doesn't occur in OSCILLOSCOPE_AUTO_TRIGGER_TIMEOUT
+    #define OSC_TRIGGER_SINGLE 2                        // show the first triggered screen and stop sampling
+
+    #define OSC_TRIGGER_EDGE 0                          // positive slope on positive trigger treshold and/or negative slope on negative trigger treshold
+    #define OSC_TRIGGER_WINDOW_ENTER 1                  // the signal enters the window between both tresholds
+    #define OSC_TRIGGER_WINDOW_EXIT 2                   // the signal leaves the window between both tresholds
+    #define OSC_TRIGGER_PULSE_LONGER 3                  // positive pulse above positive trigger treshold and/or negative pulse below negative trigger treshold, longer than pulse width
+    #define OSC_TRIGGER_PULSE_SHORTER 4                 // the same, but shorter than pulse width
+    #define OSC_TRIGGER_RUNT 5                          // the signal crosses one treshold and returns without crossing the other one
+
+    #define OSC_TRIGGER_SOURCE_CH1 0                    // gpio1
+    #define OSC_TRIGGER_SOURCE_CH2 1                    // gpio2 (the second GPIO of logic analyzer)
+    #define OSC_TRIGGER_SOURCE_GPIO 2                   // separate digital GPIO that is not displayed
+
+    #define OSC_ACQUISITION_NORMAL 0                    // each screen is sent as it is taken
+    #define OSC_ACQUISITION_AVERAGE 1                   // average of N screens
+    #define OSC_ACQUISITION_ENVELOPE 2                  // (min, max) of N screens
+    #define OSC_ACQUISITION_PERSISTENCE 3               // (min, max) of all the screens, decaying by 1/N at each screen
+
+    #define OSC_ANALOG_RAW 0                            // analog values are sent as ADC returns them, 0 - 4095
+    #define OSC_ANALOG_CALIBRATED 1                     // analog values are corrected by ADC calibration table, 0 - 4095 = 0 - OSCILLOSCOPE_ADC_FULL_SCALE_MV
+    #define OSC_ANALOG_MILLIVOLTS 2                     // analog values are translated into mV by ADC calibration table
+
+    #define OSC_MEASURED_CLIPPED_LOW 0x0001             // some raw values have been 0, the signal may be lower than ADC can measure
+    #define OSC_MEASURED_CLIPPED_HIGH 0x0002            // some raw values have been 4095, the signal may be higher than ADC can measure
+
+    #define OSC_WINDOW_RECTANGULAR 0                    // no window, the best frequency resolution but only for signals that fit the FFT length exactly
+    #define OSC_WINDOW_HANN 1                           // general purpose window
+    #define OSC_WINDOW_FLAT_TOP 2                       // the most accurate amplitudes, wide peaks
+    #define OSC_WINDOW_BLACKMAN 3                       // low leakage, shows weak components close to strong ones
+
+    #define OSC_CAP_PROTOCOL_VERSION 1                  // OSC_PROTOCOL_VERSION
+    #define OSC_CAP_READERS 2                           // bit mask of OSC_READER_...
+    #define OSC_CAP_SAMPLE_FORMATS 3                    // bit mask: 1 = 16 bits, 2 = 12 bits, 4 = 8 bits per sample
+    #define OSC_CAP_I2S_MIN_SAMPLING_TIME 4             // in us, the shortest sampling time of I2S reader
+    #define OSC_CAP_TIMER_MIN_SAMPLING_TIME 5           // in us, shorter sampling times are busy-waited
+    #define OSC_CAP_PEAK_DETECT_SAMPLING_TIME 6         // in us, how often peak detect reader takes raw samples
+    #define OSC_CAP_I2S_BUFFER_SIZE 7                   // max number of 16 bit I2S samples per screen
+    #define OSC_CAP_1SIGNAL_BUFFER_SIZE 8               // max number of samples of 1 signal per screen
+    #define OSC_CAP_2SIGNALS_BUFFER_SIZE 9              // max number of samples of 2 signals per screen
+    #define OSC_CAP_LOGIC_MAX_SIGNALS 10                // max number of logic analyzer GPIOs
+    #define OSC_CAP_DEEP_RECORD_MAX_SAMPLES 11          // max number of samples in deep record, 0 if not supported
+    #define OSC_CAP_MAX_VIEWERS 12                      // max number of javascript clients sharing the same oscReader
+    #define OSC_CAP_TRIGGER_TYPES 13                    // bit mask of (1 << OSC_TRIGGER_EDGE), (1 << OSC_TRIGGER_WINDOW_ENTER), ...
+    #define OSC_CAP_FFT_SIZE 14                         // number of samples per FFT in spectrum mode, 0 if not supported
+    #define OSC_CAP_ADC_CALIBRATION 15                  // 1 + esp_adc_cal_value_t (calibration data from eFuse Vref, eFuse two point or default Vref), 0 if not supported
+
+    #define OSC_READER_TIMED 0x0001                     // analog and digital samples paced by hardware timer
+    #define OSC_READER_TRANSITIONS 0x0002               // only transitions of digital signals
+    #define OSC_READER_LOGIC 0x0004                     // logic analyzer
+    #define OSC_READER_I2S 0x0008                       // continuous analog sampling through I2S interface
+    #define OSC_READER_PEAK_DETECT 0x0010               // (min, max) analog samples
+    #define OSC_READER_DEEP_RECORD 0x0020               // deep record in PSRAM
+    #define OSC_READER_SPECTRUM 0x0040                  // FFT spectrum of analog samples taken through I2S interface
+    #define OSC_READER_I2S_2_SIGNALS 0x0080             // continuous analog sampling of 2 signals through I2S interface (ADC pattern table)
+
+    #define OSC_CONTROL_MAX_SIZE 128                    // max size of control message
+
+    struct oscControlHeader {                   // 4 bytes, followed by the parameters
+        uint8_t version;                        // OSC_PROTOCOL_VERSION
+        uint8_t opcode;                         // OSC_CMD_...
+        uint16_t length;                        // number of bytes of parameters that follow the header
+    };
+
+    struct oscControlMessage {
+        oscControlHeader header;
+        uint8_t parameters [OSC_CONTROL_MAX_SIZE - sizeof (oscControlHeader)];
+    };
+
+    struct oscSettingsAck {                     // follows the header of OSC_FRAME_SETTINGS, all in 16 bit words
+        uint16_t timeUnit;                      // OSC_UNIT_US or OSC_UNIT_MS
+        uint16_t samplingTime [2];              // high and low word of the sampling time oscReader is actually using
+        uint16_t screenWidth [2];               // high and low word of the screen width oscReader is actually using
+        int16_t positiveTrigger;                // positive slope trigger treshold, -1 if not set
+        int16_t negativeTrigger;                // negative slope trigger treshold, -1 if not set
+        int16_t preTriggerPercent;              // 0 - 100 % of the screen before the trigger condition
+        int16_t triggerMode;                    // OSC_TRIGGER_NORMAL, OSC_TRIGGER_AUTO or OSC_TRIGGER_SINGLE
+    };
+
+    struct oscMeasurementRecord {               // follows the header of OSC_FRAME_MEASUREMENTS, all in 16 bit words, measurements of channel 1 over the samples of the screen from the trigger on
+        uint16_t flags;                         // OSC_MEASURED_CLIPPED_LOW, OSC_MEASURED_CLIPPED_HIGH
+        int16_t min;                            // the lowest analog value
+        int16_t max;                            // the highest analog value, Vpp = max - min
+        uint16_t mean;                          // in 1/16 of analog value
+        uint16_t rms;                           // in 1/16 of analog value, DC component included
+        uint16_t period [2];                    // high and low word, in ns, 0 if the level hasn't been crossed upwards at least twice, frequency = 1 / period
+        uint16_t dutyCycle;                     // in 0.1 %, valid together with period
+        uint16_t riseTime [2];                  // high and low word, from 10 % to 90 % level in ns, 0 if there was no complete rising edge
+        uint16_t samples [2];                   // high and low word, number of samples measured
+    };
+
+    struct oscFrameHeader {                     // 8 bytes, sent together with the samples
+        int16_t frameType;                      // OSC_FRAME_... (negative, no real data sample can look like this)
+        int16_t samplingTime;                   // time between equally spaced samples in us (in ms with OSC_FRAME_MILLISECONDS flag), 0 if each sample carries its own deltaTime
+        int16_t triggerPosition;                // index of the first sample after the trigger condition occured, -1 if there is no trigger in the frame
+        uint16_t flags;                         // OSC_FRAME_CONTINUED, ...
+    };
+
     struct oscSamples {                         // buffer with samples
+        oscFrameHeader header;                  // must be immediately followed by the samples since both are sent to javascript client in one block
         union {
-            oscI2sSample        samplesI2sSignal  [OSCILLOSCOPE_I2S_BUFFER_SIZE + 8]; // note that there is place for 8 additional samples
+            oscI2sSample        samplesI2sSignal  [OSCILLOSCOPE_I2S_BUFFER_SIZE]; // or up to OSCILLOSCOPE_I2S_8BIT_BUFFER_SIZE packed samples
             osc1SignalSample    samples1Signal    [OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE];
             osc2SignalsSample   samples2Signals   [OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE];
+            osc1SignalMinMaxSample  samples1SignalMinMax  [OSCILLOSCOPE_1SIGNAL_MIN_MAX_BUFFER_SIZE];
+            osc2SignalsMinMaxSample samples2SignalsMinMax [OSCILLOSCOPE_2SIGNALS_MIN_MAX_BUFFER_SIZE];
+            oscEnvelopeSample   envelope          [OSCILLOSCOPE_ENVELOPE_BUFFER_SIZE];
+            oscTransitionSample transitions       [OSCILLOSCOPE_TRANSITIONS_BUFFER_SIZE];
+            osc8LogicSignalsSample  samples8LogicSignals  [OSCILLOSCOPE_LOGIC8_BUFFER_SIZE];
+            osc16LogicSignalsSample samples16LogicSignals [OSCILLOSCOPE_LOGIC16_BUFFER_SIZE];
+            oscDeepRecordFragment deepRecord;
+            int16_t             spectrum          [OSCILLOSCOPE_FFT_SIZE / 2]; // frequency bins in 1/100 dB
+            uint8_t             spectrum8Bits     [OSCILLOSCOPE_FFT_SIZE / 2]; // frequency bins in 0.5 dB steps below full scale
         };
-        unsigned int sampleCount;               // number of samples in the buffer
-        bool samplesAreReady;                   // is the buffer ready for sending
+        unsigned int sampleCount;               // number of samples in the buffer (not counting the header)
+        oscMeasurementRecord measurements;      // sent in its own OSC_FRAME_MEASUREMENTS after the samples if the header has OSC_FRAME_MEASURED flag
+    };
+
+    // viewers (oscSenders of javascript clients with identical settings) attached to the same frame queue
+    SemaphoreHandle_t __oscViewersLock__ = NULL;        // protects the cursors of all the frame queues and the list of shared acquisitions
+
+    struct oscFrameCursor {                     // each viewer has its own cursor into the frame queue so it can skip the frames independently of the others
+        std::atomic<unsigned int> next;         // number of the next frame this viewer is going to send, only this viewer changes it
+        int frameReadyEvent;                    // eventfd that wakes up the viewer's oscSender when a frame is pushed, -1 if not available
+    };
+
+    // Single producer (oscReader) multiple consumer (oscSenders of all the viewers) ring of frames. oscReader always fills the slot at head while the previous
+    // OSCILLOSCOPE_FRAME_QUEUE_DEPTH - 1 frames can still be sent. Each viewer copies the frame before sending it, so no viewer can stall oscReader. If a viewer
+    // falls too far behind, the oldest frames get overwritten and this viewer skips them (or oscReader waits in 'sample at a time' mode).
+    struct oscFrameQueue {
+        oscSamples slot [OSCILLOSCOPE_FRAME_QUEUE_DEPTH];
+        std::atomic<unsigned int> head;         // number of frames pushed so far, oscReader is filling slot [head % OSCILLOSCOPE_FRAME_QUEUE_DEPTH], only oscReader changes it
+        oscFrameCursor *cursor [OSCILLOSCOPE_MAX_VIEWERS]; // viewers attached to this queue, NULL if the place is free
+
+        // oscReader side
+        oscSamples *writeSlot () { return &slot [head.load (std::memory_order_relaxed) % OSCILLOSCOPE_FRAME_QUEUE_DEPTH]; }
+
+        bool push (bool overwrite = false) { // pass the frame in writeSlot () to all the viewers, unless overwrite is set returns false if some viewer hasn't sent the oldest frame yet
+            unsigned int h = head.load (std::memory_order_relaxed);
+            xSemaphoreTake (__oscViewersLock__, portMAX_DELAY);
+                if (!overwrite)
+                    for (oscFrameCursor *c : cursor)
+                        if (c && h - c->next.load (std::memory_order_relaxed) >= OSCILLOSCOPE_FRAME_QUEUE_DEPTH - 1) { // this viewer is still going to send the frame in the next slot
+                            xSemaphoreGive (__oscViewersLock__);
+                            return false;
+                        }
+                head.store (h + 1, std::memory_order_release); // samples written to the slot become visible to all the viewers
+                for (oscFrameCursor *c : cursor)
+                    if (c && c->frameReadyEvent >= 0) {
+                        uint64_t one = 1;
+                        write (c->frameReadyEvent, &one, sizeof (one)); // wake up viewer's oscSender
+                    }
+            xSemaphoreGive (__oscViewersLock__);
+            return true;
+        }
+
+        // oscSender side
+        bool copyNext (oscFrameCursor *c, oscSamples *frame) { // copies the next frame the viewer hasn't sent yet, returns false if there is none
+            while (true) {
+                unsigned int h = head.load (std::memory_order_acquire);
+                unsigned int n = c->next.load (std::memory_order_relaxed);
+                if (h - n >= OSCILLOSCOPE_FRAME_QUEUE_DEPTH) n = h - (OSCILLOSCOPE_FRAME_QUEUE_DEPTH - 1); // the viewer is too slow, skip the frames that have already been overwritten
+                if (n == h) { c->next.store (n, std::memory_order_relaxed); return false; }
+                memcpy ((void *) frame, (void *) &slot [n % OSCILLOSCOPE_FRAME_QUEUE_DEPTH], sizeof (oscSamples));
+                std::atomic_thread_fence (std::memory_order_acquire);
+                if (head.load (std::memory_order_relaxed) - n < OSCILLOSCOPE_FRAME_QUEUE_DEPTH) { // oscReader hasn't started overwriting the slot while it was being copied
+                    c->next.store (n + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+        }
     };
 
     enum readerState { INITIAL = 0, START = 1, STARTED = 2, STOP = 3, STOPPED = 4 };
     /* transitions:
-          START   - set by osc main thread
-          STARTED - set by oscReader
+          START   - set by osc main thread before passing the job to oscReader worker
+          STARTED - set by oscReader, osc main thread is also notified
           STOP    - set by osc main thread
-          STOPPED - set by oscReader
+          STOPPED - set by oscReader, osc main thread is also notified
     */
 
     struct oscSharedMemory {         // data structure to be shared among oscilloscope tasks
       // basic data for web oscilloscope
-      httpServer_t::webSocket_t *webSck;      // open webSocket for communication with javascript client
+      httpServer_t::webSocket_t *webSck;      // open webSocket for communication with javascript client that has started oscReader
+      uint8_t command [OSC_CONTROL_MAX_SIZE];  // parameters of OSC_CMD_START in ESP32 byte order, javascript clients that send the same parameters share the same oscReader
+      uint16_t commandLength;                 // number of bytes in command
+      unsigned char viewers;                  // number of javascript clients attached to frameQueue
       bool clientIsBigEndian;                 // true if javascript client is big endian machine
       // basic data for PulseView
       int noOfSamples;
       // sampling sharedMemory
-      char readType [8];                      // analog or digital
+      char readType [8];                      // analog, digital or logic
       bool analog;                            // true if readType is analog, false if digital (digitalRead)
       gpio_num_t gpio1;                       // gpio where ESP32 is taking samples from (digitalRead)
       gpio_num_t gpio2;                       // 2nd gpio if requested
       adc1_channel_t adcchannel1;             // channel mapped from gpio ESP32 is taking samples from (adc1_get_raw instead of analogRead)
       adc1_channel_t adcchannel2;             // channel mapped from gpio ESP32 is taking samples from (adc1_get_raw instead of analogRead)
+      unsigned char logicSignals;             // number of GPIOs logic analyzer is taking samples from
+      uint8_t logicGpio [OSCILLOSCOPE_LOGIC_MAX_SIGNALS]; // GPIOs logic analyzer is taking samples from, bit i of each sample holds the level of logicGpio [i]
       int samplingTime;                       // time between samples in ms or us
       char samplingTimeUnit [3];              // ms or us
       unsigned long screenWidthTime;          // oscilloscope screen width in ms or us
@@ -127,70 +522,901 @@
       int positiveTriggerTreshold;            // positive slope trigger treshold value
       bool negativeTrigger;                   // true if negative slope trigger is set  
       int negativeTriggerTreshold;            // negative slope trigger treshold value
+      int preTriggerPercent;                  // how much of the screen (0 - 100 %) shows the samples taken before the trigger condition occured
+      unsigned char triggerMode;              // OSC_TRIGGER_NORMAL, OSC_TRIGGER_AUTO or OSC_TRIGGER_SINGLE
+      unsigned long holdoff;                  // in us, how long the trigger stays disarmed after a triggered screen
+      unsigned char triggerType;              // OSC_TRIGGER_EDGE, OSC_TRIGGER_WINDOW_ENTER, ...
+      unsigned char triggerSource;            // OSC_TRIGGER_SOURCE_CH1, OSC_TRIGGER_SOURCE_CH2 or OSC_TRIGGER_SOURCE_GPIO
+      unsigned char triggerGpio;              // external trigger input with OSC_TRIGGER_SOURCE_GPIO
+      int hysteresis;                         // in analog values, 0 = none
+      unsigned long pulseWidth;               // in us, for pulse width triggers
+      int sampleBits;                         // 16 (not packed), 12 or 8 bits per sample sent to javascript client, only continuously sampled (I2S) frames get packed
+      bool peakDetect;                        // true if each analog sample is (min, max) of the raw samples taken during the sampling time
+      unsigned long recordLength;             // number of samples in deep record (kept in PSRAM and sent in fragments), 0 for sampling screen by screen
+      bool spectrum;                          // true if the spectrum is sent instead of the samples
+      unsigned char spectrumWindow;           // OSC_WINDOW_RECTANGULAR, OSC_WINDOW_HANN, OSC_WINDOW_FLAT_TOP or OSC_WINDOW_BLACKMAN
+      int spectrumAverage;                    // number of spectra averaged into one frame
+      bool measurements;                      // true if OSC_FRAME_MEASUREMENTS is sent after each screen
+      unsigned char acquisition;              // OSC_ACQUISITION_NORMAL, OSC_ACQUISITION_AVERAGE, OSC_ACQUISITION_ENVELOPE or OSC_ACQUISITION_PERSISTENCE
+      int acquisitionFrames;                  // number of screens combined into one
+      unsigned char analogUnit;               // OSC_ANALOG_RAW, OSC_ANALOG_CALIBRATED or OSC_ANALOG_MILLIVOLTS
+      int correctedSamplingTime;              // sampling time oscReader is actually using, set when oscReader STARTED
+      unsigned long correctedScreenWidthTime; // screen width oscReader is actually using, set when oscReader STARTED
       // buffers holding samples 
-      oscSamples readBuffer;                  // we'll read samples into this buffer
-      oscSamples sendBuffer;                  // we'll copy red buffer into this buffer before sending samples to the client
+      oscFrameQueue frameQueue;               // oscReader reads samples into these buffers and oscSenders send them to the clients
       // reader state
+      void (*oscReader) (void *sharedMemory); // oscReader function that oscReader worker runs for this oscilloscope
+      TaskHandle_t controllerTask;            // osc main thread that gets notified when oscReader STARTED or STOPPED
       readerState oscReaderState;             // helps to execute a proper stopping sequence
     };
 
-    // oscilloscope reader read samples to read-buffer of shared memory - it will be copied to send buffer when it is ready to be sent
+    // oscReader acknowledges that it has started, osc main thread is waiting for this notification - it must be called after everything that can fail, a failing oscReader only calls __oscReaderStopped__
+    void __oscReaderStarted__ (void *sharedMemory, int samplingTime, unsigned long screenWidthTime) { // with the corrected values oscReader is actually using
+        ((oscSharedMemory *) sharedMemory)->correctedSamplingTime = samplingTime;
+        ((oscSharedMemory *) sharedMemory)->correctedScreenWidthTime = screenWidthTime;
+        ((oscSharedMemory *) sharedMemory)->oscReaderState = STARTED;
+        xTaskNotifyGive (((oscSharedMemory *) sharedMemory)->controllerTask);
+    }
+
+    // oscReader acknowledges that it has stopped, osc main thread may free shared memory after this so oscReader must not use it any more
+    void __oscReaderStopped__ (void *sharedMemory) {
+        TaskHandle_t controllerTask = ((oscSharedMemory *) sharedMemory)->controllerTask;
+        ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED;
+        xTaskNotifyGive (controllerTask);
+    }
+
+    // oscilloscope reader reads samples into the slot at the head of the frame queue - it is passed to oscSender when it is ready to be sent
+
+
+    // oscSamplingTimer oscSamplingTimer oscSamplingTimer oscSamplingTimer oscSamplingTimer oscSamplingTimer oscSamplingTimer oscSamplingTimer oscSamplingTimer
+
+    // Samples are paced by a hardware (general purpose) timer instead of busy-waiting on micros (). The timer alarm interrupt only wakes up oscReader task
+    // which then takes the sample, so the CPU is free for other tasks (WiFi, HTTP, FTP, ...) between the samples and the sampling time has 1 us resolution
+    // regardless of FreeRTOS tick. Sampling times shorter than OSCILLOSCOPE_TIMER_MIN_SAMPLING_TIME (or if there is no free hardware timer) are still busy-waited.
+
+    static bool IRAM_ATTR __oscTimerAlarm__ (gptimer_handle_t timer, const gptimer_alarm_event_data_t *alarmData, void *oscReaderTask) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR ((TaskHandle_t) oscReaderTask, &higherPriorityTaskWoken);
+        return higherPriorityTaskWoken == pdTRUE; // switch to oscReader at the end of ISR if it has higher priority than the interrupted task
+    }
+
+    // how much the actual intervals between the samples differ from samplingTime, to compare isolation profiles and to find safe sampling times on each board
+    #define OSC_JITTER_BUCKETS 16                       // histogram bucket 0 counts deviations of 0 us, bucket k deviations of 2^(k-1) to 2^k - 1 us, the last bucket also all the longer ones
+
+    struct oscSamplingJitter {
+        uint32_t samples = 0;                   // number of intervals measured
+        int64_t sum = 0;                        // in us, sum of absolute deviations
+        uint32_t maxOverrun = 0;                // in us, the most an interval has been longer than samplingTime
+        uint32_t missedDeadlines = 0;           // number of samples that have been skipped or taken a whole samplingTime (or more) late
+        uint32_t histogram [OSC_JITTER_BUCKETS] = {}; // of absolute deviations
+
+        inline void add (int64_t deviation, uint32_t missed) {
+            if (deviation > (int64_t) maxOverrun) maxOverrun = deviation > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) deviation;
+            if (deviation < 0) deviation = -deviation;
+            samples ++;
+            sum += deviation;
+            missedDeadlines += missed;
+            histogram [deviation ? min (64 - __builtin_clzll (deviation), OSC_JITTER_BUCKETS - 1) : 0] ++; // a single count leading zeros instruction
+        }
+
+        void merge (const oscSamplingJitter& other) {
+            samples += other.samples;
+            sum += other.sum;
+            if (other.maxOverrun > maxOverrun) maxOverrun = other.maxOverrun;
+            missedDeadlines += other.missedDeadlines;
+            for (int i = 0; i < OSC_JITTER_BUCKETS; i ++) histogram [i] += other.histogram [i];
+        }
+
+        // reports the jitter achieved with OSCILLOSCOPE_ISOLATION_PROFILE (only when isolation is used, otherwise it is available through oscSamplingJitterJson) and starts measuring again
+        void report () {
+            #if OSCILLOSCOPE_ISOLATION_PROFILE != OSC_ISOLATION_NONE
+                if (samples)
+                    cout << ( dmesgQueue << "[oscilloscope] isolation profile " << OSCILLOSCOPE_ISOLATION_PROFILE << ", sampling jitter: mean " << (unsigned long) (sum / samples) << " us, max overrun " << (unsigned long) maxOverrun << " us, " << (unsigned long) missedDeadlines << " missed deadlines over " << (unsigned long) samples << " samples" ) << endl;
+            #endif
+            *this = {};
+        }
+    };
+
+    // sampling jitter of all the oscReaders since ESP32 has started (or since it has been reset), oscSamplingTimers add theirs at the end of each screen
+    oscSamplingJitter __oscSamplingJitter__;
+    portMUX_TYPE __oscSamplingJitterLock__ = portMUX_INITIALIZER_UNLOCKED;
+
+    // returns sampling jitter statistics as JSON, so they can be served by HTTP server
+    String oscSamplingJitterJson (bool reset = false) {
+        portENTER_CRITICAL (&__oscSamplingJitterLock__);
+            oscSamplingJitter jitter = __oscSamplingJitter__;
+            if (reset) __oscSamplingJitter__ = {};
+        portEXIT_CRITICAL (&__oscSamplingJitterLock__);
+
+        String json = "{\"isolationProfile\":" + String (OSCILLOSCOPE_ISOLATION_PROFILE) + ",\"samples\":" + String ((unsigned long) jitter.samples) + ",\"meanUs\":" + String (jitter.samples ? (unsigned long) (jitter.sum / jitter.samples) : 0UL) +
+                      ",\"maxOverrunUs\":" + String ((unsigned long) jitter.maxOverrun) + ",\"missedDeadlines\":" + String ((unsigned long) jitter.missedDeadlines) + ",\"bucketsFromUs\":[";
+        for (int i = 0; i < OSC_JITTER_BUCKETS; i ++) json += String (i ? 1UL << (i - 1) : 0UL) + (i < OSC_JITTER_BUCKETS - 1 ? "," : "],\"histogram\":[");
+        for (int i = 0; i < OSC_JITTER_BUCKETS; i ++) json += String ((unsigned long) jitter.histogram [i]) + (i < OSC_JITTER_BUCKETS - 1 ? "," : "]}");
+        return json;
+    }
+
+    class oscSamplingTimer {
+
+        public:
+
+            // must be constructed by oscReader task itself since the timer will be notifying the task that constructed it
+            oscSamplingTimer (unsigned long samplingTimeMicroseconds) {
+                __samplingTime__ = samplingTimeMicroseconds;
+                if (samplingTimeMicroseconds < OSCILLOSCOPE_TIMER_MIN_SAMPLING_TIME)
+                    return; // busy-wait
+
+                gptimer_config_t timerConfig = {};
+                timerConfig.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+                timerConfig.direction = GPTIMER_COUNT_UP;
+                timerConfig.resolution_hz = 1000000; // 1 tick = 1 us
+                if (gptimer_new_timer (&timerConfig, &__timer__) != ESP_OK) {
+                    __timer__ = NULL;
+                    cout << ( dmesgQueue << "[oscilloscope] no free hardware timer, samples will be busy-waited" ) << endl;
+                    return;
+                }
+
+                gptimer_event_callbacks_t timerCallbacks = {};
+                timerCallbacks.on_alarm = __oscTimerAlarm__;
+                gptimer_alarm_config_t alarmConfig = {};
+                alarmConfig.alarm_count = samplingTimeMicroseconds;
+                alarmConfig.reload_count = 0;
+                alarmConfig.flags.auto_reload_on_alarm = true; // periodic alarm
+                if (gptimer_register_event_callbacks (__timer__, &timerCallbacks, xTaskGetCurrentTaskHandle ()) != ESP_OK || gptimer_set_alarm_action (__timer__, &alarmConfig) != ESP_OK || gptimer_enable (__timer__) != ESP_OK) {
+                    gptimer_del_timer (__timer__);
+                    __timer__ = NULL;
+                    cout << ( dmesgQueue << "[oscilloscope] could not set up hardware timer, samples will be busy-waited" ) << endl;
+                }
+            }
+
+            ~oscSamplingTimer () { end (); }
+
+            oscSamplingJitter jitter;               // of the samples this timer has paced
+
+            // release the hardware timer, oscReaders call this explicitly before reporting STOPPED so the timer is free for the next oscilloscope
+            void end () {
+                __publishJitter__ ();
+                jitter.report ();
+                if (__timer__) {
+                    stop ();
+                    gptimer_disable (__timer__);
+                    gptimer_del_timer (__timer__);
+                    __timer__ = NULL;
+                }
+            }
+
+            // (re)start the timing at the left of the screen, returns the time of the first sample in us
+            int64_t start () {
+                if (__timer__) {
+                    stop ();
+                    gptimer_set_raw_count (__timer__, 0);
+                    ulTaskNotifyTake (pdTRUE, 0); // forget alarms that may have been pending from the previous screen
+                    __running__ = gptimer_start (__timer__) == ESP_OK;
+                }
+                __lastSampleTime__ = __busySince__ = esp_timer_get_time ();
+                return __lastSampleTime__;
+            }
+
+            // stop the timing while waiting for the next screen refresh
+            void stop () {
+                __publishJitter__ ();
+                if (__timer__ && __running__) {
+                    gptimer_stop (__timer__);
+                    __running__ = false;
+                }
+            }
+
+            // wait until the next sample is due, returns the time of the sample in us
+            int64_t waitForNextSample () {
+                if (__running__) {
+                    uint32_t alarms = ulTaskNotifyTake (pdTRUE, pdMS_TO_TICKS (__samplingTime__ / 1000 + 100)); // time-out would only occur if something went wrong with the timer
+                    int64_t newSampleTime = esp_timer_get_time ();
+                    __measureInterval__ (newSampleTime - __lastSampleTime__, alarms > 1 ? alarms - 1 : 0); // the samples of the alarms that have been missed are skipped
+                    return __lastSampleTime__ = newSampleTime;
+                }
+
+                // busy-wait, but let the other tasks run if there is enough time left
+                int64_t remainingTime = __lastSampleTime__ + __samplingTime__ - esp_timer_get_time ();
+                if (remainingTime >= 2000 * portTICK_PERIOD_MS) {
+                    vTaskDelay (remainingTime / 1000 / portTICK_PERIOD_MS - 1);
+                    __busySince__ = esp_timer_get_time ();
+                }
+                #if OSCILLOSCOPE_ISOLATION_PROFILE == OSC_ISOLATION_PINNED_YIELDING
+                    // high priority oscReader pinned to APP_CPU would starve its idle task, yield on a measured budget (the sample will be late)
+                    if (esp_timer_get_time () - __busySince__ >= OSCILLOSCOPE_READER_BUSY_BUDGET) {
+                        vTaskDelay (1);
+                        __busySince__ = esp_timer_get_time ();
+                    }
+                #endif
+                int64_t newSampleTime;
+                while ((newSampleTime = esp_timer_get_time ()) - __lastSampleTime__ < __samplingTime__) delayMicroseconds (1);
+                __measureInterval__ (newSampleTime - __lastSampleTime__, newSampleTime - __lastSampleTime__ >= 2 * __samplingTime__);
+                return __lastSampleTime__ = newSampleTime;
+            }
+
+        private:
+
+            gptimer_handle_t __timer__ = NULL;
+            bool __running__ = false;
+            int64_t __samplingTime__;               // in us
+            int64_t __lastSampleTime__ = 0;         // in us
+            int64_t __busySince__ = 0;              // in us, when busy-waiting oscReader has last let the other tasks run
+            oscSamplingJitter __unpublishedJitter__;  // measured since it has been added to __oscSamplingJitter__ the last time
+
+            inline void __measureInterval__ (int64_t interval, uint32_t missed) {
+                jitter.add (interval - __samplingTime__, missed);
+                __unpublishedJitter__.add (interval - __samplingTime__, missed);
+            }
+
+            // add the jitter of the screen to the statistics of all the oscReaders
+            void __publishJitter__ () {
+                if (!__unpublishedJitter__.samples) return;
+                portENTER_CRITICAL (&__oscSamplingJitterLock__);
+                    __oscSamplingJitter__.merge (__unpublishedJitter__);
+                portEXIT_CRITICAL (&__oscSamplingJitterLock__);
+                __unpublishedJitter__ = {};
+            }
+
+    };
+
+
+    // oscPreTriggerBuffer oscPreTriggerBuffer oscPreTriggerBuffer oscPreTriggerBuffer oscPreTriggerBuffer oscPreTriggerBuffer oscPreTriggerBuffer oscPreTriggerBuffer
+
+    // While waiting for the trigger condition oscReaders keep the samples in a circular buffer at the beginning of the read-buffer. When the trigger condition
+    // occurs the circular buffer is rotated in place so that the oldest sample comes first and the rest of the screen is then appended after it.
+
+    template<typename sampleType>
+    struct oscPreTriggerBuffer {
+        sampleType *samples;                    // the beginning of read-buffer
+        unsigned int capacity;                  // number of samples kept before the trigger condition, at least 1
+        unsigned int count;                     // number of samples in circular buffer
+        unsigned int oldest;                    // position of the oldest sample once circular buffer is full
+
+        void clear (sampleType *buffer) { samples = buffer; count = oldest = 0; } // buffer is the slot oscReader is currently filling
+
+        void push (const sampleType& sample) {
+            if (count < capacity) {
+                samples [count ++] = sample;
+            } else {
+                samples [oldest] = sample;
+                if (++ oldest == capacity) oldest = 0;
+            }
+        }
+
+        // put the oldest sample at the beginning of read-buffer, returns the number of samples (the position where the trigger sample will go)
+        unsigned int linearize () {
+            std::rotate (samples, samples + oldest, samples + count);
+            oldest = 0;
+            return count;
+        }
+    };
+
+    // number of samples to be kept before the trigger condition, at least one sample is always kept since the trigger condition is detected by comparing two consecutive samples
+    unsigned int __oscPreTriggerSamples__ (unsigned int samplesPerScreen, unsigned int bufferSize, int preTriggerPercent) {
+        unsigned int preTriggerSamples = samplesPerScreen * preTriggerPercent / 100;
+        if (preTriggerSamples > bufferSize - 2) preTriggerSamples = bufferSize - 2; // leave some place for the trigger sample and (at least) one more
+        return preTriggerSamples < 1 ? 1 : preTriggerSamples;
+    }
+
+
+    // ADC calibration ADC calibration ADC calibration ADC calibration ADC calibration ADC calibration ADC calibration ADC calibration ADC calibration ADC calibration
+
+    // Raw ADC values are not linear (especially near the rails) and they differ from chip to chip. The calibration data from eFuses (or the default reference voltage if
+    // there is none) is turned into a 4096 entry lookup table only once, the first time it is needed, so oscReaders only do a single table lookup per sample. Calling
+    // esp_adc_cal_raw_to_voltage for each sample would be much too slow for the sampling times of a few us.
+
+    // characterizes ADC1 at OSCILLOSCOPE_ADC_ATTENUATION, returns 1 + esp_adc_cal_value_t (where the calibration data has come from) or 0 if ADC can't be calibrated
+    int __oscAdcCalibrationSource__ () {
+        #if __has_include (<esp_adc_cal.h>)
+            static int source = [] () -> int {
+                esp_adc_cal_characteristics_t characteristics;
+                return 1 + (int) esp_adc_cal_characterize (ADC_UNIT_1, OSCILLOSCOPE_ADC_ATTENUATION, ADC_WIDTH_BIT_12, OSCILLOSCOPE_ADC_DEFAULT_VREF, &characteristics);
+            } (); // static initialization runs only once even if more oscilloscopes start at the same time
+            return source;
+        #else
+            return 0;
+        #endif
+    }
+
+    // returns the table that translates raw ADC values into OSC_ANALOG_CALIBRATED or OSC_ANALOG_MILLIVOLTS values, NULL for OSC_ANALOG_RAW or if the table can't be built
+    const uint16_t *__oscAdcCalibrationTable__ (unsigned char analogUnit) {
+        #if __has_include (<esp_adc_cal.h>)
+            if (analogUnit == OSC_ANALOG_MILLIVOLTS) {
+                static const uint16_t *millivolts = [] () -> const uint16_t * {
+                    uint16_t *table = (uint16_t *) malloc (4096 * sizeof (uint16_t));
+                    if (!table) return NULL;
+                    esp_adc_cal_characteristics_t characteristics;
+                    esp_adc_cal_characterize (ADC_UNIT_1, OSCILLOSCOPE_ADC_ATTENUATION, ADC_WIDTH_BIT_12, OSCILLOSCOPE_ADC_DEFAULT_VREF, &characteristics);
+                    for (uint32_t raw = 0; raw < 4096; raw ++) table [raw] = esp_adc_cal_raw_to_voltage (raw, &characteristics);
+                    return table;
+                } (); // static initialization runs only once even if more oscilloscopes start at the same time
+                return millivolts;
+            }
+            if (analogUnit == OSC_ANALOG_CALIBRATED) {
+                static const uint16_t *calibrated = [] () -> const uint16_t * {
+                    const uint16_t *millivolts = __oscAdcCalibrationTable__ (OSC_ANALOG_MILLIVOLTS);
+                    uint16_t *table = (uint16_t *) malloc (4096 * sizeof (uint16_t));
+                    if (!millivolts || !table) { free (table); return NULL; }
+                    for (int raw = 0; raw < 4096; raw ++) table [raw] = min (((uint32_t) millivolts [raw] * 4095 + OSCILLOSCOPE_ADC_FULL_SCALE_MV / 2) / OSCILLOSCOPE_ADC_FULL_SCALE_MV, (uint32_t) 4095);
+                    return table;
+                } (); // static initialization runs only once even if more oscilloscopes start at the same time
+                return calibrated;
+            }
+        #endif
+        return NULL;
+    }
+
+    // oscTriggerMode oscTriggerMode oscTriggerMode oscTriggerMode oscTriggerMode oscTriggerMode oscTriggerMode oscTriggerMode oscTriggerMode oscTriggerMode
+
+    // Decides when oscReader starts the next screen. Normal mode waits for the trigger condition as long as it takes, Auto mode gives up after OSCILLOSCOPE_AUTO_TRIGGER_TIMEOUT
+    // and shows untriggered screen, Single mode stops sampling after the first triggered screen (javascript client arms it again with OSC_CMD_RECONFIGURE). Holdoff keeps the
+    // trigger disarmed for a while after each triggered screen. Screens are refreshed every screenRefreshMilliseconds, but a screen that has waited longer for the trigger
+    // condition is not followed by a burst of screens trying to catch up with the refresh period, so a rare event gets to javascript client right away.
+    struct oscTriggerMode {
+        unsigned char mode;                     // OSC_TRIGGER_NORMAL, OSC_TRIGGER_AUTO or OSC_TRIGGER_SINGLE
+        bool triggeredMode;                     // false if no trigger is set (free-run)
+        int64_t holdoff;                        // in us
+        TickType_t screenRefreshTicks;          // screen refresh period
+        TickType_t lastScreenRefreshTicks;      // for timing screen refresh intervals
+        TickType_t armedTicks;                  // when oscReader has started waiting for the trigger condition
+        int64_t rearmMicroseconds = 0;          // when holdoff ends
+
+        oscTriggerMode (void *sharedMemory, unsigned long screenRefreshMilliseconds) : mode (((oscSharedMemory *) sharedMemory)->triggerMode),
+                                                                                          triggeredMode (((oscSharedMemory *) sharedMemory)->positiveTrigger || ((oscSharedMemory *) sharedMemory)->negativeTrigger),
+                                                                                          holdoff (((oscSharedMemory *) sharedMemory)->holdoff),
+                                                                                          screenRefreshTicks (pdMS_TO_TICKS (screenRefreshMilliseconds)),
+                                                                                          lastScreenRefreshTicks (xTaskGetTickCount ()),
+                                                                                          armedTicks (lastScreenRefreshTicks) {}
+
+        // true if Auto mode has waited long enough for the trigger condition
+        bool autoTimeout () { return mode == OSC_TRIGGER_AUTO && xTaskGetTickCount () - armedTicks >= pdMS_TO_TICKS (OSCILLOSCOPE_AUTO_TRIGGER_TIMEOUT); }
+
+        // called after the screen has been passed to oscSender, returns false if oscReader should stop sampling (Single mode)
+        bool screenDone (bool triggered) {
+            if (triggered) rearmMicroseconds = esp_timer_get_time () + holdoff;
+            return !(mode == OSC_TRIGGER_SINGLE && (triggered || !triggeredMode));
+        }
+
+        // for oscReaders that keep sampling between the screens: true if the screen refresh is due and holdoff has passed
+        bool nextScreenDue () {
+            TickType_t now = xTaskGetTickCount ();
+            if (now - lastScreenRefreshTicks < screenRefreshTicks || esp_timer_get_time () < rearmMicroseconds) return false;
+            lastScreenRefreshTicks = armedTicks = now;
+            return true;
+        }
+
+        // for oscReaders that combine more screens into one: the next screen starts waiting for the trigger condition right away
+        void arm () { armedTicks = xTaskGetTickCount (); }
+
+        // for oscReaders that stop sampling between the screens: waits until the screen refresh is due and holdoff has passed
+        void waitForNextScreen () {
+            if (xTaskGetTickCount () - lastScreenRefreshTicks >= screenRefreshTicks) lastScreenRefreshTicks = xTaskGetTickCount (); // waiting for the trigger took longer than refresh period, don't catch up
+            else vTaskDelayUntil (&lastScreenRefreshTicks, screenRefreshTicks);
+            int64_t holdoffLeft;
+            while ((holdoffLeft = rearmMicroseconds - esp_timer_get_time ()) > 0) // holdoff is rounded up to whole ticks, vTaskDelay may end early within the first tick so check again
+                vTaskDelay ((holdoffLeft + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+            armedTicks = xTaskGetTickCount ();
+        }
+    };
+
+
+    // oscTriggerEngine oscTriggerEngine oscTriggerEngine oscTriggerEngine oscTriggerEngine oscTriggerEngine oscTriggerEngine oscTriggerEngine oscTriggerEngine
+
+    // Decides on which sample the trigger condition occurs. oscReaders feed it with the values of the trigger source (channel 1, channel 2 or a separate digital GPIO)
+    // one by one, I2S oscReader passes it the whole DMA buffer at once. Each treshold is checked by a comparator with hysteresis, so a noisy signal crosses it only once.
+    // Window and runt triggers use both tresholds as the boundaries. Each trigger type compiles into its own check_ (and its own scan_ loop for DMA buffers). The check_ of the
+    // trigger type is chosen only once, when oscTriggerEngine is constructed, so oscReaders that check one sample at a time don't test the type between the samples either.
+    struct oscTriggerEngine {
+
+        // comparator with hysteresis, the output goes high when value >= on and goes low when value < off
+        struct comparator {
+            int16_t on;
+            int16_t off;
+            bool high;
+
+            inline bool update (int16_t value) { // returns true if the output has changed
+                bool newHigh = high ? value >= off : value >= on;
+                if (newHigh == high) return false;
+                high = newHigh;
+                return true;
+            }
+
+            inline int16_t crossed () { return high ? on : off; } // the treshold the output has changed on
+        };
+
+        unsigned char type;                     // OSC_TRIGGER_EDGE, OSC_TRIGGER_WINDOW_ENTER, ...
+        unsigned char source;                   // OSC_TRIGGER_SOURCE_CH1, OSC_TRIGGER_SOURCE_CH2 or OSC_TRIGGER_SOURCE_GPIO
+        gpio_num_t gpio;                        // external trigger input with OSC_TRIGGER_SOURCE_GPIO
+        bool positive;                          // positive slope or pulse, positive runt
+        bool negative;                          // negative slope or pulse, negative runt
+        int64_t pulseWidth;                     // in us
+        comparator rising;                      // positive trigger treshold, the band of hysteresis lies below it
+        comparator falling;                     // negative trigger treshold, the band of hysteresis lies above it
+        comparator lower;                       // lower window boundary, the band of hysteresis lies outside the window
+        comparator upper;                       // upper window boundary, the band of hysteresis lies outside the window
+        bool first;                             // the first value after rearm () only sets the comparators
+        int64_t positivePulseStart;             // in us, -1 if the pulse has started before rearm ()
+        int64_t negativePulseStart;
+        bool positiveRunt;                      // the signal has risen above the lower boundary but it hasn't reached the upper one yet
+        bool negativeRunt;                      // the signal has fallen below the upper boundary but it hasn't reached the lower one yet
+        int16_t lastValue;                      // the value checked before the current one
+        uint8_t fraction = 0;                   // how far before the trigger sample the treshold has been crossed, in 1/256 of the interval between the samples
+        bool (oscTriggerEngine::*checkType) (int16_t value, int64_t microseconds); // check_ of the trigger type
+
+        oscTriggerEngine (void *sharedMemory) : type (((oscSharedMemory *) sharedMemory)->triggerType),
+                                                source (((oscSharedMemory *) sharedMemory)->triggerSource),
+                                                gpio ((gpio_num_t) ((oscSharedMemory *) sharedMemory)->triggerGpio),
+                                                positive (((oscSharedMemory *) sharedMemory)->positiveTrigger),
+                                                negative (((oscSharedMemory *) sharedMemory)->negativeTrigger),
+                                                pulseWidth (((oscSharedMemory *) sharedMemory)->pulseWidth) {
+            int16_t positiveTreshold = ((oscSharedMemory *) sharedMemory)->positiveTriggerTreshold;
+            int16_t negativeTreshold = ((oscSharedMemory *) sharedMemory)->negativeTriggerTreshold;
+            int16_t hysteresis = strcmp (((oscSharedMemory *) sharedMemory)->readType, "analog") ? 0 : ((oscSharedMemory *) sharedMemory)->hysteresis; // digital values are 0 and 1
+            if (source == OSC_TRIGGER_SOURCE_GPIO) {
+                gpio_hal_input_enable (&__gpio_hal__, gpio);
+                positiveTreshold = 1; negativeTreshold = 0; hysteresis = 0; // the levels of digital input
+            }
+            rising = { positiveTreshold, (int16_t) (positiveTreshold - hysteresis), false };
+            falling = { (int16_t) (negativeTreshold + 1 + hysteresis), (int16_t) (negativeTreshold + 1), false };
+            lower = { min (positiveTreshold, negativeTreshold), (int16_t) (min (positiveTreshold, negativeTreshold) - hysteresis), false };
+            upper = { (int16_t) (max (positiveTreshold, negativeTreshold) + 1 + hysteresis), (int16_t) (max (positiveTreshold, negativeTreshold) + 1), false };
+            switch (type) {
+                case OSC_TRIGGER_EDGE:          checkType = &oscTriggerEngine::check_<OSC_TRIGGER_EDGE>; break;
+                case OSC_TRIGGER_WINDOW_ENTER:  checkType = &oscTriggerEngine::check_<OSC_TRIGGER_WINDOW_ENTER>; break;
+                case OSC_TRIGGER_WINDOW_EXIT:   checkType = &oscTriggerEngine::check_<OSC_TRIGGER_WINDOW_EXIT>; break;
+                case OSC_TRIGGER_PULSE_LONGER:  checkType = &oscTriggerEngine::check_<OSC_TRIGGER_PULSE_LONGER>; break;
+                case OSC_TRIGGER_PULSE_SHORTER: checkType = &oscTriggerEngine::check_<OSC_TRIGGER_PULSE_SHORTER>; break;
+                default:                        checkType = &oscTriggerEngine::check_<OSC_TRIGGER_RUNT>; break;
+            }
+            rearm ();
+        }
+
+        // start waiting for the trigger condition
+        void rearm () {
+            first = true;
+            positivePulseStart = negativePulseStart = -1;
+            positiveRunt = negativeRunt = false;
+        }
+
+        // the value of the trigger source in a sample of 1 or 2 signals
+        template<typename sampleType>
+        inline int16_t value (const sampleType& sample) {
+            switch (source) {
+                case OSC_TRIGGER_SOURCE_CH1:    return sample.signal1;
+                case OSC_TRIGGER_SOURCE_CH2:    if constexpr (std::is_same<sampleType, osc2SignalsSample>::value) return sample.signal2;
+                                                else                                                              return sample.signal1;
+                default:                        return gpio_hal_get_level (&__gpio_hal__, gpio);
+            }
+        }
+
+        // the value of the trigger source in digital levels (bit 0 = gpio1, bit 1 = gpio2)
+        inline int16_t levelValue (unsigned int levels) {
+            switch (source) {
+                case OSC_TRIGGER_SOURCE_CH1:    return levels & 1;
+                case OSC_TRIGGER_SOURCE_CH2:    return (levels >> 1) & 1;
+                default:                        return gpio_hal_get_level (&__gpio_hal__, gpio);
+            }
+        }
+
+        // returns true if the trigger condition has occured on this value
+        inline bool check (int16_t value, int64_t microseconds) { return (this->*checkType) (value, microseconds); }
+
+        // streaming kernel for DMA buffer: checks values [from, to) taken samplingTime us apart, returns the index of the value on which the trigger condition has occured or to
+        int scan (const int16_t *values, int from, int to, int64_t microseconds, int samplingTime) {
+            switch (type) {
+                case OSC_TRIGGER_EDGE:          return scan_<OSC_TRIGGER_EDGE> (values, from, to, microseconds, samplingTime);
+                case OSC_TRIGGER_WINDOW_ENTER:  return scan_<OSC_TRIGGER_WINDOW_ENTER> (values, from, to, microseconds, samplingTime);
+                case OSC_TRIGGER_WINDOW_EXIT:   return scan_<OSC_TRIGGER_WINDOW_EXIT> (values, from, to, microseconds, samplingTime);
+                case OSC_TRIGGER_PULSE_LONGER:  return scan_<OSC_TRIGGER_PULSE_LONGER> (values, from, to, microseconds, samplingTime);
+                case OSC_TRIGGER_PULSE_SHORTER: return scan_<OSC_TRIGGER_PULSE_SHORTER> (values, from, to, microseconds, samplingTime);
+                default:                        return scan_<OSC_TRIGGER_RUNT> (values, from, to, microseconds, samplingTime);
+            }
+        }
+
+        template<unsigned char triggerType>
+        int scan_ (const int16_t *values, int from, int to, int64_t microseconds, int samplingTime) {
+            for (int i = from; i < to; i ++, microseconds += samplingTime)
+                if (check_<triggerType> (values [i], microseconds)) return i;
+            return to;
+        }
+
+        template<unsigned char triggerType>
+        inline bool check_ (int16_t value, int64_t microseconds) {
+            if (first) {
+                rising.high = value >= rising.on;
+                falling.high = value >= falling.off;
+                lower.high = value >= lower.on;
+                upper.high = value >= upper.off;
+                lastValue = value;
+                first = false;
+                return false;
+            }
+
+            bool triggered = false;
+            int16_t level = 0;                  // the treshold that has been crossed on the trigger sample
+
+            if constexpr (triggerType == OSC_TRIGGER_EDGE) {
+                if (positive && rising.update (value) && rising.high)    { triggered = true; level = rising.crossed (); }
+                if (negative && falling.update (value) && !falling.high) { triggered = true; level = falling.crossed (); }
+
+            } else if constexpr (triggerType == OSC_TRIGGER_WINDOW_ENTER || triggerType == OSC_TRIGGER_WINDOW_EXIT) {
+                bool wasInside = lower.high && !upper.high;
+                bool lowerChanged = lower.update (value);
+                upper.update (value);
+                bool inside = lower.high && !upper.high;
+                if constexpr (triggerType == OSC_TRIGGER_WINDOW_ENTER) triggered = inside && !wasInside;
+                else                                                   triggered = wasInside && !inside;
+                level = lowerChanged ? lower.crossed () : upper.crossed ();
+
+            } else if constexpr (triggerType == OSC_TRIGGER_PULSE_LONGER || triggerType == OSC_TRIGGER_PULSE_SHORTER) {
+                // the trigger condition occurs at the end of the pulse
+                auto widthMatches = [this] (int64_t pulseStart, int64_t pulseEnd) -> bool {
+                    if (pulseStart < 0) return false; // the pulse has started before rearm (), its width is not known
+                    if constexpr (triggerType == OSC_TRIGGER_PULSE_LONGER) return pulseEnd - pulseStart > pulseWidth;
+                    else                                                   return pulseEnd - pulseStart < pulseWidth;
+                };
+                if (positive && rising.update (value)) {
+                    if (rising.high)                                             positivePulseStart = microseconds;
+                    else if (widthMatches (positivePulseStart, microseconds))    { triggered = true; level = rising.crossed (); }
+                }
+                if (negative && falling.update (value)) {
+                    if (!falling.high)                                           negativePulseStart = microseconds;
+                    else if (widthMatches (negativePulseStart, microseconds))    { triggered = true; level = falling.crossed (); }
+                }
+
+            } else { // OSC_TRIGGER_RUNT
+                bool lowerChanged = lower.update (value);
+                bool upperChanged = upper.update (value);
+                if (lowerChanged && !lower.high && positiveRunt) { triggered = true; level = lower.crossed (); }
+                if (upperChanged && upper.high && negativeRunt)  { triggered = true; level = upper.crossed (); }
+                if (lowerChanged) positiveRunt = lower.high;  // a positive runt starts when the signal rises above the lower boundary ...
+                if (upper.high) positiveRunt = false;         // ... but it is not a runt if it reaches the upper boundary
+                if (upperChanged) negativeRunt = !upper.high; // the same for negative runt
+                if (!lower.high) negativeRunt = false;
+            }
+
+            // linear interpolation between the last value and the trigger sample tells where exactly the treshold has been crossed
+            if (triggered) {
+                int32_t f = value == lastValue ? 0 : ((int32_t) (value - level) << 8) / (value - lastValue);
+                fraction = f < 0 ? 0 : f > 255 ? 255 : f;
+            }
+            lastValue = value;
+            return triggered;
+        }
+    };
+
+
+    // oscMeasurements oscMeasurements oscMeasurements oscMeasurements oscMeasurements oscMeasurements oscMeasurements oscMeasurements oscMeasurements oscMeasurements
+
+    // Standard measurements of channel 1, calculated in one streaming pass over the analog samples of the screen from the trigger on (peak detect feeds it with the raw
+    // samples, not with the reduced ones). The pre-trigger part is left out in all the readers: peak detect doesn't keep the raw samples before the trigger, so this is
+    // the only window all the acquisition modes can measure alike. Untriggered screens are measured as a whole. Frequency and duty cycle are measured between the crossings of the same treshold (with the same hysteresis) the trigger uses, or of the middle level
+    // of the previous screen if there is no edge trigger on channel 1. Rise time is measured between 10 % and 90 % levels of the previous screen. Like the trigger position,
+    // the crossings are interpolated between the samples.
+    struct oscMeasurements {
+        bool enabled;                           // javascript client has asked for measurements
+        bool triggerLevel;                      // period is measured on trigger treshold, otherwise on the middle level of the previous screen
+        bool levelsKnown = false;               // the previous screen has had large enough amplitude to set the levels
+        oscTriggerEngine::comparator level;     // its crossings give period and duty cycle
+        oscTriggerEngine::comparator low;       // 10 % level
+        oscTriggerEngine::comparator high;      // 90 % level
+        // the current screen
+        bool first;                             // the first value only sets the comparators
+        int16_t minValue;
+        int16_t maxValue;
+        uint32_t count;                         // number of values measured
+        int64_t sum;
+        uint64_t sumOfSquares;
+        int16_t lastValue;
+        int64_t lastNanoseconds;
+        int64_t firstRising;                    // in ns, when the level has been crossed upwards for the first time, -1 if it hasn't been yet
+        int64_t lastRising;                     // in ns, when the level has been crossed upwards the last time
+        uint32_t risings;                       // number of upward crossings
+        int64_t highTime;                       // in ns, time above the level in complete periods
+        int64_t pendingHighTime;                // in ns, time above the level in the current period, it only counts when the period completes
+        int64_t lowCrossing;                    // in ns, when the signal has risen above 10 % level, -1 if it has fallen below it since
+        int64_t riseTime;                       // in ns, sum of all rise times
+        uint32_t rises;                         // number of rising edges from 10 % to 90 % level
+        int16_t clippedLow;                     // raw value 0 in the selected analog unit
+        int16_t clippedHigh;                    // raw value 4095 in the selected analog unit
+
+        oscMeasurements (void *sharedMemory) : enabled (((oscSharedMemory *) sharedMemory)->measurements),
+                                               triggerLevel ((((oscSharedMemory *) sharedMemory)->positiveTrigger || ((oscSharedMemory *) sharedMemory)->negativeTrigger) && ((oscSharedMemory *) sharedMemory)->triggerType == OSC_TRIGGER_EDGE && ((oscSharedMemory *) sharedMemory)->triggerSource == OSC_TRIGGER_SOURCE_CH1) {
+            // the same comparator as the trigger engine uses for edge triggers
+            const uint16_t *calibration = __oscAdcCalibrationTable__ (((oscSharedMemory *) sharedMemory)->analogUnit);
+            clippedLow = calibration ? calibration [0] : 0;
+            clippedHigh = calibration ? calibration [4095] : 4095;
+            int16_t hysteresis = ((oscSharedMemory *) sharedMemory)->hysteresis;
+            if (((oscSharedMemory *) sharedMemory)->positiveTrigger) {
+                int16_t positiveTreshold = ((oscSharedMemory *) sharedMemory)->positiveTriggerTreshold;
+                level = { positiveTreshold, (int16_t) (positiveTreshold - hysteresis), false };
+            } else {
+                int16_t negativeTreshold = ((oscSharedMemory *) sharedMemory)->negativeTriggerTreshold;
+                level = { (int16_t) (negativeTreshold + 1 + hysteresis), (int16_t) (negativeTreshold + 1), false };
+            }
+            begin ();
+        }
+
+        // start measuring a new screen
+        void begin () {
+            first = true;
+            count = 0;
+            sum = 0;
+            sumOfSquares = 0;
+            firstRising = lowCrossing = -1;
+            risings = rises = 0;
+            highTime = pendingHighTime = riseTime = 0;
+        }
+
+        // linear interpolation between the last value and this one tells when exactly the treshold has been crossed
+        inline int64_t crossing (int16_t treshold, int16_t value, int64_t nanoseconds) {
+            if (value == lastValue) return nanoseconds;
+            return nanoseconds - (nanoseconds - lastNanoseconds) * (value - treshold) / (value - lastValue);
+        }
+
+        // adds the next value, taken at microseconds from any reference
+        inline void add (int16_t value, int64_t microseconds) {
+            int64_t nanoseconds = microseconds * 1000;
+            if (first) {
+                first = false;
+                minValue = maxValue = value;
+                level.high = value >= level.on;
+                low.high = value >= low.on;
+                high.high = value >= high.on;
+            } else {
+                if (value < minValue) minValue = value;
+                if (value > maxValue) maxValue = value;
+
+                // period and duty cycle
+                if ((triggerLevel || levelsKnown) && level.update (value)) {
+                    int64_t t = crossing (level.crossed (), value, nanoseconds);
+                    if (level.high) {
+                        if (firstRising < 0) firstRising = t;
+                        else                 highTime += pendingHighTime; // the period is complete
+                        pendingHighTime = 0;
+                        lastRising = t;
+                        risings ++;
+                    } else if (firstRising >= 0) {
+                        pendingHighTime = t - lastRising;
+                    }
+                }
+
+                // rise time
+                if (levelsKnown) {
+                    if (low.update (value)) lowCrossing = low.high ? crossing (low.crossed (), value, nanoseconds) : -1;
+                    if (high.update (value) && high.high && lowCrossing >= 0) {
+                        riseTime += crossing (high.crossed (), value, nanoseconds) - lowCrossing;
+                        rises ++;
+                        lowCrossing = -1;
+                    }
+                }
+            }
+            count ++;
+            sum += value;
+            sumOfSquares += (uint32_t) ((int32_t) value * value);
+            lastValue = value;
+            lastNanoseconds = nanoseconds;
+        }
+
+        // puts the measurements of the screen into the frame, sets the levels for the next screen and starts measuring it
+        void end (oscSamples *frame) {
+            if (!count) return;
+            uint32_t period = risings >= 2 ? (uint32_t) min ((lastRising - firstRising) / (risings - 1), (int64_t) 0xFFFFFFFF) : 0;
+            uint32_t rise = rises ? (uint32_t) min (riseTime / rises, (int64_t) 0xFFFFFFFF) : 0;
+            frame->measurements = { (uint16_t) ((minValue <= clippedLow ? OSC_MEASURED_CLIPPED_LOW : 0) | (maxValue >= clippedHigh ? OSC_MEASURED_CLIPPED_HIGH : 0)),
+                                    minValue,
+                                    maxValue,
+                                    (uint16_t) (sum * 16 / count),
+                                    (uint16_t) min (lround (sqrt ((double) sumOfSquares / count) * 16), 65535L),
+                                    { (uint16_t) (period >> 16), (uint16_t) (period & 0xFFFF) },
+                                    (uint16_t) (period ? highTime * 1000 / (lastRising - firstRising) : 0),
+                                    { (uint16_t) (rise >> 16), (uint16_t) (rise & 0xFFFF) },
+                                    { (uint16_t) (count >> 16), (uint16_t) (count & 0xFFFF) } };
+            frame->header.flags |= OSC_FRAME_MEASURED;
+
+            int16_t amplitude = maxValue - minValue;
+            levelsKnown = amplitude >= OSCILLOSCOPE_MEASUREMENT_MIN_AMPLITUDE; // the crossings of the noise alone don't mean anything
+            if (levelsKnown) {
+                int16_t hysteresis = amplitude / 20;
+                if (!triggerLevel) level = { (int16_t) (minValue + amplitude / 2 + hysteresis / 2), (int16_t) (minValue + amplitude / 2 - hysteresis / 2), false };
+                low = { (int16_t) (minValue + amplitude / 10), (int16_t) (minValue + amplitude / 10 - hysteresis), false };
+                high = { (int16_t) (maxValue - amplitude / 10), (int16_t) (maxValue - amplitude / 10 - hysteresis), false };
+            }
+            begin ();
+        }
+    };
+
+
+    // oscAcquisition oscAcquisition oscAcquisition oscAcquisition oscAcquisition oscAcquisition oscAcquisition oscAcquisition oscAcquisition oscAcquisition
+
+    // Combines consecutive screens of continuously sampled (I2S) analog signal into one screen before it is sent, so the combined screen takes no more WiFi bandwidth than
+    // a single one. The screens are aligned by the trigger, so the samples with the same index are taken at the same time relative to the trigger condition.
+    //  - average of N screens removes uncorrelated ADC noise, the sums are kept in 32 bit accumulators
+    //  - envelope keeps min and max value of each sample over N screens
+    //  - persistence keeps decaying envelope of all the screens: the signal widens it immediately, but it only shrinks back towards the signal by 1/N at each screen
+    // Average and envelope are sent after every N screens, persistence at every screen refresh. Envelope and persistence are sent as equally spaced (min, max) pairs.
+    // When a trigger is set only the screens with the same trigger position are combined, untriggered screens of Auto mode are sent as they are.
+    struct oscAcquisition {
+        unsigned char mode;                     // OSC_ACQUISITION_NORMAL, OSC_ACQUISITION_AVERAGE, OSC_ACQUISITION_ENVELOPE or OSC_ACQUISITION_PERSISTENCE
+        int frames;                             // N
+        int32_t *lower = NULL;                  // sums (average), min values (envelope) or min values in 1/256 (persistence) of each sample
+        int32_t *upper = NULL;                  // max values (envelope) or max values in 1/256 (persistence) of each sample
+        int combined = 0;                       // number of screens combined so far
+        int16_t triggerPosition;                // of the first combined screen, the screens that are not aligned with it are skipped
+
+        oscAcquisition (void *sharedMemory) : mode (((oscSharedMemory *) sharedMemory)->acquisition),
+                                              frames (((oscSharedMemory *) sharedMemory)->acquisitionFrames) {}
+
+        inline bool enabled () { return mode != OSC_ACQUISITION_NORMAL; }
+
+        inline bool continuous () { return mode == OSC_ACQUISITION_PERSISTENCE; } // combines all the screens, not just N of them
+
+        // the accumulators are too large for oscReader's stack, returns false if there is not enough memory
+        bool begin (unsigned int samplesPerScreen) {
+            if (!enabled ()) return true;
+            lower = (int32_t *) malloc ((mode == OSC_ACQUISITION_AVERAGE ? 1 : 2) * samplesPerScreen * sizeof (int32_t));
+            if (lower && mode != OSC_ACQUISITION_AVERAGE) upper = lower + samplesPerScreen;
+            return lower != NULL;
+        }
+
+        void end () { free (lower); lower = upper = NULL; }
+
+        // combines the (full) screen of frame, whose samples may be kept outside of it, with the previous ones, returns true if frame (or its samples) has been replaced by the combined screen that should be sent now
+        bool combine (oscSamples *frame, oscI2sSample *samples, bool screenRefreshDue) {
+            unsigned int n = frame->sampleCount;
+            if (!combined) triggerPosition = frame->header.triggerPosition;
+            else if (frame->header.triggerPosition != triggerPosition) return false; // pre-trigger buffer hasn't been filled up yet, the samples are not aligned with the previous screens
+            switch (mode) {
+                case OSC_ACQUISITION_AVERAGE:
+                    if (!combined) for (unsigned int k = 0; k < n; k ++) lower [k] = samples [k].signal1;
+                    else           for (unsigned int k = 0; k < n; k ++) lower [k] += samples [k].signal1;
+                    if (++ combined < frames) return false;
+                    for (unsigned int k = 0; k < n; k ++) samples [k].signal1 = (lower [k] + frames / 2) / frames; // rounded
+                    combined = 0;
+                    return true;
+
+                case OSC_ACQUISITION_ENVELOPE:
+                    if (!combined) {
+                        for (unsigned int k = 0; k < n; k ++) lower [k] = upper [k] = samples [k].signal1;
+                    } else {
+                        for (unsigned int k = 0; k < n; k ++) {
+                            if (samples [k].signal1 < lower [k]) lower [k] = samples [k].signal1;
+                            if (samples [k].signal1 > upper [k]) upper [k] = samples [k].signal1;
+                        }
+                    }
+                    if (++ combined < frames) return false;
+                    toEnvelope (frame, 0);
+                    combined = 0;
+                    return true;
+
+                default: // OSC_ACQUISITION_PERSISTENCE
+                    if (!combined) {
+                        for (unsigned int k = 0; k < n; k ++) lower [k] = upper [k] = samples [k].signal1 << 8;
+                    } else {
+                        for (unsigned int k = 0; k < n; k ++) {
+                            int32_t value = samples [k].signal1 << 8;
+                            lower [k] = value < lower [k] ? value : lower [k] + (value - lower [k]) / frames;
+                            upper [k] = value > upper [k] ? value : upper [k] - (upper [k] - value) / frames;
+                        }
+                    }
+                    combined = 1;
+                    if (!screenRefreshDue) return false;
+                    toEnvelope (frame, 8);
+                    return true;
+            }
+        }
+
+        // (min, max) pairs take twice as much space as the samples, the neighbouring samples are merged if the pairs don't fit in the frame
+        void toEnvelope (oscSamples *frame, int fractionBits) {
+            unsigned int n = frame->sampleCount;
+            unsigned int step = (n + OSCILLOSCOPE_ENVELOPE_BUFFER_SIZE - 1) / OSCILLOSCOPE_ENVELOPE_BUFFER_SIZE;
+            unsigned int pairs = 0;
+            for (unsigned int k = 0; k < n; k += step, pairs ++) {
+                int32_t minValue = lower [k], maxValue = upper [k];
+                for (unsigned int m = k + 1; m < k + step && m < n; m ++) {
+                    if (lower [m] < minValue) minValue = lower [m];
+                    if (upper [m] > maxValue) maxValue = upper [m];
+                }
+                frame->envelope [pairs] = { (int16_t) (minValue >> fractionBits), (int16_t) ((maxValue + (1 << fractionBits) - 1) >> fractionBits) };
+            }
+            frame->header.frameType = OSC_FRAME_ENVELOPE;
+            frame->header.samplingTime *= step;
+            if (frame->header.triggerPosition >= 0) frame->header.triggerPosition /= step;
+            frame->header.flags &= ~OSC_FRAME_TRIGGER_FRACTION; // the trigger sample has been merged with its neighbours
+            frame->sampleCount = pairs;
+        }
+    };
 
 
     // oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders oscReaders 
 
 
-    // The most general purpose and slow oscReader
-    //  - it can read 1 or 2 digital signals
+    // oscSampler takes one sample of 1 or 2 signals. Everything that is known before the sampling starts (number of signals, digitalRead or analogRead and 
+    // inversion of analog values) is a template parameter, so each combination compiles into its own code without any tests between the samples.
+    template<unsigned char noOfSignals, bool doAnalogRead, bool invertAdc1>
+    struct oscSampler {
+        typedef typename std::conditional<noOfSignals == 1, osc1SignalSample, osc2SignalsSample>::type sampleType;
+        static constexpr unsigned int bufferSize = noOfSignals == 1 ? OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE : OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE;
+        static constexpr int16_t frameType = noOfSignals == 1 ? OSC_FRAME_1_SIGNAL : OSC_FRAME_2_SIGNALS;
+
+        gpio_num_t gpio1;                       // gpio1 should always be valid PIN
+        gpio_num_t gpio2;                       // only used for 2 signals
+        adc1_channel_t adcchannel1;             // only used with analogRead
+        adc1_channel_t adcchannel2;             // only used with analogRead of 2 signals
+        const uint16_t *calibration;            // ADC calibration table, NULL if raw analog values are sent
+
+        static sampleType *samples (oscSamples *buffer) {
+            if constexpr (noOfSignals == 1) return buffer->samples1Signal;
+            else                            return buffer->samples2Signals;
+        }
+
+        inline int16_t readSignal (gpio_num_t gpio, adc1_channel_t adcchannel) {
+            if constexpr (doAnalogRead) {
+                int16_t raw;
+                if constexpr (invertAdc1) raw = ~adc1_get_raw (adcchannel) & 0xFFF;
+                else                      raw = adc1_get_raw (adcchannel) & 0xFFF;
+                return calibration ? calibration [raw] : raw; // a single table lookup
+            } else {
+                return gpio_hal_get_level (&__gpio_hal__, gpio);
+            }
+        }
+
+        inline sampleType take (int16_t deltaTime) {
+            if constexpr (noOfSignals == 1) return { readSignal (gpio1, adcchannel1), deltaTime };
+            else                            return { readSignal (gpio1, adcchannel1), readSignal (gpio2, adcchannel2), deltaTime }; // signal1 is always read first
+        }
+    };
+
+
+    // oscReader that takes samples on time interval specified in milliseconds or microseconds
+    //  - it can read 1 or 2 digital signals in milliseconds (oscReader_transitions reads digital signals in microseconds)
     //  - it can read 1 or 2 analog signals
-    //  - it can work in 'sample at a time' more or 'screen at a time' mode
-    // The only drawback is that samplingTime and screenWidthTime must be specified in milliseconds
-    void oscReader_millis (void *sharedMemory) {
-        bool doAnalogRead =                 !strcmp (((oscSharedMemory *) sharedMemory)->readType, "analog");
-        // *not needed* bool unitIsMicroSeconds =           !strcmp (((oscSharedMemory *) sharedMemory)->samplingTimeUnit, "us");
+    //  - in milliseconds it can work in 'sample at a time' or 'screen at a time' mode, in microseconds only in 'screen at a time' mode (which is not a drawback for the sampling is measured in microseconds)
+    // runOscilloscope picks the right combination of template parameters once, before the sampling starts
+    template<unsigned char noOfSignals, bool doAnalogRead, bool inMilliseconds>
+    void oscReader_timed (void *sharedMemory) {
+        static_assert (doAnalogRead || inMilliseconds, "digital signals sampled in us are read by oscReader_transitions");
+        typedef oscSampler<noOfSignals, doAnalogRead, __oscInvertAdc1__> sampler_t;
+        typedef typename sampler_t::sampleType sampleType;
+
         int samplingTime =                  ((oscSharedMemory *) sharedMemory)->samplingTime;
         bool positiveTrigger =              ((oscSharedMemory *) sharedMemory)->positiveTrigger;
         bool negativeTrigger =              ((oscSharedMemory *) sharedMemory)->negativeTrigger;
-        gpio_num_t gpio1 =                  (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio1; // easier to check validity with unsigned char then with integer 
-        gpio_num_t gpio2 =                  (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio2; // easier to check validity with unsigned char then with integer
-        unsigned char noOfSignals = 1; if (gpio2 <= 39) noOfSignals = 2;  // monitor 1 or 2 signals
-        adc1_channel_t adcchannel1 =        ((oscSharedMemory *) sharedMemory)->adcchannel1;
-        adc1_channel_t adcchannel2 =        ((oscSharedMemory *) sharedMemory)->adcchannel2;
+        sampler_t sampler = {               (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio1, 
+                                            (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio2, 
+                                            ((oscSharedMemory *) sharedMemory)->adcchannel1, 
+                                            ((oscSharedMemory *) sharedMemory)->adcchannel2,
+                                            __oscAdcCalibrationTable__ (((oscSharedMemory *) sharedMemory)->analogUnit) };
         int positiveTriggerTreshold =       ((oscSharedMemory *) sharedMemory)->positiveTriggerTreshold;
         int negativeTriggerTreshold =       ((oscSharedMemory *) sharedMemory)->negativeTriggerTreshold;
         unsigned long screenWidthTime =     ((oscSharedMemory *) sharedMemory)->screenWidthTime; 
-        oscSamples *readBuffer =            &((oscSharedMemory *) sharedMemory)->readBuffer;
-        oscSamples *sendBuffer =            &((oscSharedMemory *) sharedMemory)->sendBuffer;
+        int preTriggerPercent =             ((oscSharedMemory *) sharedMemory)->preTriggerPercent;
+        oscFrameQueue *frameQueue =         &((oscSharedMemory *) sharedMemory)->frameQueue;
+        oscSamples *readBuffer =            frameQueue->writeSlot ();
 
         // Is samplingTime large enough to fill the whole screen? If not, make a correction.
-        if (noOfSignals == 1) {
-            if ((unsigned long) samplingTime * (OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE - 1) < screenWidthTime) {
-                samplingTime = max ((int) (screenWidthTime / (OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
-                __oscilloscope_h_debug__ ("oscReader_millis: 1 signal samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
-            }
-        } else {
-            if ((unsigned long) samplingTime * (OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE - 1) < screenWidthTime) {
-                samplingTime = max ((int) (screenWidthTime / (OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
-                __oscilloscope_h_debug__ ("oscReader_millis: 2 signals samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
-            }
+        if ((unsigned long) samplingTime * (sampler_t::bufferSize - 1) < screenWidthTime) {
+            samplingTime = max ((int) (screenWidthTime / (sampler_t::bufferSize - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
+            __oscilloscope_h_debug__ ("oscReader_timed: " + String (noOfSignals) + " signal(s) samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
         }
         // Is samplingTime is too long for 15 bits, make a correction. Max sample time can be 32767 (15 bits) but since in some case actual sample time can be much larger than required le's keep it below 5000.
         if (samplingTime > 5000) {
                 samplingTime = 5000;
-                __oscilloscope_h_debug__ ("oscReader_millis: samplingTime was too long (to fit in 15 bits in (almost?) all cases) and is corrected to " + String (samplingTime));
-        }        
+                __oscilloscope_h_debug__ ("oscReader_timed: samplingTime was too long (to fit in 15 bits in (almost?) all cases) and is corrected to " + String (samplingTime));
+        }
 
         /*
-        cout << "----- oscReader_millis () -----\r\n";
-        cout << "samplingTime " << samplingTime << " ms" << endl;
+        cout << "----- oscReader_timed () -----\r\n";
+        cout << "samplingTime " << samplingTime << (inMilliseconds ? " ms" : " us") << endl;
         cout << "positiveTrigger " << positiveTrigger << endl;
         cout << "negativeTrigger " << negativeTrigger << endl;
-        cout << "gpio1 " << gpio1 << endl;
-        cout << "gpio2 " << gpio2 << endl;
+        cout << "gpio1 " << sampler.gpio1 << endl;
+        cout << "gpio2 " << sampler.gpio2 << endl;
         cout << "noOfSignals " << noOfSignals << endl;
         cout << "positiveTriggerTreshold " << positiveTriggerTreshold << endl;
         cout << "negativeTriggerTreshold " << negativeTriggerTreshold << endl;
         cout << "screenWidthTime " << screenWidthTime << endl;
+        cout << "max number of sampels " << sampler_t::bufferSize << endl;
+        cout << "max possible screenWidthTime covered by sampels " << samplingTime * sampler_t::bufferSize << endl;
         delay (100);
         */
 
@@ -199,99 +1425,105 @@
         int noOfSamplesPerScreen = screenWidthTime / samplingTime; if (noOfSamplesPerScreen * samplingTime < screenWidthTime) noOfSamplesPerScreen ++;
         unsigned long correctedScreenWidthTime = noOfSamplesPerScreen * samplingTime;                         
         screenRefreshMilliseconds = correctedScreenWidthTime >= 50000 ? correctedScreenWidthTime / 1000 : ((50500 / correctedScreenWidthTime) * correctedScreenWidthTime) / 1000;
-        __oscilloscope_h_debug__ ("oscReader_millis: samplingTime = " + String (samplingTime) + ", screenWidthTime = " + String (screenWidthTime));
+        __oscilloscope_h_debug__ ("oscReader_timed: samplingTime = " + String (samplingTime) + ", screenWidthTime = " + String (screenWidthTime));
 
-        // determine mode of operation sample at a time or screen at a time - this only makes sense when screenWidthTime is measured in ms
-        bool oneSampleAtATime = screenWidthTime > 1000;
+        // circular buffer for the samples taken before the trigger condition occurs
+        oscPreTriggerBuffer<sampleType> preTrigger = { NULL, __oscPreTriggerSamples__ (noOfSamplesPerScreen, sampler_t::bufferSize, preTriggerPercent), 0, 0 };
 
-        readBuffer->samplesAreReady = true; // this information will be always copied to sendBuffer together with the samples
+        // determine mode of operation sample at a time or screen at a time - this only makes sense when screenWidthTime is measured in ms
+        bool oneSampleAtATime = inMilliseconds && screenWidthTime > 1000;
 
         // enable GPIO reading even if it is not configured so
-        if (!doAnalogRead) {
-            if (gpio1 <= 39) gpio_hal_input_enable (&__gpio_hal__, gpio1);
-            if (gpio2 <= 39) gpio_hal_input_enable (&__gpio_hal__, gpio2);
+        if constexpr (!doAnalogRead) {
+            if (sampler.gpio1 < SOC_GPIO_PIN_COUNT) gpio_hal_input_enable (&__gpio_hal__, sampler.gpio1);
+            if (sampler.gpio2 < SOC_GPIO_PIN_COUNT) gpio_hal_input_enable (&__gpio_hal__, sampler.gpio2);
         }
 
-        // wait for the START signal
-        while (((oscSharedMemory *) sharedMemory)->oscReaderState != START) delay (1);
-        ((oscSharedMemory *) sharedMemory)->oscReaderState = STARTED; 
+        // acknowledge the START signal (the settings that exceed oscilloscope capabilities have already been rejected by __oscConfigure__)
+        __oscReaderStarted__ (sharedMemory, samplingTime, correctedScreenWidthTime);
 
-        // --- do the sampling, samplingTime and screenWidthTime are in us ---
+        // --- do the sampling, samplingTime and screenWidthTime are in ms or us ---
 
         // triggered or untriggered mode of operation
         bool triggeredMode = positiveTrigger || negativeTrigger;
 
-        TickType_t lastScreenRefreshTicks = xTaskGetTickCount ();               // for timing screen refresh intervals            
+        // hardware timer that paces the samples
+        oscSamplingTimer samplingTimer (inMilliseconds ? samplingTime * 1000 : samplingTime); // samplingTimer works in us
+
+        // time between two samples in ms or us
+        auto deltaTimeBetween = [] (int64_t lastSampleMicroseconds, int64_t newSampleMicroseconds) -> unsigned long {
+            if constexpr (inMilliseconds) return newSampleMicroseconds / 1000 - lastSampleMicroseconds / 1000;
+            else                          return newSampleMicroseconds - lastSampleMicroseconds;
+        };
+
+        oscTriggerMode trigger (sharedMemory, screenRefreshMilliseconds);      // trigger mode, holdoff and screen refresh timing
+        oscTriggerEngine triggerEngine (sharedMemory);                          // trigger condition
+        oscMeasurements measurements (sharedMemory);                            // Vpp, Vrms, frequency, ... of the screen
 
         while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { // sampling from the left of the screen - while not getting STOP signal
 
-            int screenTime = 0;                                                 // in ms - how far we have already got from the left of the screen (we'll compare this value with screenWidthTime)
-            unsigned long deltaTime = 0;                                        // in ms - delta from previous sample
-            TickType_t lastSampleTicks = xTaskGetTickCount ();                  // for sample timing                
-            TickType_t newSampleTicks = lastSampleTicks;
-            // Insert first dummy sample to read-buffer this tells javascript client to start drawing from the left of the screen. Please note that it also tells javascript client how many signals are in each sample
-            if (noOfSignals == 1) readBuffer->samples1Signal [0] = {-2, -2}; // no real data sample can look like this
-            else                  readBuffer->samples2Signals [0] = {-3, -3, -3}; // no real data sample can look like this
-            readBuffer->sampleCount = 1;
+            unsigned long screenTime = 0;                                       // in ms or us - how far we have already got from the left of the screen (we'll compare this value with screenWidthTime)
+            unsigned long deltaTime = 0;                                        // in ms or us - delta from previous sample
+            int64_t lastSampleMicroseconds = samplingTimer.start ();            // for sample timing, the first sample is taken right away
+            int64_t newSampleMicroseconds = lastSampleMicroseconds;
 
+            // Frame header tells javascript client to start drawing from the left of the screen. Please note that it also tells javascript client how many signals are in each sample
+            readBuffer = frameQueue->writeSlot ();
+            readBuffer->header = { sampler_t::frameType, 0, -1, 0 };
+            readBuffer->sampleCount = 0;
+            sampleType *samples = sampler_t::samples (readBuffer);
+
+            bool triggeredScreen = false;                                       // true when the trigger condition has occured on this screen
             if (triggeredMode) { // if no trigger is set then skip this (waiting) part and start sampling immediatelly
 
                 // take the first sample
-                union {
-                    osc1SignalSample last1SignalSample;
-                    osc2SignalsSample last2SignalsSample;
-                };
+                sampleType lastSample = sampler.take (0);
 
-                #ifdef INVERT_ADC1_GET_RAW
-                    if (noOfSignals == 1) { if (doAnalogRead) last1SignalSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) 0}; else last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) 0}; } // gpio1 should always be valid PIN
-                    else                  { if (doAnalogRead) last2SignalsSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (~adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) 0}; else last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) 0}; } // gpio1 should always be valid PIN
-                #else
-                    if (noOfSignals == 1) { if (doAnalogRead) last1SignalSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) 0}; else last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) 0}; } // gpio1 should always be valid PIN
-                    else                  { if (doAnalogRead) last2SignalsSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) 0}; else last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) 0}; } // gpio1 should always be valid PIN
-                #endif
+                // keep the samples in circular buffer while waiting for trigger condition
+                preTrigger.clear (samples);
+                preTrigger.push (lastSample);
+                triggerEngine.rearm ();
+                triggerEngine.check (triggerEngine.value (lastSample), lastSampleMicroseconds); // the first value only sets the comparators
 
                 // wait for trigger condition
                 while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { 
-                    // wait befor continuing to next sample and calculate delta offset for it
-                    vTaskDelayUntil (&newSampleTicks, pdMS_TO_TICKS (samplingTime));
-                    deltaTime = pdTICKS_TO_MS (newSampleTicks - lastSampleTicks); // in ms - this value will be used for the next sample offset
-                    lastSampleTicks = newSampleTicks;
+                    // wait for the hardware timer befor continuing to next sample and calculate delta offset for it
+                    newSampleMicroseconds = samplingTimer.waitForNextSample ();
+                    deltaTime = deltaTimeBetween (lastSampleMicroseconds, newSampleMicroseconds);
+                    lastSampleMicroseconds = newSampleMicroseconds;
 
                     // take the second sample
-                    union {
-                        osc1SignalSample new1SignalSample;
-                        osc2SignalsSample new2SignalsSample;
-                    };
-
-                    #ifdef INVERT_ADC1_GET_RAW
-                        if (noOfSignals == 1) { if (doAnalogRead) new1SignalSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) deltaTime}; else last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                        else                  { if (doAnalogRead) new2SignalsSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) ~(adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) deltaTime}; else last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                    #else
-                        if (noOfSignals == 1) { if (doAnalogRead) new1SignalSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) deltaTime}; else last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                        else                  { if (doAnalogRead) new2SignalsSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) deltaTime}; else last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                    #endif
-
-                    // Compare both samples to check if the trigger condition has occured, only gpio1 is used to trigger the sampling. Please note that it doesn't matter wether we compare last1SignalSample or last2SignalsSample since they share the same space and signal1 is always on the same place.
-                    if ((positiveTrigger && last2SignalsSample.signal1 < positiveTriggerTreshold && new2SignalsSample.signal1 >= positiveTriggerTreshold) || (negativeTrigger && last2SignalsSample.signal1 > negativeTriggerTreshold && new2SignalsSample.signal1 <= negativeTriggerTreshold)) { 
-                        // trigger condition has occured, insert both samples into read buffer
-                        if (noOfSignals == 1) { readBuffer->samples1Signal [1] = last1SignalSample; readBuffer->samples1Signal [2] = new1SignalSample; } // timeOffset (from left of the screen) = 0, this is the first sample after triggered
-                        else                  { readBuffer->samples2Signals [1] = last2SignalsSample; readBuffer->samples2Signals [2] = new2SignalsSample; } // timeOffset (from left of the screen) = 0, this is the first sample after triggered
-                        screenTime = deltaTime;     // start measuring screen time from new sample on
-                        readBuffer->sampleCount = 3;
-                
-                        // correct screenTime
-                        screenTime = deltaTime;
-
-                        // wait befor continuing to next sample and calculate delta offset for it
-                        vTaskDelayUntil (&newSampleTicks, pdMS_TO_TICKS (samplingTime));
-                        deltaTime = pdTICKS_TO_MS (newSampleTicks - lastSampleTicks); // in ms - this value will be used for the next sample offset
-                        lastSampleTicks = newSampleTicks;
+                    sampleType newSample = sampler.take ((int16_t) deltaTime);
+
+                    // check if the trigger condition has occured on the trigger source
+                    if (triggerEngine.check (triggerEngine.value (newSample), newSampleMicroseconds)) { 
+                        // trigger condition has occured, put the samples from circular buffer in the right order and append the new sample after them
+                        unsigned int triggerPosition = preTrigger.linearize ();
+                        samples [0].deltaTime = 0; // timeOffset (from left of the screen) = 0, start measuring screen time from the oldest sample on
+                        for (unsigned int i = 1; i < triggerPosition; i ++) screenTime += samples [i].deltaTime;
+                        samples [triggerPosition] = newSample; // this is the first sample after triggered
+                        screenTime += deltaTime;
+                        readBuffer->header.triggerPosition = triggerPosition;
+                        readBuffer->header.flags |= triggerEngine.fraction << 8; // javascript client shifts the screen by this fraction of deltaTime so that the crossing always lands on the same place
+                        readBuffer->sampleCount = triggerPosition + 1;
+
+                        // wait for the hardware timer befor continuing to next sample and calculate delta offset for it
+                        newSampleMicroseconds = samplingTimer.waitForNextSample ();
+                        deltaTime = deltaTimeBetween (lastSampleMicroseconds, newSampleMicroseconds);
+                        lastSampleMicroseconds = newSampleMicroseconds;
                             
+                        triggeredScreen = true;
                         break; // trigger event occured, stop waiting and proceed to sampling
                     } else {
-                        // Just forget the first sample and continue waiting for trigger condition - copy just signal values and let the timing start from 0. Please note that it doesn't matter wether we move new1SignalSample or new2SignalsSample since they share the same space.
-                        last2SignalsSample.signal1 = new2SignalsSample.signal1;
-                        last2SignalsSample.signal2 = new2SignalsSample.signal2;
+                        // keep the new sample in circular buffer and continue waiting for trigger condition
+                        preTrigger.push (newSample);
+                        lastSample = newSample;
+                        if (trigger.autoTimeout ()) { // no trigger condition for too long, show untriggered screen
+                            newSampleMicroseconds = samplingTimer.waitForNextSample ();
+                            lastSampleMicroseconds = newSampleMicroseconds;
+                            deltaTime = 0; // the next sample starts the screen
+                            break;
+                        }
                     }
                 } // while not triggered
             } // if in trigger mode
@@ -299,480 +1531,718 @@
             // take (the rest of the) samples that fit on one screen
             while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { // while screenTime < screenWidthTime
 
-                // if we already passed screenWidthMilliseconds then copy read buffer to send buffer so it can be sent to the javascript client
-                if (screenTime >= screenWidthTime || (noOfSignals == 1 && readBuffer->sampleCount >= OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE) || (noOfSignals == 2 && readBuffer->sampleCount >= OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE)) { 
-                    // copy read buffer to send buffer so that oscilloscope sender can send it to javascript client 
+                // if we already passed screenWidthTime then pass read buffer to oscSender so it can be sent to the javascript client
+                if (screenTime >= screenWidthTime || readBuffer->sampleCount >= sampler_t::bufferSize) { 
+                    // measure the samples of the screen from the trigger on in one pass
+                    if constexpr (doAnalogRead && !inMilliseconds) {
+                        if (measurements.enabled) {
+                            int64_t sampleMicroseconds = 0;
+                            for (unsigned int i = max (readBuffer->header.triggerPosition, (int16_t) 0); i < readBuffer->sampleCount; i ++) measurements.add (samples [i].signal1, sampleMicroseconds += samples [i].deltaTime);
+                            measurements.end (readBuffer);
+                        }
+                    }
 
-                    while (oneSampleAtATime && sendBuffer->samplesAreReady) vTaskDelay (pdMS_TO_TICKS (1)); // in oneSampleAtATime mode wait until previous frame is sent
-                    if (!sendBuffer->samplesAreReady) 
-                        *sendBuffer = *readBuffer; // this also copies 'ready' flag from read buffer which is 'true' - tell oscSender to send the packet, this would refresh client screen
-                    // else send buffer with previous frame is still waiting to be sent, do nothing now, skip this frame
+                    // pass read buffer to oscilloscope sender so that it can send it to javascript client 
+                    while (!frameQueue->push (!oneSampleAtATime)) // viewers that haven't sent the oldest frame yet will skip it
+                        vTaskDelay (pdMS_TO_TICKS (1)); // in oneSampleAtATime mode wait until the oldest frame is sent by all the viewers
 
                     // break out of the loop and than start taking new samples
                     break; // get out of while loop to start sampling from the left of the screen again
                 }
 
-                // one sample at a time mode requires sending (copying) the readBuffer to the sendBuffer so it can be sent to the javascript client even before it gets full (of samples that fit to one screen)
+                // one sample at a time mode requires passing the readBuffer to oscSender so it can be sent to the javascript client even before it gets full (of samples that fit to one screen)
                 if (oneSampleAtATime && readBuffer->sampleCount) {
-                    // copy read buffer to send buffer so that oscilloscope sender can send it to javascript client 
-                    if (!sendBuffer->samplesAreReady) {
-                        *sendBuffer = *readBuffer; // this also copies 'ready' flag from read buffer which is 'true' - tell oscSender to send the packet, this would refresh client screen
-                        readBuffer->sampleCount = 0; // empty read buffer so we don't send the same data again later
+                    oscFrameHeader header = readBuffer->header;
+                    if (frameQueue->push ()) {
+                        // continue sampling into the next (empty) slot
+                        readBuffer = frameQueue->writeSlot ();
+                        readBuffer->header = { header.frameType, header.samplingTime, -1, (uint16_t) (header.flags | OSC_FRAME_CONTINUED) }; // the next samples will continue the same screen, trigger position has already been sent
+                        readBuffer->sampleCount = 0;
+                        samples = sampler_t::samples (readBuffer);
                     }
-                    // else send buffer with previous frame is still waiting to be sent, but the buffer is not full yet, so just continue sampling into the same frame
+                    // else some viewer hasn't sent the oldest frame yet, but the buffer is not full yet, so just continue sampling into the same frame
                 }
     
                 // take the next sample
-                union {
-                    osc1SignalSample new1SignalSample;
-                    osc2SignalsSample new2SignalsSample;
-                };
-
-                #ifdef INVERT_ADC1_GET_RAW
-                    if (noOfSignals == 1) { if (doAnalogRead) new1SignalSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) deltaTime}; else new1SignalSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) deltaTime}; 
-                                            readBuffer->samples1Signal [readBuffer->sampleCount ++] = new1SignalSample;
-                    } else                { if (doAnalogRead) new2SignalsSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (~adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) deltaTime}; else new2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) deltaTime}; 
-                                            readBuffer->samples2Signals [readBuffer->sampleCount ++] = new2SignalsSample;
-                    }
-                #else
-                    if (noOfSignals == 1) { if (doAnalogRead) new1SignalSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) deltaTime}; else new1SignalSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) deltaTime}; 
-                                            readBuffer->samples1Signal [readBuffer->sampleCount ++] = new1SignalSample;
-                    } else                { if (doAnalogRead) new2SignalsSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) deltaTime}; else new2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) deltaTime}; 
-                                            readBuffer->samples2Signals [readBuffer->sampleCount ++] = new2SignalsSample;
-                    }
-                #endif
+                samples [readBuffer->sampleCount ++] = sampler.take ((int16_t) deltaTime);
 
                 screenTime += deltaTime;
 
-                // wait befor continuing to next sample and calculate delta offset for it
-                vTaskDelayUntil (&newSampleTicks, pdMS_TO_TICKS (samplingTime));
-                deltaTime = pdTICKS_TO_MS (newSampleTicks - lastSampleTicks); // in ms - this value will be used for the next sample offset
+                // wait for the hardware timer befor continuing to next sample and calculate delta offset for it
+                newSampleMicroseconds = samplingTimer.waitForNextSample ();
+                deltaTime = deltaTimeBetween (lastSampleMicroseconds, newSampleMicroseconds);
+                lastSampleMicroseconds = newSampleMicroseconds;
 
-                lastSampleTicks = newSampleTicks;
             } // while screenTime < screenWidthTime
 
-            // wait before next screen refresh
-            vTaskDelayUntil (&lastScreenRefreshTicks, pdMS_TO_TICKS (screenRefreshMilliseconds));
+            // wait before next screen refresh, Single mode stops sampling right after the triggered screen
+            samplingTimer.stop ();
+            if (!trigger.screenDone (triggeredScreen)) break;
+            trigger.waitForNextScreen ();
 
         } // while sampling
 
-        // wait for the STOP signal
-        while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-        ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED; 
+        samplingTimer.end ();
+
+        // Single mode has taken its screen, wait for STOP signal
+        while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED)
+            vTaskDelay (pdMS_TO_TICKS (10));
+
+        // acknowledge the STOP signal, oscReader worker will wait for the next job
+        __oscReaderStopped__ (sharedMemory);
+    }
 
-        vTaskDelete (NULL);
+    // runOscilloscope picks oscReader_timed specialization for 1 or 2 signals (analog in us, analog or digital in ms)
+    template<bool doAnalogRead, bool inMilliseconds>
+    void (*__oscReaderTimed__ (unsigned char noOfSignals)) (void *) {
+        return noOfSignals == 1 ? oscReader_timed<1, doAnalogRead, inMilliseconds> : oscReader_timed<2, doAnalogRead, inMilliseconds>;
     }
 
+    // oscReader that takes analog samples of 1 or 2 signals as fast as the hardware timer allows (peak detect acquisition)
+    //  - raw samples are taken every OSCILLOSCOPE_PEAK_DETECT_SAMPLING_TIME us regardless of the sampling time, but are never passed to oscSender
+    //  - all the raw samples taken during one sampling time are reduced to min and max value of each signal, so short spikes don't get lost between the samples
+    //    even when the sampling time needs to be stretched to fit the whole screen into the buffer
+    //  - sampling time is measured in us, it works only in 'screen at a time' mode
+    template<unsigned char noOfSignals>
+    void oscReader_peakDetect (void *sharedMemory) {
+        typedef oscSampler<noOfSignals, true, __oscInvertAdc1__> sampler_t;
+        typedef typename sampler_t::sampleType rawSampleType;
+        typedef typename std::conditional<noOfSignals == 1, osc1SignalMinMaxSample, osc2SignalsMinMaxSample>::type sampleType;
+        constexpr unsigned int bufferSize = noOfSignals == 1 ? OSCILLOSCOPE_1SIGNAL_MIN_MAX_BUFFER_SIZE : OSCILLOSCOPE_2SIGNALS_MIN_MAX_BUFFER_SIZE;
+        constexpr int16_t frameType = noOfSignals == 1 ? OSC_FRAME_1_SIGNAL_MIN_MAX : OSC_FRAME_2_SIGNALS_MIN_MAX;
 
-    // oscReader that takes digital samples (digitalRead) on time interval specified in microseconds
-    //  - it can only read 1 or 2 digital signals
-    //  - it can only work in 'screen at a time' mode (which is not a drawback for the sampling is measured in microseconds)
-    void oscReader_digital (void *sharedMemory) {
-        // *not needed* bool doAnalogRead =                 !strcmp (((oscSharedMemory *) sharedMemory)->readType, "analog");
-        // *not needed* bool unitIsMicroSeconds =           !strcmp (((oscSharedMemory *) sharedMemory)->samplingTimeUnit, "us");
         int samplingTime =                  ((oscSharedMemory *) sharedMemory)->samplingTime;
         bool positiveTrigger =              ((oscSharedMemory *) sharedMemory)->positiveTrigger;
         bool negativeTrigger =              ((oscSharedMemory *) sharedMemory)->negativeTrigger;
-        gpio_num_t gpio1 =                  (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio1; // easier to check validity with unsigned char then with integer 
-        gpio_num_t gpio2 =                  (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio2; // easier to check validity with unsigned char then with integer
-        unsigned char noOfSignals = 1; if (gpio2 <= 39) noOfSignals = 2;  // monitor 1 or 2 signals
-        // *not needed* adc1_channel_t adcchannel1 =        ((oscSharedMemory *) sharedMemory)->adcchannel1;
-        // *not needed* adc1_channel_t adcchannel2 =        ((oscSharedMemory *) sharedMemory)->adcchannel2;
-        int positiveTriggerTreshold =       ((oscSharedMemory *) sharedMemory)->positiveTriggerTreshold;
-        int negativeTriggerTreshold =       ((oscSharedMemory *) sharedMemory)->negativeTriggerTreshold;
+        sampler_t sampler = {               (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio1, 
+                                            (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio2, 
+                                            ((oscSharedMemory *) sharedMemory)->adcchannel1, 
+                                            ((oscSharedMemory *) sharedMemory)->adcchannel2,
+                                            __oscAdcCalibrationTable__ (((oscSharedMemory *) sharedMemory)->analogUnit) };
         unsigned long screenWidthTime =     ((oscSharedMemory *) sharedMemory)->screenWidthTime; 
-        oscSamples *readBuffer =            &((oscSharedMemory *) sharedMemory)->readBuffer;
-        oscSamples *sendBuffer =            &((oscSharedMemory *) sharedMemory)->sendBuffer;
+        int preTriggerPercent =             ((oscSharedMemory *) sharedMemory)->preTriggerPercent;
+        oscFrameQueue *frameQueue =         &((oscSharedMemory *) sharedMemory)->frameQueue;
+        oscSamples *readBuffer =            frameQueue->writeSlot ();
 
         // Is samplingTime large enough to fill the whole screen? If not, make a correction.
-        if (noOfSignals == 1) {
-            if ((unsigned long) samplingTime * (OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE - 1) < screenWidthTime) {
-                samplingTime = max ((int) (screenWidthTime / (OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
-                __oscilloscope_h_debug__ ("oscReader_digital: 1 signal samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
-            }
-        } else {
-            if ((unsigned long) samplingTime * (OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE - 1) < screenWidthTime) {
-                samplingTime = max ((int) (screenWidthTime / (OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
-                __oscilloscope_h_debug__ ("oscReader_digital: 2 signals samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
+        if ((unsigned long) samplingTime * (bufferSize - 1) < screenWidthTime) {
+            samplingTime = max ((int) (screenWidthTime / (bufferSize - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
+            __oscilloscope_h_debug__ ("oscReader_peakDetect: samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
+        }
+        // Is samplingTime is too long for 15 bits, make a correction.
+        if (samplingTime > 5000) {
+                samplingTime = 5000;
+                __oscilloscope_h_debug__ ("oscReader_peakDetect: samplingTime was too long (to fit in 15 bits in (almost?) all cases) and is corrected to " + String (samplingTime));
+        }
+        int rawSamplingTime = min (samplingTime, OSCILLOSCOPE_PEAK_DETECT_SAMPLING_TIME);
+
+        // Calculate screen refresh period. It sholud be arround 50 ms (sustainable screen refresh rate is arround 20 Hz) but it is better if it is a multiple value of screenWidthTime.
+        unsigned long screenRefreshMilliseconds; // screen refresh period
+        int noOfSamplesPerScreen = screenWidthTime / samplingTime; if (noOfSamplesPerScreen * samplingTime < screenWidthTime) noOfSamplesPerScreen ++;
+        unsigned long correctedScreenWidthTime = noOfSamplesPerScreen * samplingTime;                         
+        screenRefreshMilliseconds = correctedScreenWidthTime >= 50000 ? correctedScreenWidthTime / 1000 : ((50500 / correctedScreenWidthTime) * correctedScreenWidthTime) / 1000;
+        __oscilloscope_h_debug__ ("oscReader_peakDetect: samplingTime = " + String (samplingTime) + ", rawSamplingTime = " + String (rawSamplingTime) + ", screenWidthTime = " + String (screenWidthTime));
+
+        // circular buffer for the (min, max) samples taken before the trigger condition occurs
+        oscPreTriggerBuffer<sampleType> preTrigger = { NULL, __oscPreTriggerSamples__ (noOfSamplesPerScreen, bufferSize, preTriggerPercent), 0, 0 };
+
+        // acknowledge the START signal
+        __oscReaderStarted__ (sharedMemory, samplingTime, correctedScreenWidthTime);
+
+        // start a new (min, max) sample with a raw sample
+        auto open = [] (const rawSampleType& raw, int16_t deltaTime) -> sampleType {
+            if constexpr (noOfSignals == 1) return { raw.signal1, raw.signal1, deltaTime };
+            else                            return { raw.signal1, raw.signal1, raw.signal2, raw.signal2, deltaTime };
+        };
+
+        // streaming reduction of raw samples into (min, max) sample
+        auto widen = [] (sampleType& sample, const rawSampleType& raw) {
+            sample.signal1Min = min (sample.signal1Min, raw.signal1);
+            sample.signal1Max = max (sample.signal1Max, raw.signal1);
+            if constexpr (noOfSignals == 2) {
+                sample.signal2Min = min (sample.signal2Min, raw.signal2);
+                sample.signal2Max = max (sample.signal2Max, raw.signal2);
             }
+        };
+
+        // --- do the sampling, samplingTime and screenWidthTime are in us ---
+
+        // triggered or untriggered mode of operation
+        bool triggeredMode = positiveTrigger || negativeTrigger;
+
+        // hardware timer that paces the raw samples
+        oscSamplingTimer samplingTimer (rawSamplingTime);
+
+        oscTriggerMode trigger (sharedMemory, screenRefreshMilliseconds);      // trigger mode, holdoff and screen refresh timing
+        oscTriggerEngine triggerEngine (sharedMemory);                          // trigger condition
+        oscMeasurements measurements (sharedMemory);                            // Vpp, Vrms, frequency, ... of the raw samples from the trigger condition on
+
+        while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { // sampling from the left of the screen - while not getting STOP signal
+
+            unsigned long screenTime = 0;                                       // in us - how far we have already got from the left of the screen (we'll compare this value with screenWidthTime)
+            int64_t sampleStartMicroseconds = samplingTimer.start ();           // when the current (min, max) sample has started, the first raw sample is taken right away
+            int64_t rawSampleMicroseconds;
+
+            // Frame header tells javascript client to start drawing from the left of the screen. Please note that it also tells javascript client how many signals are in each sample
+            readBuffer = frameQueue->writeSlot ();
+            readBuffer->header = { frameType, 0, -1, 0 };
+            readBuffer->sampleCount = 0;
+            sampleType *samples;
+            if constexpr (noOfSignals == 1) samples = readBuffer->samples1SignalMinMax;
+            else                            samples = readBuffer->samples2SignalsMinMax;
+
+            // take the first raw sample
+            rawSampleType firstRawSample = sampler.take (0);
+            sampleType sample = open (firstRawSample, 0);
+
+            bool triggeredScreen = false;                                       // true when the trigger condition has occured on this screen
+            if (triggeredMode) { // if no trigger is set then skip this (waiting) part and start sampling immediatelly
+
+                // keep the (min, max) samples in circular buffer while waiting for trigger condition
+                preTrigger.clear (samples);
+                triggerEngine.rearm ();
+                triggerEngine.check (triggerEngine.value (firstRawSample), sampleStartMicroseconds); // the first value only sets the comparators
+
+                // wait for trigger condition, the trigger condition is checked on raw samples
+                while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { 
+                    rawSampleMicroseconds = samplingTimer.waitForNextSample ();
+                    rawSampleType newRawSample = sampler.take (0);
+
+                    // check if the trigger condition has occured on the trigger source
+                    bool triggered = triggerEngine.check (triggerEngine.value (newRawSample), rawSampleMicroseconds);
+
+                    if (triggered || rawSampleMicroseconds - sampleStartMicroseconds >= samplingTime) {
+                        // the current (min, max) sample is complete (the trigger also completes it), keep it in circular buffer and start the next one
+                        preTrigger.push (sample);
+                        sample = open (newRawSample, (int16_t) (rawSampleMicroseconds - sampleStartMicroseconds));
+                        sampleStartMicroseconds = rawSampleMicroseconds;
+
+                        if (triggered) {
+                            // trigger condition has occured, put the samples from circular buffer in the right order, the sample being started now will follow them
+                            unsigned int triggerPosition = preTrigger.linearize ();
+                            samples [0].deltaTime = 0; // timeOffset (from left of the screen) = 0, start measuring screen time from the oldest sample on
+                            for (unsigned int i = 1; i < triggerPosition; i ++) screenTime += samples [i].deltaTime;
+                            screenTime += sample.deltaTime;
+                            readBuffer->header.triggerPosition = triggerPosition;
+                            readBuffer->sampleCount = triggerPosition;
+                            triggeredScreen = true;
+                            break; // trigger event occured, stop waiting and proceed to sampling
+                        }
+                    } else {
+                        widen (sample, newRawSample);
+                    }
+                    if (trigger.autoTimeout ()) { // no trigger condition for too long, show untriggered screen
+                        sample = open (newRawSample, 0);
+                        sampleStartMicroseconds = rawSampleMicroseconds;
+                        break;
+                    }
+                } // while not triggered
+            } // if in trigger mode
+
+            // take (the rest of the) samples that fit on one screen, the raw samples are measured before they are reduced to (min, max)
+            measurements.begin ();
+            if (measurements.enabled) measurements.add (sample.signal1Min, sampleStartMicroseconds); // the raw sample the current (min, max) sample has been opened with, the trigger sample on triggered screens
+            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) {
+                rawSampleMicroseconds = samplingTimer.waitForNextSample ();
+                rawSampleType newRawSample = sampler.take (0);
+                if (measurements.enabled) measurements.add (newRawSample.signal1, rawSampleMicroseconds);
+
+                if (rawSampleMicroseconds - sampleStartMicroseconds < samplingTime) {
+                    widen (sample, newRawSample);
+                    continue;
+                }
+
+                // the current (min, max) sample is complete
+                samples [readBuffer->sampleCount ++] = sample;
+
+                // if we already passed screenWidthTime then pass read buffer to oscSender so it can be sent to the javascript client
+                if (screenTime >= screenWidthTime || readBuffer->sampleCount >= bufferSize) { 
+                    if (measurements.enabled) measurements.end (readBuffer);
+                    frameQueue->push (true); // viewers that haven't sent the oldest frame yet will skip it
+                    break; // get out of while loop to start sampling from the left of the screen again
+                }
+
+                // start the next (min, max) sample
+                sample = open (newRawSample, (int16_t) (rawSampleMicroseconds - sampleStartMicroseconds));
+                screenTime += sample.deltaTime;
+                sampleStartMicroseconds = rawSampleMicroseconds;
+
+            } // while screenTime < screenWidthTime
+
+            // wait before next screen refresh, Single mode stops sampling right after the triggered screen
+            samplingTimer.stop ();
+            if (!trigger.screenDone (triggeredScreen)) break;
+            trigger.waitForNextScreen ();
+
+        } // while sampling
+
+        samplingTimer.end ();
+
+        // Single mode has taken its screen, wait for STOP signal
+        while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED)
+            vTaskDelay (pdMS_TO_TICKS (10));
+
+        // acknowledge the STOP signal, oscReader worker will wait for the next job
+        __oscReaderStopped__ (sharedMemory);
+    }
+
+    // While waiting for the trigger condition oscReader_transitions keeps the transitions (not the samples) in circular buffer, so they may cover more time than the
+    // pre-trigger part of the screen. Keep only the transitions that fit into preTriggerTime before the trigger, the first one is moved to the left edge of the screen.
+    // Returns the number of transitions kept (the position where the trigger transition will go).
+    unsigned int __oscTrimPreTriggerTransitions__ (oscTransitionSample *transitions, unsigned int count, unsigned long timeToTrigger, unsigned long preTriggerTime) {
+        unsigned int first = count - 1;
+        while (first > 0 && timeToTrigger + transitions [first].deltaTime <= preTriggerTime) // go back while the previous transition still fits on the screen
+            timeToTrigger += transitions [first --].deltaTime;
+        if (first > 0 && timeToTrigger < preTriggerTime) { // the levels before the first transition kept also last from the left edge of the screen
+            transitions [first].deltaTime = preTriggerTime - timeToTrigger;
+            first --;
         }
-        // Is samplingTime is too long for 15 bits, make a correction. Max sample time can be 32767 (15 bits) but since in some case actual sample time can be much larger than required le's keep it below 5000.
+        transitions [first].deltaTime = 0; // the left edge of the screen
+        memmove (transitions, transitions + first, (count - first) * sizeof (oscTransitionSample));
+        return count - first;
+    }
+
+    // oscReader that takes digital samples of 1 or 2 signals on time interval specified in microseconds but only passes the transitions (the samples where any level has changed)
+    //  - each transition carries the levels of both signals (bit 0 = gpio1, bit 1 = gpio2) and the time from the previous transition
+    //  - since mostly constant digital signals need much less transitions than samples, the sampling time doesn't need to be corrected to fit the samples
+    //    into the buffer, if there are still more transitions than fit into one frame the screen continues in the next frame
+    //  - it works only in 'screen at a time' mode
+    template<unsigned char noOfSignals>
+    void oscReader_transitions (void *sharedMemory) {
+        constexpr unsigned int bufferSize = OSCILLOSCOPE_TRANSITIONS_BUFFER_SIZE;
+
+        int samplingTime =                  ((oscSharedMemory *) sharedMemory)->samplingTime;
+        bool positiveTrigger =              ((oscSharedMemory *) sharedMemory)->positiveTrigger;
+        bool negativeTrigger =              ((oscSharedMemory *) sharedMemory)->negativeTrigger;
+        gpio_num_t gpio1 =                  (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio1;
+        gpio_num_t gpio2 =                  (gpio_num_t) ((oscSharedMemory *) sharedMemory)->gpio2;
+        unsigned long screenWidthTime =     ((oscSharedMemory *) sharedMemory)->screenWidthTime; 
+        int preTriggerPercent =             ((oscSharedMemory *) sharedMemory)->preTriggerPercent;
+        oscFrameQueue *frameQueue =         &((oscSharedMemory *) sharedMemory)->frameQueue;
+        oscSamples *readBuffer =            frameQueue->writeSlot ();
+
+        // Is samplingTime is too long for 15 bits, make a correction.
         if (samplingTime > 5000) {
                 samplingTime = 5000;
-                __oscilloscope_h_debug__ ("oscReader_digital: samplingTime was too long (to fit in 15 bits in (almost?) all cases) and is corrected to " + String (samplingTime));
-        }  
-
-        /*
-        cout << "----- oscReader_digital () -----\r\n";
-        cout << "samplingTime " << samplingTime << " us" << endl;
-        cout << "positiveTrigger " << positiveTrigger << endl;
-        cout << "negativeTrigger " << negativeTrigger << endl;
-        cout << "gpio1 " << gpio1 << endl;
-        cout << "gpio2 " << gpio2 << endl;
-        cout << "noOfSignals " << noOfSignals << endl;
-        cout << "positiveTriggerTreshold " << positiveTriggerTreshold << endl;
-        cout << "negativeTriggerTreshold " << negativeTriggerTreshold << endl;
-        cout << "screenWidthTime " << screenWidthTime << endl;
-        if (noOfSignals == 1) {
-            cout << "max number of sampels " << OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE << endl;
-            cout << "max possible screenWidthTime covered by sampels " << samplingTime * OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE << endl;
-        } else {
-            cout << "max number of sampels " << OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE << endl;
-            cout << "max possible screenWidthTime covered by sampels " << samplingTime * OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE << endl;
+                __oscilloscope_h_debug__ ("oscReader_transitions: samplingTime was too long (to fit in 15 bits in (almost?) all cases) and is corrected to " + String (samplingTime));
         }
-        delay (100);
-        */
 
         // Calculate screen refresh period. It sholud be arround 50 ms (sustainable screen refresh rate is arround 20 Hz) but it is better if it is a multiple value of screenWidthTime.
         unsigned long screenRefreshMilliseconds; // screen refresh period
         int noOfSamplesPerScreen = screenWidthTime / samplingTime; if (noOfSamplesPerScreen * samplingTime < screenWidthTime) noOfSamplesPerScreen ++;
         unsigned long correctedScreenWidthTime = noOfSamplesPerScreen * samplingTime;                         
         screenRefreshMilliseconds = correctedScreenWidthTime >= 50000 ? correctedScreenWidthTime / 1000 : ((50500 / correctedScreenWidthTime) * correctedScreenWidthTime) / 1000;
-        __oscilloscope_h_debug__ ("oscReader_digital: samplingTime = " + String (samplingTime) + ", screenWidthTime = " + String (screenWidthTime));
+        unsigned long preTriggerTime = screenWidthTime * preTriggerPercent / 100; // the part of the screen before the trigger condition occured
+        __oscilloscope_h_debug__ ("oscReader_transitions: samplingTime = " + String (samplingTime) + ", screenWidthTime = " + String (screenWidthTime));
 
-        readBuffer->samplesAreReady = true; // this information will be always copied to sendBuffer together with the samples
+        // circular buffer for the transitions before the trigger condition occurs, they will be trimmed to preTriggerTime later
+        oscPreTriggerBuffer<oscTransitionSample> preTrigger = { NULL, bufferSize - 2, 0, 0 }; // leave some place for the trigger transition and (at least) one more
 
         // enable GPIO reading even if it is not configured so
-        if (gpio1 <= 39) gpio_hal_input_enable (&__gpio_hal__, gpio1);
-        if (gpio2 <= 39) gpio_hal_input_enable (&__gpio_hal__, gpio2);
+        if (gpio1 < SOC_GPIO_PIN_COUNT) gpio_hal_input_enable (&__gpio_hal__, gpio1);
+        if (gpio2 < SOC_GPIO_PIN_COUNT) gpio_hal_input_enable (&__gpio_hal__, gpio2);
+
+        // acknowledge the START signal
+        __oscReaderStarted__ (sharedMemory, samplingTime, correctedScreenWidthTime);
 
-        // wait for the START signal
-        while (((oscSharedMemory *) sharedMemory)->oscReaderState != START) delay (1);
-        ((oscSharedMemory *) sharedMemory)->oscReaderState = STARTED; 
+        // read the levels of both signals into one value
+        auto readLevels = [gpio1, gpio2] () -> int16_t {
+            if constexpr (noOfSignals == 1) return gpio_hal_get_level (&__gpio_hal__, gpio1);
+            else                            return gpio_hal_get_level (&__gpio_hal__, gpio1) | (gpio_hal_get_level (&__gpio_hal__, gpio2) << 1);
+        };
 
         // --- do the sampling, samplingTime and screenWidthTime are in us ---
 
         // triggered or untriggered mode of operation
         bool triggeredMode = positiveTrigger || negativeTrigger;
 
-        TickType_t lastScreenRefreshTicks = xTaskGetTickCount ();               // for timing screen refresh intervals            
+        // hardware timer that paces the samples
+        oscSamplingTimer samplingTimer (samplingTime);
+
+        oscTriggerMode trigger (sharedMemory, screenRefreshMilliseconds);      // trigger mode, holdoff and screen refresh timing
+        oscTriggerEngine triggerEngine (sharedMemory);                          // trigger condition
 
         while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { // sampling from the left of the screen - while not getting STOP signal
 
             unsigned long screenTime = 0;                                       // in us - how far we have already got from the left of the screen (we'll compare this value with screenWidthTime)
-            unsigned long deltaTime = 0;                                        // in us - delta from previous sample
-            unsigned long lastSampleMicroseconds = micros ();                   // for sample timing                
-            unsigned long newSampleMicroseconds = lastSampleMicroseconds;
+            unsigned long deltaTime;                                            // in us - delta from previous sample
+            unsigned long pendingTime = 0;                                      // in us - delta from previous transition
+            int64_t lastSampleMicroseconds = samplingTimer.start ();            // for sample timing, the first sample is taken right away
+            int64_t newSampleMicroseconds;
 
-            // Insert first dummy sample to read-buffer this tells javascript client to start drawing from the left of the screen. Please note that it also tells javascript client how many signals are in each sample
-            if (noOfSignals == 1) readBuffer->samples1Signal [0] = {-2, -2}; // no real data sample can look like this
-            else                  readBuffer->samples2Signals [0] = {-3, -3, -3}; // no real data sample can look like this
-            readBuffer->sampleCount = 1;
+            // Frame header tells javascript client to start drawing from the left of the screen
+            readBuffer = frameQueue->writeSlot ();
+            readBuffer->header = { (int16_t) OSC_FRAME_TRANSITIONS, 0, -1, 0 };
+            readBuffer->sampleCount = 0;
+            oscTransitionSample *transitions = readBuffer->transitions;
 
-            if (triggeredMode) { // if no trigger is set then skip this (waiting) part and start sampling immediatelly
+            // take the first sample
+            int16_t lastLevels = readLevels ();
 
-                // take the first sample
-                union {
-                    osc1SignalSample last1SignalSample;
-                    osc2SignalsSample last2SignalsSample;
-                };
+            bool triggeredScreen = false;                                       // true when the trigger condition has occured on this screen
+            if (triggeredMode) { // if no trigger is set then skip this (waiting) part and start sampling immediatelly
 
-                if (noOfSignals == 1) { last1SignalSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) 0}; } // gpio1 should always be valid PIN
-                else                  { last2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) 0}; } // gpio1 should always be valid PIN
+                // keep the transitions in circular buffer while waiting for trigger condition
+                preTrigger.clear (transitions);
+                preTrigger.push ({ lastLevels, 0 });
+                triggerEngine.rearm ();
+                triggerEngine.check (triggerEngine.levelValue (lastLevels), lastSampleMicroseconds); // the first value only sets the comparators
 
                 // wait for trigger condition
                 while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { 
-                    // wait befor continuing to next sample and calculate delta offset for it
-                    while ((deltaTime = (newSampleMicroseconds = micros ()) - lastSampleMicroseconds) < samplingTime) delayMicroseconds (1);
+                    // wait for the hardware timer befor continuing to next sample and calculate delta offset for it
+                    newSampleMicroseconds = samplingTimer.waitForNextSample ();
+                    deltaTime = newSampleMicroseconds - lastSampleMicroseconds;
                     lastSampleMicroseconds = newSampleMicroseconds;
+                    pendingTime += deltaTime;
 
                     // take the second sample
-                    union {
-                        osc1SignalSample new1SignalSample;
-                        osc2SignalsSample new2SignalsSample;
-                    };
-                    if (noOfSignals == 1) { new1SignalSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                    else                  { new2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-
-                    // Compare both samples to check if the trigger condition has occured, only gpio1 is used to trigger the sampling. Please note that it doesn't matter wether we compare last1SignalSample or last2SignalsSample since they share the same space and signal1 is always on the same place.
-                    if ((positiveTrigger && last2SignalsSample.signal1 < positiveTriggerTreshold && new2SignalsSample.signal1 >= positiveTriggerTreshold) || (negativeTrigger && last2SignalsSample.signal1 > negativeTriggerTreshold && new2SignalsSample.signal1 <= negativeTriggerTreshold)) { 
-                        // trigger condition has occured, insert both samples into read buffer
-                        if (noOfSignals == 1) { readBuffer->samples1Signal [1] = last1SignalSample; readBuffer->samples1Signal [2] = new1SignalSample; } // timeOffset (from left of the screen) = 0, this is the first sample after triggered
-                        else                  { readBuffer->samples2Signals [1] = last2SignalsSample; readBuffer->samples2Signals [2] = new2SignalsSample; } // timeOffset (from left of the screen) = 0, this is the first sample after triggered
-                        screenTime = deltaTime;     // start measuring screen time from new sample on
-                        readBuffer->sampleCount = 3;
-                
-                        // correct screenTime
-                        screenTime = deltaTime;
-
-                        // wait befor continuing to next sample and calculate delta offset for it
-                        while ((deltaTime = (newSampleMicroseconds = micros ()) - lastSampleMicroseconds) < samplingTime) delayMicroseconds (1);
-                        lastSampleMicroseconds = newSampleMicroseconds;
+                    int16_t newLevels = readLevels ();
+
+                    // check if the trigger condition has occured on the trigger source
+                    if (triggerEngine.check (triggerEngine.levelValue (newLevels), newSampleMicroseconds)) { 
+                        // trigger condition has occured, put the transitions from circular buffer in the right order, keep only those that fit on the screen and append the trigger transition after them
+                        unsigned int triggerPosition = __oscTrimPreTriggerTransitions__ (transitions, preTrigger.linearize (), pendingTime, preTriggerTime);
+                        for (unsigned int i = 1; i < triggerPosition; i ++) screenTime += transitions [i].deltaTime;
+                        pendingTime = min (min (pendingTime, preTriggerTime), (unsigned long) 32767); // the oldest transition kept may have started before the left edge of the screen
+                        transitions [triggerPosition] = { newLevels, (int16_t) pendingTime }; // this is the first transition after triggered
+                        screenTime += pendingTime;
+                        pendingTime = 0;
+                        lastLevels = newLevels;
+                        readBuffer->header.triggerPosition = triggerPosition;
+                        readBuffer->sampleCount = triggerPosition + 1;
                             
+                        triggeredScreen = true;
                         break; // trigger event occured, stop waiting and proceed to sampling
-                    } else {
-                        // Just forget the first sample and continue waiting for trigger condition - copy just signal values and let the timing start from 0. Please note that it doesn't matter wether we move new1SignalSample or new2SignalsSample since they share the same space.
-                        last2SignalsSample.signal1 = new2SignalsSample.signal1;
-                        last2SignalsSample.signal2 = new2SignalsSample.signal2;
+                    } 
+                    // keep only the transitions (or the samples whose time from previous transition would not fit in 15 bits any more) in circular buffer and continue waiting for trigger condition
+                    if (newLevels != lastLevels || pendingTime >= 30000) {
+                        preTrigger.push ({ newLevels, (int16_t) min (pendingTime, (unsigned long) 32767) });
+                        pendingTime = 0;
+                    }
+                    lastLevels = newLevels;
+                    if (trigger.autoTimeout ()) { // no trigger condition for too long, show untriggered screen
+                        transitions [readBuffer->sampleCount ++] = { lastLevels, 0 }; // the first sample starts the signal at the left of the screen
+                        pendingTime = 0;
+                        break;
                     }
                 } // while not triggered
-            } // if in trigger mode
 
-            // take (the rest of the) samples that fit on one screen
-            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { // while screenTime < screenWidthTime
+            } else {
+                transitions [readBuffer->sampleCount ++] = { lastLevels, 0 }; // the first sample is always passed, it starts the signal at the left of the screen
+            }
 
-                // if we already passed screenWidthMilliseconds then copy read buffer to send buffer so it can be sent to the javascript client
-                if (screenTime >= screenWidthTime || (noOfSignals == 1 && readBuffer->sampleCount >= OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE) || (noOfSignals == 2 && readBuffer->sampleCount >= OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE)) { 
-                    // copy read buffer to send buffer so that oscilloscope sender can send it to javascript client 
+            // take (the rest of the) samples that fit on one screen
+            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) {
 
-                    if (!sendBuffer->samplesAreReady) 
-                        *sendBuffer = *readBuffer; // this also copies 'ready' flag from read buffer which is 'true' - tell oscSender to send the packet, this would refresh client screen
-                    // else send buffer with previous frame is still waiting to be sent, do nothing now, skip this frame
+                // wait for the hardware timer befor continuing to next sample and calculate delta offset for it
+                newSampleMicroseconds = samplingTimer.waitForNextSample ();
+                deltaTime = newSampleMicroseconds - lastSampleMicroseconds;
+                lastSampleMicroseconds = newSampleMicroseconds;
+                screenTime += deltaTime;
+                pendingTime += deltaTime;
 
-                    // break out of the loop and than start taking new samples
-                    break; // get out of while loop to start sampling from the left of the screen again
-                }
-    
                 // take the next sample
-                union {
-                    osc1SignalSample new1SignalSample;
-                    osc2SignalsSample new2SignalsSample;
-                };
-
-                if (noOfSignals == 1) { new1SignalSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) deltaTime}; 
-                                        readBuffer->samples1Signal [readBuffer->sampleCount ++] = new1SignalSample;
-                } else                { new2SignalsSample = {(int16_t) gpio_hal_get_level (&__gpio_hal__, gpio1), (int16_t) gpio_hal_get_level (&__gpio_hal__, gpio2), (int16_t) deltaTime}; 
-                                        readBuffer->samples2Signals [readBuffer->sampleCount ++] = new2SignalsSample;
+                int16_t newLevels = readLevels ();
+                bool endOfScreen = screenTime >= screenWidthTime;
+
+                // pass only the transitions, the last sample on the screen (so the signal is drawn to the right edge) and the samples whose time from previous transition would not fit in 15 bits any more
+                if (newLevels != lastLevels || endOfScreen || pendingTime >= 30000) {
+                    if (readBuffer->sampleCount >= bufferSize) {
+                        // the frame is full, pass it to oscSender and continue the same screen in the next frame
+                        oscFrameHeader header = readBuffer->header;
+                        frameQueue->push (true); // viewers that haven't sent the oldest frame yet will skip it
+                        readBuffer = frameQueue->writeSlot ();
+                        readBuffer->header = { header.frameType, header.samplingTime, -1, (uint16_t) (header.flags | OSC_FRAME_CONTINUED) }; // trigger position has already been sent
+                        readBuffer->sampleCount = 0;
+                        transitions = readBuffer->transitions;
+                    }
+                    transitions [readBuffer->sampleCount ++] = { newLevels, (int16_t) min (pendingTime, (unsigned long) 32767) };
+                    pendingTime = 0;
+                    lastLevels = newLevels;
                 }
 
-                screenTime += deltaTime;
-
-                // wait befor continuing to next sample and calculate delta offset for it
-                while ((deltaTime = (newSampleMicroseconds = micros ()) - lastSampleMicroseconds) < samplingTime) delayMicroseconds (1);
-                lastSampleMicroseconds = newSampleMicroseconds;
+                // if we already passed screenWidthTime then pass read buffer to oscSender so it can be sent to the javascript client
+                if (endOfScreen) { 
+                    frameQueue->push (true); // viewers that haven't sent the oldest frame yet will skip it
+                    break; // get out of while loop to start sampling from the left of the screen again
+                }
 
             } // while screenTime < screenWidthTime
 
-            // wait before next screen refresh
-            vTaskDelayUntil (&lastScreenRefreshTicks, pdMS_TO_TICKS (screenRefreshMilliseconds));
+            // wait before next screen refresh, Single mode stops sampling right after the triggered screen
+            samplingTimer.stop ();
+            if (!trigger.screenDone (triggeredScreen)) break;
+            trigger.waitForNextScreen ();
 
         } // while sampling
 
-        // wait for the STOP signal
-        while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-        ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED; 
+        samplingTimer.end ();
 
-        vTaskDelete (NULL);
+        // Single mode has taken its screen, wait for STOP signal
+        while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED)
+            vTaskDelay (pdMS_TO_TICKS (10));
+
+        // acknowledge the STOP signal, oscReader worker will wait for the next job
+        __oscReaderStopped__ (sharedMemory);
     }
 
-    // oscReader that takes analog samples (analogRead) on time interval specified in microseconds
-    //  - it can only read 1 or 2 digital signals
-    //  - it can only work in 'screen at a time' mode (which is not a drawback for the sampling is measured in microseconds)
-    void oscReader_analog (void *sharedMemory) {
-        // *not needed* bool doAnalogRead =                 !strcmp (((oscSharedMemory *) sharedMemory)->readType, "analog");
-        // *not needed* bool unitIsMicroSeconds =           !strcmp (((oscSharedMemory *) sharedMemory)->samplingTimeUnit, "us");
+
+    // oscReader that takes samples of up to 16 digital signals at once (logic analyzer)
+    //  - GPIO input registers are read only once per sample, so all the signals are sampled at the same time (GPIOs 0-31 and 32-39 are in two registers that are read right one after another)
+    //  - each signal takes only 1 bit of a sample, up to 8 signals fit into 1 byte and up to 16 signals into 2 bytes
+    //  - samples are equally spaced, so the sampling time is sent in the frame header instead of deltaTime with each sample
+    //  - it works only in 'screen at a time' mode
+    template<typename sampleType>
+    void oscReader_logic (void *sharedMemory) {
+        constexpr unsigned int bufferSize = sizeof (sampleType) == 1 ? OSCILLOSCOPE_LOGIC8_BUFFER_SIZE : OSCILLOSCOPE_LOGIC16_BUFFER_SIZE;
+        constexpr int16_t frameType = sizeof (sampleType) == 1 ? OSC_FRAME_8_LOGIC_SIGNALS : OSC_FRAME_16_LOGIC_SIGNALS;
+
         int samplingTime =                  ((oscSharedMemory *) sharedMemory)->samplingTime;
+        bool inMilliseconds =               !strcmp (((oscSharedMemory *) sharedMemory)->samplingTimeUnit, "ms");
         bool positiveTrigger =              ((oscSharedMemory *) sharedMemory)->positiveTrigger;
         bool negativeTrigger =              ((oscSharedMemory *) sharedMemory)->negativeTrigger;
-        // unsigned char gpio1 =               (unsigned char) ((oscSharedMemory *) sharedMemory)->gpio1; // easier to check validity with unsigned char then with integer 
-        unsigned char gpio2 =               (unsigned char) ((oscSharedMemory *) sharedMemory)->gpio2; // easier to check validity with unsigned char then with integer
-        unsigned char noOfSignals = 1; if (gpio2 <= 39) noOfSignals = 2;  // monitor 1 or 2 signals
-        adc1_channel_t adcchannel1 =        ((oscSharedMemory *) sharedMemory)->adcchannel1;
-        adc1_channel_t adcchannel2 =        ((oscSharedMemory *) sharedMemory)->adcchannel2;
-        int positiveTriggerTreshold =       ((oscSharedMemory *) sharedMemory)->positiveTriggerTreshold;
-        int negativeTriggerTreshold =       ((oscSharedMemory *) sharedMemory)->negativeTriggerTreshold;
         unsigned long screenWidthTime =     ((oscSharedMemory *) sharedMemory)->screenWidthTime; 
-        oscSamples *readBuffer =            &((oscSharedMemory *) sharedMemory)->readBuffer;
-        oscSamples *sendBuffer =            &((oscSharedMemory *) sharedMemory)->sendBuffer;
+        int preTriggerPercent =             ((oscSharedMemory *) sharedMemory)->preTriggerPercent;
+        unsigned char logicSignals =        ((oscSharedMemory *) sharedMemory)->logicSignals;
+        uint8_t logicGpio [OSCILLOSCOPE_LOGIC_MAX_SIGNALS]; memcpy (logicGpio, ((oscSharedMemory *) sharedMemory)->logicGpio, sizeof (logicGpio));
+        oscFrameQueue *frameQueue =         &((oscSharedMemory *) sharedMemory)->frameQueue;
+        oscSamples *readBuffer =            frameQueue->writeSlot ();
 
         // Is samplingTime large enough to fill the whole screen? If not, make a correction.
-        if (noOfSignals == 1) {
-            if ((unsigned long) samplingTime * (OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE - 1) < screenWidthTime) {
-                samplingTime = max ((int) (screenWidthTime / (OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
-                __oscilloscope_h_debug__ ("oscReader_analog: 1 signal samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
-            }
-        } else {
-            if ((unsigned long) samplingTime * (OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE - 1) < screenWidthTime) {
-                samplingTime = max ((int) (screenWidthTime / (OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
-                __oscilloscope_h_debug__ ("oscReader_analog: 2 signals samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
-            }
+        if ((unsigned long) samplingTime * (bufferSize - 1) < screenWidthTime) {
+            samplingTime = max ((int) (screenWidthTime / (bufferSize - 1)) + 1, 1); // + 1 just to be on the safe side due to integer calculation rounding
+            __oscilloscope_h_debug__ ("oscReader_logic: samplingTime was too short (regarding to buffer size) and is corrected to " + String (samplingTime));
         }
-        // Is samplingTime is too long for 15 bits? Make a correction. Max sample time can be 32767 (15 bits) but since in some case actual sample time can be much larger than required let's keep it below 5000.
+        // Is samplingTime is too long for 15 bits, make a correction.
         if (samplingTime > 5000) {
                 samplingTime = 5000;
-                // __oscilloscope_h_debug__ ("oscReader_analog: samplingTime was too long (to fit in 15 bits in (almost?) all cases) and is corrected to " + String (samplingTime));
-                cout << "oscReader_analog: samplingTime was too long (to fit in 15 bits in (almost?) all cases) and is corrected to " << samplingTime;
-        }
-
-        /*
-        cout << "----- oscReader_analog () -----\r\n";
-        cout << "samplingTime " << samplingTime << " us" << endl;
-        cout << "positiveTrigger " << positiveTrigger << endl;
-        cout << "negativeTrigger " << negativeTrigger << endl;
-        cout << "gpio1 " << gpio1 << endl;
-        cout << "gpio2 " << gpio2 << endl;
-        cout << "noOfSignals " << noOfSignals << endl;
-        cout << "positiveTriggerTreshold " << positiveTriggerTreshold << endl;
-        cout << "negativeTriggerTreshold " << negativeTriggerTreshold << endl;
-        cout << "screenWidthTime " << screenWidthTime << endl;
-        if (noOfSignals == 1) {
-            cout << "max number of sampels " << OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE << endl;
-            cout << "max possible screenWidthTime covered by sampels " << samplingTime * OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE << endl;
-        } else {
-            cout << "max number of sampels " << OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE << endl;
-            cout << "max possible screenWidthTime covered by sampels " << samplingTime * OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE << endl;
+                __oscilloscope_h_debug__ ("oscReader_logic: samplingTime was too long (to fit in 15 bits in (almost?) all cases) and is corrected to " + String (samplingTime));
         }
-        delay (100);
-        */
 
         // Calculate screen refresh period. It sholud be arround 50 ms (sustainable screen refresh rate is arround 20 Hz) but it is better if it is a multiple value of screenWidthTime.
         unsigned long screenRefreshMilliseconds; // screen refresh period
-        int noOfSamplesPerScreen = screenWidthTime / samplingTime; if (noOfSamplesPerScreen * samplingTime < screenWidthTime) noOfSamplesPerScreen ++;
-        unsigned long correctedScreenWidthTime = noOfSamplesPerScreen * samplingTime;                         
+        unsigned int noOfSamplesPerScreen = screenWidthTime / samplingTime; if (noOfSamplesPerScreen * samplingTime < screenWidthTime) noOfSamplesPerScreen ++;
+        unsigned long correctedScreenWidthTime = noOfSamplesPerScreen * samplingTime;
+        if (inMilliseconds) correctedScreenWidthTime *= 1000; // in us from now on
         screenRefreshMilliseconds = correctedScreenWidthTime >= 50000 ? correctedScreenWidthTime / 1000 : ((50500 / correctedScreenWidthTime) * correctedScreenWidthTime) / 1000;
-        __oscilloscope_h_debug__ ("oscReader_analog: samplingTime = " + String (samplingTime) + ", screenWidthTime = " + String (screenWidthTime));
+        noOfSamplesPerScreen ++; // the sample at the right edge of the screen
+        __oscilloscope_h_debug__ ("oscReader_logic: " + String (logicSignals) + " signals, samplingTime = " + String (samplingTime) + ", screenWidthTime = " + String (screenWidthTime));
 
-        readBuffer->samplesAreReady = true; // this information will be always copied to sendBuffer together with the samples
+        // circular buffer for the samples taken before the trigger condition occurs
+        oscPreTriggerBuffer<sampleType> preTrigger = { NULL, __oscPreTriggerSamples__ (noOfSamplesPerScreen, bufferSize, preTriggerPercent), 0, 0 };
 
-        // wait for the START signal
-        while (((oscSharedMemory *) sharedMemory)->oscReaderState != START) delay (1);
-        ((oscSharedMemory *) sharedMemory)->oscReaderState = STARTED; 
-
-        if ((noOfSignals == 2 && screenWidthTime <= 200) || (noOfSignals == 1 && screenWidthTime <= 100)) {
-            // cout << ( dmesgQueue << "[oscilloscope] the settings exceed oscilloscope capabilities" );
-            ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] the settings exceed oscilloscope capabilities"); // send error to javascript client
-            // ((oscSharedMemory *) sharedMemory)->webSck->closeWebSocket ();
-            while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-            ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED;
-            vTaskDelete (NULL);
-        }
+        // enable GPIO reading even if it is not configured so
+        for (unsigned char i = 0; i < logicSignals; i ++) gpio_hal_input_enable (&__gpio_hal__, (gpio_num_t) logicGpio [i]);
+
+        // acknowledge the START signal
+        __oscReaderStarted__ (sharedMemory, samplingTime, (noOfSamplesPerScreen - 1) * samplingTime);
+
+        // read GPIO input registers and pack the levels of selected GPIOs into one sample
+        auto takeSample = [&logicGpio, logicSignals] () -> sampleType {
+            #if SOC_GPIO_PIN_COUNT > 32
+                uint64_t levels = REG_READ (GPIO_IN_REG) | ((uint64_t) REG_READ (GPIO_IN1_REG) << 32); // GPIOs 0-31 are in GPIO_IN_REG, the higher ones in GPIO_IN1_REG
+            #else
+                uint32_t levels = REG_READ (GPIO_IN_REG); // all the GPIOs are in GPIO_IN_REG
+            #endif
+            sampleType sample = 0;
+            for (unsigned char i = 0; i < logicSignals; i ++) sample |= ((levels >> logicGpio [i]) & 1) << i;
+            return sample;
+        };
 
-        // --- do the sampling, samplingTime and screenWidthTime are in us ---
+        // --- do the sampling, samplingTime and screenWidthTime are in ms or us ---
 
         // triggered or untriggered mode of operation
         bool triggeredMode = positiveTrigger || negativeTrigger;
 
-        TickType_t lastScreenRefreshTicks = xTaskGetTickCount ();               // for timing screen refresh intervals            
+        // hardware timer that paces the samples
+        oscSamplingTimer samplingTimer (inMilliseconds ? samplingTime * 1000 : samplingTime); // samplingTimer works in us
+
+        oscTriggerMode trigger (sharedMemory, screenRefreshMilliseconds);      // trigger mode, holdoff and screen refresh timing
+        oscTriggerEngine triggerEngine (sharedMemory);                          // trigger condition
 
         while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { // sampling from the left of the screen - while not getting STOP signal
 
-            unsigned long screenTime = 0;                                       // in us - how far we have already got from the left of the screen (we'll compare this value with screenWidthTime)
-            unsigned long deltaTime = 0;                                        // in us - delta from previous sample
-            unsigned long lastSampleMicroseconds = micros ();                   // for sample timing                
-            unsigned long newSampleMicroseconds = lastSampleMicroseconds;
+            samplingTimer.start (); // the first sample is taken right away
 
-            // Insert first dummy sample to read-buffer this tells javascript client to start drawing from the left of the screen. Please note that it also tells javascript client how many signals are in each sample
-            if (noOfSignals == 1) readBuffer->samples1Signal [0] = {-2, -2}; // no real data sample can look like this
-            else                  readBuffer->samples2Signals [0] = {-3, -3, -3}; // no real data sample can look like this
-            readBuffer->sampleCount = 1;
+            // Frame header tells javascript client to start drawing from the left of the screen and how far apart the samples are
+            readBuffer = frameQueue->writeSlot ();
+            readBuffer->header = { frameType, (int16_t) samplingTime, -1, (uint16_t) (inMilliseconds ? OSC_FRAME_MILLISECONDS : 0) };
+            readBuffer->sampleCount = 0;
+            sampleType *samples;
+            if constexpr (sizeof (sampleType) == 1) samples = readBuffer->samples8LogicSignals;
+            else                                    samples = readBuffer->samples16LogicSignals;
 
+            bool triggeredScreen = false;                                       // true when the trigger condition has occured on this screen
             if (triggeredMode) { // if no trigger is set then skip this (waiting) part and start sampling immediatelly
 
                 // take the first sample
-                union {
-                    osc1SignalSample last1SignalSample;
-                    osc2SignalsSample last2SignalsSample;
-                };
+                sampleType lastSample = takeSample ();
 
-                #ifdef INVERT_ADC1_GET_RAW
-                    if (noOfSignals == 1) { last1SignalSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) 0}; } // gpio1 should always be valid PIN
-                    else                  { last2SignalsSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (~adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) 0}; } // gpio1 should always be valid PIN
-                #else
-                    if (noOfSignals == 1) { last1SignalSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) 0}; } // gpio1 should always be valid PIN
-                    else                  { last2SignalsSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) 0}; } // gpio1 should always be valid PIN
-                #endif
+                // keep the samples in circular buffer while waiting for trigger condition
+                preTrigger.clear (samples);
+                preTrigger.push (lastSample);
+                triggerEngine.rearm ();
+                triggerEngine.check (triggerEngine.levelValue (lastSample), 0); // the first value only sets the comparators
 
                 // wait for trigger condition
                 while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { 
-                    // wait befor continuing to next sample and calculate delta offset for it
-                    while ((deltaTime = (newSampleMicroseconds = micros ()) - lastSampleMicroseconds) < samplingTime) delayMicroseconds (1);
-                    lastSampleMicroseconds = newSampleMicroseconds;
+                    int64_t newSampleMicroseconds = samplingTimer.waitForNextSample ();
 
                     // take the second sample
-                    union {
-                        osc1SignalSample new1SignalSample;
-                        osc2SignalsSample new2SignalsSample;
-                    };
-
-                    #ifdef INVERT_ADC1_GET_RAW
-                        if (noOfSignals == 1) { new1SignalSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                        else                  { new2SignalsSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (~adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                    #else
-                        if (noOfSignals == 1) { new1SignalSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                        else                  { new2SignalsSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) deltaTime}; } // gpio1 should always be valid PIN
-                    #endif
-
-                    // Compare both samples to check if the trigger condition has occured, only gpio1 is used to trigger the sampling. Please note that it doesn't matter wether we compare last1SignalSample or last2SignalsSample since they share the same space and signal1 is always on the same place.
-                    if ((positiveTrigger && last2SignalsSample.signal1 < positiveTriggerTreshold && new2SignalsSample.signal1 >= positiveTriggerTreshold) || (negativeTrigger && last2SignalsSample.signal1 > negativeTriggerTreshold && new2SignalsSample.signal1 <= negativeTriggerTreshold)) { 
-                        // trigger condition has occured, insert both samples into read buffer
-                        if (noOfSignals == 1) { readBuffer->samples1Signal [1] = last1SignalSample; readBuffer->samples1Signal [2] = new1SignalSample; } // timeOffset (from left of the screen) = 0, this is the first sample after triggered
-                        else                  { readBuffer->samples2Signals [1] = last2SignalsSample; readBuffer->samples2Signals [2] = new2SignalsSample; } // timeOffset (from left of the screen) = 0, this is the first sample after triggered
-                        screenTime = deltaTime;     // start measuring screen time from new sample on
-                        readBuffer->sampleCount = 3;
-                
-                        // correct screenTime
-                        screenTime = deltaTime;
-
-                        // wait befor continuing to next sample and calculate delta offset for it
-                        while ((deltaTime = (newSampleMicroseconds = micros ()) - lastSampleMicroseconds) < samplingTime) delayMicroseconds (1);
-                        lastSampleMicroseconds = newSampleMicroseconds;
-                            
+                    sampleType newSample = takeSample ();
+
+                    // check if the trigger condition has occured on the trigger source (the first GPIO is bit 0 and the second is bit 1)
+                    if (triggerEngine.check (triggerEngine.levelValue (newSample), newSampleMicroseconds)) { 
+                        // trigger condition has occured, put the samples from circular buffer in the right order and append the new sample after them
+                        unsigned int triggerPosition = preTrigger.linearize ();
+                        samples [triggerPosition] = newSample; // this is the first sample after triggered
+                        readBuffer->header.triggerPosition = triggerPosition;
+                        readBuffer->sampleCount = triggerPosition + 1;
+
+                        samplingTimer.waitForNextSample ();
+                        triggeredScreen = true;
                         break; // trigger event occured, stop waiting and proceed to sampling
                     } else {
-                        // Just forget the first sample and continue waiting for trigger condition - copy just signal values and let the timing start from 0. Please note that it doesn't matter wether we move new1SignalSample or new2SignalsSample since they share the same space.
-                        last2SignalsSample.signal1 = new2SignalsSample.signal1;
-                        last2SignalsSample.signal2 = new2SignalsSample.signal2;
+                        // keep the new sample in circular buffer and continue waiting for trigger condition
+                        preTrigger.push (newSample);
+                        lastSample = newSample;
+                        if (trigger.autoTimeout ()) { // no trigger condition for too long, show untriggered screen
+                            samplingTimer.waitForNextSample ();
+                            break;
+                        }
                     }
                 } // while not triggered
             } // if in trigger mode
 
             // take (the rest of the) samples that fit on one screen
-            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { // while screenTime < screenWidthTime
-
-                // if we already passed screenWidthMilliseconds then copy read buffer to send buffer so it can be sent to the javascript client
-                if (screenTime >= screenWidthTime || (noOfSignals == 1 && readBuffer->sampleCount >= OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE) || (noOfSignals == 2 && readBuffer->sampleCount >= OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE)) { 
-                    // copy read buffer to send buffer so that oscilloscope sender can send it to javascript client 
+            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) {
 
-                    if (!sendBuffer->samplesAreReady) 
-                        *sendBuffer = *readBuffer; // this also copies 'ready' flag from read buffer which is 'true' - tell oscSender to send the packet, this would refresh client screen
-                    // else send buffer with previous frame is still waiting to be sent, do nothing now, skip this frame
-
-                    // break out of the loop and than start taking new samples
+                // if the screen is full then pass read buffer to oscSender so it can be sent to the javascript client
+                if (readBuffer->sampleCount >= noOfSamplesPerScreen) { 
+                    frameQueue->push (true); // viewers that haven't sent the oldest frame yet will skip it
                     break; // get out of while loop to start sampling from the left of the screen again
                 }
-    
-                // take the next sample
-                union {
-                    osc1SignalSample new1SignalSample;
-                    osc2SignalsSample new2SignalsSample;
-                };
-
-                #ifdef INVERT_ADC1_GET_RAW
-                    if (noOfSignals == 1) { new1SignalSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) deltaTime}; 
-                                            readBuffer->samples1Signal [readBuffer->sampleCount ++] = new1SignalSample;
-                    } else                { new2SignalsSample = {(int16_t) (~adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (~adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) deltaTime}; 
-                                            readBuffer->samples2Signals [readBuffer->sampleCount ++] = new2SignalsSample;
-                    }
-                #else
-                    if (noOfSignals == 1) { new1SignalSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) deltaTime}; 
-                                            readBuffer->samples1Signal [readBuffer->sampleCount ++] = new1SignalSample;
-                    } else                { new2SignalsSample = {(int16_t) (adc1_get_raw (adcchannel1) & 0xFFF), (int16_t) (adc1_get_raw (adcchannel2) & 0xFFF), (int16_t) deltaTime}; 
-                                            readBuffer->samples2Signals [readBuffer->sampleCount ++] = new2SignalsSample;
-                    }
-                #endif
 
-                screenTime += deltaTime;
-
-                // wait befor continuing to next sample and calculate delta offset for it
-                while ((deltaTime = (newSampleMicroseconds = micros ()) - lastSampleMicroseconds) < samplingTime) delayMicroseconds (1);
-                lastSampleMicroseconds = newSampleMicroseconds;
+                samples [readBuffer->sampleCount ++] = takeSample ();
 
-            } // while screenTime < screenWidthTime
+                samplingTimer.waitForNextSample ();
+            }
 
-            // wait before next screen refresh
-            vTaskDelayUntil (&lastScreenRefreshTicks, pdMS_TO_TICKS (screenRefreshMilliseconds));
+            // wait before next screen refresh, Single mode stops sampling right after the triggered screen
+            samplingTimer.stop ();
+            if (!trigger.screenDone (triggeredScreen)) break;
+            trigger.waitForNextScreen ();
 
         } // while sampling
 
-        // wait for the STOP signal
-        while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-        ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED; 
+        samplingTimer.end ();
+
+        // Single mode has taken its screen, wait for STOP signal
+        while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED)
+            vTaskDelay (pdMS_TO_TICKS (10));
 
-        vTaskDelete (NULL);
+        // acknowledge the STOP signal, oscReader worker will wait for the next job
+        __oscReaderStopped__ (sharedMemory);
     }
 
 
     #ifdef USE_I2S_INTERFACE
+        // installs I2S driver that keeps sampling adcchannel (and adcchannel2, each sample once per samplingTime) into DMA buffers until it is uninstalled, returns NULL if succeeded or error message for javascript client
+        const char *__oscI2sBegin__ (int samplingTime, int dmaBufferLength, adc1_channel_t adcchannel, adc1_channel_t adcchannel2 = ADC1_CHANNEL_MAX) {
+            int noOfChannels = adcchannel2 == ADC1_CHANNEL_MAX ? 1 : 2;
+            esp_err_t err;
+
+            #pragma GCC diagnostic push
+            #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+            i2s_config_t i2s_config = { 
+                .mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN),
+                .sample_rate = (uint32_t) ((1000000 / samplingTime) * I2S_FREQ_CORRECTION * noOfChannels), // = samplingFrequency (samplingTime is in us) of all the channels together,
+                .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT, // could only get it to work with 32bits
+                .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT, // <- mono signal - stereo signal -> I2S_CHANNEL_FMT_RIGHT_LEFT, // although the SEL config should be left, it seems to transmit on right
+                .communication_format = i2s_comm_format_t (I2S_COMM_FORMAT_STAND_I2S), //// I2S_COMM_FORMAT_STAND_I2S, // I2S_COMM_FORMAT_I2S_MSB, - deprecated
+                .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1, // Interrupt level 1
+                .dma_buf_count = OSCILLOSCOPE_I2S_DMA_BUFFER_COUNT, // number of buffers, DMA is filling one while the others are waiting to be processed
+                .dma_buf_len = dmaBufferLength, // samples per buffer
+                .use_apll = true // false//,
+                //.tx_desc_auto_clear = false,
+                //.fixed_mclk = 1
+            };
+            #pragma GCC diagnostic pop
+          
+            err = i2s_driver_install (I2S_NUM_0, &i2s_config,  0, NULL);  //step 2
+
+            if (err != ESP_OK) {
+                // DEBUG: Serial.printf ("Failed installing driver: %d\n", err);
+                // cout << ( dmesgQueue << "[oscilloscope][oscReader_oscReader_analog_1_signal_i2s] failed to install the driver: " << err );
+                return "[oscilloscope] failed to install the i2s driver.";
+            }
+
+            err = i2s_set_adc_mode (ADC_UNIT_1, adcchannel);
+            if (err != ESP_OK) {
+                // DEBUG: Serial.printf ("Failed setting up adc mode: %d\n", err);
+                // cout << ( dmesgQueue << "[oscilloscope][oscReader_oscReader_analog_1_signal_i2s] failed setting up adc mode: " << err );
+                i2s_driver_uninstall (I2S_NUM_0);
+                return "[oscilloscope] failed setting up i2s adc mode";
+            }
+
+            // i2s_set_adc_mode has put only adcchannel into ADC pattern table, add adcchannel2 so that the digital controller scans both of them into the same DMA stream
+            if (noOfChannels == 2) {
+                #if CONFIG_IDF_TARGET_ESP32
+                    adc_ll_digi_set_pattern_table (ADC_UNIT_1, 1, { (uint8_t) OSCILLOSCOPE_ADC_ATTENUATION, (uint8_t) adcchannel2, (uint8_t) ADC_UNIT_1, (uint8_t) SOC_ADC_DIGI_MAX_BITWIDTH });
+                    adc_ll_digi_set_pattern_table_len (ADC_UNIT_1, 2);
+                #else
+                    i2s_driver_uninstall (I2S_NUM_0);
+                    return "[oscilloscope] i2s interface can't sample 2 signals on this board";
+                #endif
+            }
+
+            return NULL;
+        }
+
+        // For some strange reason the sample come swapped two-by two. Unswap them and filter out only 12 bits that actually hold the value
+        void __oscI2sUnswap__ (int16_t *dmaBuffer, int from, int noOfSamplesRead, const uint16_t *calibration) {
+            for (int j = from; j < noOfSamplesRead - 1; j += 2) {
+                int16_t tmp = dmaBuffer [j];
+                #ifdef INVERT_I2S_READ
+                    dmaBuffer [j] = ~dmaBuffer [j + 1] & 0xFFF;
+                    dmaBuffer [j + 1] = ~tmp & 0xFFF;
+                #else
+                    dmaBuffer [j] = dmaBuffer [j + 1] & 0xFFF;
+                    dmaBuffer [j + 1] = tmp & 0xFFF;
+                #endif
+            }
+            if (calibration) // a single table lookup per sample
+                for (int j = from; j < noOfSamplesRead; j ++) dmaBuffer [j] = calibration [dmaBuffer [j]];
+        }
+
+        // Packs the samples of continuously sampled screen into the frame when the screen is complete: 2 samples into 3 bytes or only the upper 8 bits into 1 byte.
+        // The samples are collected in their own buffer, since unpacked they don't fit in the frame. 12 bit samples are processed in pairs, read as one 32 bit word.
+        void __oscPackSamples__ (oscSamples *frame, const oscI2sSample *samples) {
+            const uint16_t *src = (const uint16_t *) samples;
+            uint8_t *dst = (uint8_t *) frame->samplesI2sSignal;
+            unsigned int i = 0;
+
+            if (frame->header.frameType == OSC_FRAME_1_SIGNAL_PACKED_8_BITS) {
+                for ( ; i < frame->sampleCount; i ++) dst [i] = src [i] >> 4;
+                return;
+            }
+
+            // OSC_FRAME_1_SIGNAL_PACKED_12_BITS
+            for ( ; i + 1 < frame->sampleCount; i += 2) {
+                uint32_t pair; memcpy (&pair, src + i, sizeof (pair));  // 2 samples at once (ESP32 is little endian)
+                pair = (pair & 0xFFF) | ((pair >> 4) & 0xFFF000);       // 2 x 12 bits = 3 bytes
+                memcpy (dst, &pair, 3); dst += 3;
+            }
+            if (i < frame->sampleCount) { // odd number of samples, the last one takes 2 bytes
+                uint16_t last = src [i];
+                memcpy (dst, &last, 2);
+            }
+        }
+
+        // oscReader that takes analog samples of 1 signal through I2S interface (DMA)
+        //  - the I2S driver is installed only once and keeps running, DMA buffers are processed as they get filled
+        //  - there is no dead time between the screens (no reinstalling the driver, no warm-up samples), so the trigger is rearmed as soon as the screen refresh is due
         void oscReader_analog_1_signal_i2s (void *sharedMemory) {
             // *not needed* bool doAnalogRead =                 !strcmp (((oscSharedMemory *) sharedMemory)->readType, "analog");
             // *not needed* bool unitIsMicroSeconds =           !strcmp (((oscSharedMemory *) sharedMemory)->samplingTimeUnit, "us");
@@ -783,19 +2253,29 @@
             // * not needed * unsigned char gpio2 =               (unsigned char) ((oscSharedMemory *) sharedMemory)->gpio2; // easier to check validity with unsigned char then with integer
             // * not needed * unsigned char noOfSignals = 1; if (gpio2 <= 39) noOfSignals = 2;  // monitor 1 or 2 signals
             adc1_channel_t adcchannel1 =        ((oscSharedMemory *) sharedMemory)->adcchannel1;
+            const uint16_t *calibration =       __oscAdcCalibrationTable__ (((oscSharedMemory *) sharedMemory)->analogUnit);
             // * not needed * adc1_channel_t adcchannel2 =        ((oscSharedMemory *) sharedMemory)->adcchannel2;
             int positiveTriggerTreshold =       ((oscSharedMemory *) sharedMemory)->positiveTriggerTreshold;
             int negativeTriggerTreshold =       ((oscSharedMemory *) sharedMemory)->negativeTriggerTreshold;
             unsigned long screenWidthTime =     ((oscSharedMemory *) sharedMemory)->screenWidthTime; 
-            oscSamples *readBuffer =            &((oscSharedMemory *) sharedMemory)->readBuffer;
-            oscSamples *sendBuffer =            &((oscSharedMemory *) sharedMemory)->sendBuffer;
+            int preTriggerPercent =             ((oscSharedMemory *) sharedMemory)->preTriggerPercent;
+            int sampleBits =                    ((oscSharedMemory *) sharedMemory)->sampleBits;
+            oscFrameQueue *frameQueue =         &((oscSharedMemory *) sharedMemory)->frameQueue;
+            oscSamples *readBuffer =            frameQueue->writeSlot ();
+
+            // packed samples take less space in the frame, so more of them fit on one screen
+            int16_t frameType = OSC_FRAME_1_SIGNAL_EQUALLY_SPACED;
+            unsigned int bufferSize = OSCILLOSCOPE_I2S_BUFFER_SIZE;
+            switch (sampleBits) {
+                case 12:    frameType = OSC_FRAME_1_SIGNAL_PACKED_12_BITS; bufferSize = OSCILLOSCOPE_I2S_12BIT_BUFFER_SIZE; break;
+                case 8:     frameType = OSC_FRAME_1_SIGNAL_PACKED_8_BITS; bufferSize = OSCILLOSCOPE_I2S_8BIT_BUFFER_SIZE; break;
+            }
 
             // How many samples do we need to take? The following should be considered:
-            // (A) - at leastsampleRate * screenWidthTime / 1000000 + 1; (1 sample more than distance between them)
-            // (B) - it must be an even number, otherwise the last sample taken would be 0
-            // (C) - it must be at most OSCILLOSCOPE_I2S_BUFFER_SIZE - 1 (the 0-th sample in the buffer is reserved for "dummy" value)
-            // (D) - it must be at least 8 due to i2s_read limitations, if working in triggered mode we have to consider that at least 8 samples must be read (at second reading) for the rest of teh signal
-            // (E) - the first is2_read after the initialisation often contains false readings (all 16 bits are 0) at the beginning (normally at the first 6 samples read), let's always delete the first 8 samples read just to be on the safe side which wil also solve the problem (D)
+            // (A) - at least sampleRate * screenWidthTime / 1000000 + 1; (1 sample more than distance between them)
+            // (B) - it must be at most bufferSize (depending on how the samples are packed)
+            // (C) - DMA buffer length must be an even number, otherwise the last sample read would be 0
+            // (D) - the first is2_read after the initialisation often contains false readings (all 16 bits are 0) at the beginning (normally at the first 6 samples read), let's delete the first 8 samples read just to be on the safe side
 
             /*
             cout << "----- oscReader_I2S () before correction -----\r\n";
@@ -804,19 +2284,22 @@
 
             // calculate correct sampling time so that it will prefectly aligh with sampleRate (regarding integer calculation rounding) and that the sample buffer is large enough 
             unsigned long sampleRate = 1000000 / (samplingTime); // samplingTime is in us
-            int noOfSamplesToTakeFirstTime = sampleRate * screenWidthTime / 1000000 + 1 + 8; // screenWidhtTime is in us, 1 sample more than the distancesbetween them (A) (E)
+            int noOfSamplesToTake = sampleRate * screenWidthTime / 1000000 + 1; // screenWidhtTime is in us, 1 sample more than the distancesbetween them (A)
             while (samplingTime != 1000000 / sampleRate // integer clculation rounding missmatch
-              || (unsigned long) samplingTime * (OSCILLOSCOPE_I2S_BUFFER_SIZE - 1 - 1) < screenWidthTime // samples do not fill the screen (additional - 1 due to possible (B))
-              || noOfSamplesToTakeFirstTime > (OSCILLOSCOPE_I2S_BUFFER_SIZE + 8 - 1 - 1) // samples do not fit in the buffer (the first sample is dummy sample, additional - 1 due to (B)), 8 is added due to (D)
-              || samplingTime < 4 // dummy values -2 and -3 are already taken for different types of buffer
+              || (unsigned long) samplingTime * (bufferSize - 1) < screenWidthTime // samples do not fill the screen
+              || noOfSamplesToTake > bufferSize // samples do not fit in the buffer (B)
               || samplingTime < 7) // max ESP32 sampling rate = 150 kHz (sampling time >= 6.6 us)
             {
                 samplingTime ++;
                 sampleRate = 1000000 / samplingTime;
-                noOfSamplesToTakeFirstTime = sampleRate * screenWidthTime / 1000000 + 1 + 8; // (A) (E)
+                noOfSamplesToTake = sampleRate * screenWidthTime / 1000000 + 1; // (A)
             }
-            if (noOfSamplesToTakeFirstTime % 2 != 0) noOfSamplesToTakeFirstTime ++; // (B)
-            if (noOfSamplesToTakeFirstTime < 10) noOfSamplesToTakeFirstTime = 10; // (D), add at least 2 usefull samples
+            if (noOfSamplesToTake < 2) noOfSamplesToTake = 2;
+
+            // Shorter DMA buffers bring lower latency at long sampling times, longer DMA buffers bring less overhead at short sampling times
+            int dmaBufferLength = min (noOfSamplesToTake, OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH);
+            if (dmaBufferLength % 2 != 0) dmaBufferLength ++; // (C)
+            if (dmaBufferLength < 16) dmaBufferLength = 16; // (D), leave at least 8 usefull samples in the first DMA buffer
 
             // Is samplingTime is too long for 15 bits, make a correction. Max sample time can be 32767 (15 bits) but since in some case actual sample time can be much larger than required le's keep it below 5000.
             if (samplingTime > 32767) {
@@ -837,312 +2320,1174 @@
             cout << "positiveTriggerTreshold " << positiveTriggerTreshold << endl;
             cout << "negativeTriggerTreshold " << negativeTriggerTreshold << endl;
             cout << "screenWidthTime " << screenWidthTime << endl;
-            cout << "max number of sampels " << OSCILLOSCOPE_I2S_BUFFER_SIZE << endl;
-            cout << "max possible screenWidthTime covered by sampels " << samplingTime * OSCILLOSCOPE_I2S_BUFFER_SIZE << endl;
+            cout << "max number of sampels " << bufferSize << endl;
+            cout << "max possible screenWidthTime covered by sampels " << samplingTime * bufferSize << endl;
             delay (100);
             */
 
-            // Calculate screen refresh period. It sholud be arround 50 ms (sustainable screen refresh rate is arround 20 Hz) but it is better if it is a multiple value of screenWidthTime.
-            unsigned long screenRefreshMilliseconds; // screen refresh period
-            int noOfSamplesPerScreen = screenWidthTime / samplingTime; if (noOfSamplesPerScreen * samplingTime < screenWidthTime) noOfSamplesPerScreen ++;
-            unsigned long correctedScreenWidthTime = noOfSamplesPerScreen * samplingTime;                         
-            screenRefreshMilliseconds = correctedScreenWidthTime >= 50000 ? correctedScreenWidthTime / 1000 : ((50500 / correctedScreenWidthTime) * correctedScreenWidthTime) / 1000;
-            __oscilloscope_h_debug__ ("oscReader_analog_1_signal_i2s: samplingTime = " + String (samplingTime) + ", screenWidthTime = " + String (screenWidthTime));
-            __oscilloscope_h_debug__ ("oscReader_analog_1_signal_i2s: sampleRate = " + String (sampleRate) + ", noOfSamplesToTake = " + String (noOfSamplesToTakeFirstTime));
-            __oscilloscope_h_debug__ ("oscReader_analog_1_signal_i2s: screenRefreshMilliseconds = " + String (screenRefreshMilliseconds) + " ms (should be close to 50 ms), screen refresh frequency = " + String (1000.0 / screenRefreshMilliseconds) + " Hz (should be close to 20 Hz)");
+            // Calculate screen refresh period. It sholud be arround 50 ms (sustainable screen refresh rate is arround 20 Hz) but it is better if it is a multiple value of screenWidthTime.
+            unsigned long screenRefreshMilliseconds; // screen refresh period
+            int noOfSamplesPerScreen = screenWidthTime / samplingTime; if (noOfSamplesPerScreen * samplingTime < screenWidthTime) noOfSamplesPerScreen ++;
+            unsigned long correctedScreenWidthTime = noOfSamplesPerScreen * samplingTime;                         
+            screenRefreshMilliseconds = correctedScreenWidthTime >= 50000 ? correctedScreenWidthTime / 1000 : ((50500 / correctedScreenWidthTime) * correctedScreenWidthTime) / 1000;
+            __oscilloscope_h_debug__ ("oscReader_analog_1_signal_i2s: samplingTime = " + String (samplingTime) + ", screenWidthTime = " + String (screenWidthTime));
+            __oscilloscope_h_debug__ ("oscReader_analog_1_signal_i2s: sampleRate = " + String (sampleRate) + ", noOfSamplesToTake = " + String (noOfSamplesToTake) + ", dmaBufferLength = " + String (dmaBufferLength));
+            __oscilloscope_h_debug__ ("oscReader_analog_1_signal_i2s: screenRefreshMilliseconds = " + String (screenRefreshMilliseconds) + " ms (should be close to 50 ms), screen refresh frequency = " + String (1000.0 / screenRefreshMilliseconds) + " Hz (should be close to 20 Hz)");
+
+            // accumulators for combining more screens into one, and the samples of the screen if they are going to be packed (they don't fit in the frame unpacked)
+            oscAcquisition acquisition (sharedMemory);
+            oscI2sSample *unpackedSamples = frameType == OSC_FRAME_1_SIGNAL_EQUALLY_SPACED ? NULL : (oscI2sSample *) malloc (bufferSize * sizeof (oscI2sSample));
+            if ((frameType != OSC_FRAME_1_SIGNAL_EQUALLY_SPACED && !unpackedSamples) || !acquisition.begin (noOfSamplesToTake)) {
+                free (unpackedSamples);
+                // cout << ( dmesgQueue << "[oscilloscope][oscReader_analog_1_signal_i2s] out of memory" );
+                ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] out of memory"); // send error to javascript client
+                __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                return;
+            }
+
+            // --- set up I2S only once, it will keep sampling until oscReader gets STOP signal: https://www.instructables.com/The-Best-Way-for-Sampling-Audio-With-ESP32 ---
+
+            const char *i2sError = __oscI2sBegin__ (samplingTime, dmaBufferLength, adcchannel1);
+            if (i2sError) {
+                acquisition.end ();
+                free (unpackedSamples);
+                ((oscSharedMemory *) sharedMemory)->webSck->sendString (i2sError); // send error to javascript client
+                // ((oscSharedMemory *) sharedMemory)->webSck->closeWebSocket ();
+                __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                return;
+            }
+
+            // acknowledge the START signal only now that nothing can fail any more, so osc main thread gets either STARTED or STOPPED
+            __oscReaderStarted__ (sharedMemory, samplingTime, correctedScreenWidthTime);
+
+            // --- do the sampling, samplingTime and screenWidthTime are in us ---
+
+            // triggered or untriggered mode of operation
+            bool triggeredMode = positiveTrigger || negativeTrigger;
+
+            // the screen is built from DMA buffers as they are filled, the trigger condition is also checked across DMA buffer boundaries
+            enum { WAITING_FOR_SCREEN_REFRESH, WAITING_FOR_TRIGGER, FILLING_THE_SCREEN } screenState = triggeredMode ? WAITING_FOR_TRIGGER : FILLING_THE_SCREEN;
+            int16_t dmaBuffer [OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH];             // samples of one DMA buffer
+            bool warmUpSamples = true;                                          // (D)
+            int64_t dmaMicroseconds = 0;                                        // when the first sample of DMA buffer has been taken, measured from the beginning of sampling
+            oscI2sSample *samples = unpackedSamples ? unpackedSamples : readBuffer->samplesI2sSignal; // where the samples of the screen are collected
+            oscPreTriggerBuffer<oscI2sSample> preTrigger = { samples, __oscPreTriggerSamples__ (noOfSamplesToTake, bufferSize, preTriggerPercent), 0, 0 }; // samples taken before the trigger condition occurs
+
+            // Frame header tells javascript client to start drawing from the left of the screen. Please note that it also tells javascript client that the samples are equally spaced and what the sampling time is
+            readBuffer->header = { frameType, (int16_t) samplingTime, -1, 0 };
+            readBuffer->sampleCount = 0;
+
+            oscTriggerMode trigger (sharedMemory, screenRefreshMilliseconds);      // trigger mode, holdoff and screen refresh timing
+            oscTriggerEngine triggerEngine (sharedMemory);                          // trigger condition, checked across DMA buffer boundaries
+            oscMeasurements measurements (sharedMemory);                        // Vpp, Vrms, frequency, ... of the screen
+            bool singleShotTaken = false;                                       // Single mode stops sampling after the first triggered screen
+
+            // start the next screen in the slot that is going to be filled
+            auto startScreen = [&] () {
+                readBuffer = frameQueue->writeSlot (); // the next slot if the previous frame has been passed to oscSender
+                readBuffer->header = { frameType, (int16_t) samplingTime, -1, 0 };
+                readBuffer->sampleCount = 0;
+                if (!unpackedSamples) samples = readBuffer->samplesI2sSignal;
+                preTrigger.clear (samples);
+                screenState = triggeredMode ? WAITING_FOR_TRIGGER : FILLING_THE_SCREEN;
+                triggerEngine.rearm ();
+                trigger.arm ();
+            };
+
+            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED && !singleShotTaken) {
+
+                // read the next DMA buffer, this blocks only until DMA fills it
+                size_t bytesRead = 0;
+                esp_err_t err = i2s_read (I2S_NUM_0, 
+                                (void *) dmaBuffer,
+                                dmaBufferLength << 1, // in bytes
+                                &bytesRead,
+                                pdMS_TO_TICKS (1000)); // portMAX_DELAY); // no timeout
+                int noOfSamplesRead = bytesRead >> 1; // samples are 16 bit integers 
+                if (err != ESP_OK || noOfSamplesRead < 2) {
+                    Serial.printf ("Failed reading the samples: %d\n", err);
+                    // cout << ( dmesgQueue << "[oscilloscope][oscReader_oscReader_analog_1_signal_i2s] failed reading  the samples: " << err );
+                    i2s_driver_uninstall (I2S_NUM_0);
+                    acquisition.end ();
+                    free (unpackedSamples);
+                    ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] failed reading the samples"); // send error to javascript client
+                    // ((oscSharedMemory *) sharedMemory)->webSck->closeWebSocket ();
+                    __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                    return;
+                }
+
+                int i = 0;
+                if (warmUpSamples) { i = 8; warmUpSamples = false; } // (D), this also keeps the pairs aligned
+                __oscI2sUnswap__ (dmaBuffer, i, noOfSamplesRead, calibration);
+
+                // rearm when the screen refresh is due, DMA has been running all the time so there is no need to wait for anything else
+                if (screenState == WAITING_FOR_SCREEN_REFRESH && trigger.nextScreenDue ())
+                    startScreen ();
+
+                // the trigger kernel runs over the whole DMA buffer at once, the samples before the trigger condition are kept in circular buffer
+                if (screenState == WAITING_FOR_TRIGGER) {
+                    int triggerAt = triggerEngine.scan (dmaBuffer, i, noOfSamplesRead, dmaMicroseconds + (int64_t) i * samplingTime, samplingTime);
+                    for ( ; i < triggerAt; i ++) preTrigger.push ({dmaBuffer [i]});
+                    if (triggerAt < noOfSamplesRead) {
+                        // trigger condition has occured, the screen starts with the samples from circular buffer (in the right order)
+                        readBuffer->sampleCount = preTrigger.linearize ();
+                        readBuffer->header.triggerPosition = readBuffer->sampleCount;
+                        readBuffer->header.flags |= triggerEngine.fraction << 8; // javascript client shifts the screen by this fraction of samplingTime so that the crossing always lands on the same place
+                        screenState = FILLING_THE_SCREEN;
+                    } else if (trigger.autoTimeout ()) {
+                        // no trigger condition for too long, show untriggered screen starting with the next DMA buffer
+                        readBuffer->sampleCount = 0;
+                        screenState = FILLING_THE_SCREEN;
+                    }
+                }
+
+                for ( ; i < noOfSamplesRead && screenState == FILLING_THE_SCREEN; i ++) {
+                    samples [readBuffer->sampleCount ++].signal1 = dmaBuffer [i];
+                    if (readBuffer->sampleCount >= (unsigned int) noOfSamplesToTake) {
+                        bool triggered = readBuffer->header.triggerPosition >= 0;
+                        unsigned int measureFrom = triggered ? readBuffer->header.triggerPosition : 0; // combining may change the trigger position (envelope)
+                        // combined acquisition modes take the next screen right away until the combined one is ready to be sent, untriggered screens (Auto mode) can't be aligned so they are sent as they are
+                        if (acquisition.enabled () && (triggered || !triggeredMode) && !acquisition.combine (readBuffer, samples, acquisition.continuous () && trigger.nextScreenDue ())) {
+                            startScreen ();
+                            continue;
+                        }
+                        // measure the samples of the screen from the trigger on in one pass (before they get packed into the frame), then pass readBuffer to oscSender and just keep the DMA running until the next screen refresh
+                        if (measurements.enabled) {
+                            for (unsigned int k = measureFrom; k < readBuffer->sampleCount; k ++) measurements.add (samples [k].signal1, (int64_t) k * samplingTime);
+                            measurements.end (readBuffer);
+                        }
+                        if (unpackedSamples && readBuffer->header.frameType != OSC_FRAME_ENVELOPE) __oscPackSamples__ (readBuffer, samples); // envelope has already been put into the frame
+                        frameQueue->push (true); // viewers that haven't sent the oldest frame yet will skip it
+                        singleShotTaken = !trigger.screenDone (triggered);
+                        if (acquisition.continuous ()) startScreen (); // persistence keeps combining all the screens, it is sent again at the next screen refresh
+                        else                           screenState = WAITING_FOR_SCREEN_REFRESH;
+                    }
+                }
+
+                dmaMicroseconds += (int64_t) noOfSamplesRead * samplingTime;
+            
+            } // while sampling
+
+            // uninstall the driver
+            i2s_driver_uninstall (I2S_NUM_0);
+            acquisition.end ();
+            free (unpackedSamples);
+
+            // Single mode has taken its screen, wait for STOP signal
+            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED)
+                vTaskDelay (pdMS_TO_TICKS (10));
+
+            // acknowledge the STOP signal, oscReader worker will wait for the next job
+            __oscReaderStopped__ (sharedMemory);
+        }
+
+        #if CONFIG_IDF_TARGET_ESP32
+            // In I2S ADC mode with more than one entry in the pattern table each sample carries its ADC channel in the upper 4 bits. Unswap the samples and pair them (signal1, signal2) in place.
+            // The sample of adcchannel2 is only paired with the sample of adcchannel1 just before it, so the pairs stay aligned even if some samples get lost. Returns the number of pairs.
+            int __oscI2sDeinterleave__ (int16_t *dmaBuffer, int from, int noOfSamplesRead, adc1_channel_t adcchannel1, int16_t& pendingSignal1, const uint16_t *calibration) {
+                int noOfPairs = 0; // pairs are written behind the samples that are still to be read
+                for (int j = from; j < noOfSamplesRead - 1; j += 2) {
+                    uint16_t unswapped [2] = { (uint16_t) dmaBuffer [j + 1], (uint16_t) dmaBuffer [j] };
+                    for (uint16_t sample : unswapped) {
+                        #ifdef INVERT_I2S_READ
+                            int16_t value = ~sample & 0xFFF;
+                        #else
+                            int16_t value = sample & 0xFFF;
+                        #endif
+                        if (calibration) value = calibration [value]; // a single table lookup per sample
+                        if ((sample >> 12) == (uint16_t) adcchannel1) {
+                            pendingSignal1 = value;
+                        } else if (pendingSignal1 >= 0) {
+                            dmaBuffer [2 * noOfPairs] = pendingSignal1;
+                            dmaBuffer [2 * noOfPairs + 1] = value;
+                            noOfPairs ++;
+                            pendingSignal1 = -1;
+                        }
+                    }
+                }
+                return noOfPairs;
+            }
+
+            // oscReader that takes analog samples of 2 signals through I2S interface (DMA)
+            //  - ADC digital controller scans both ADC1 channels from its pattern table into the same DMA stream, so each signal is sampled at half of the I2S sample rate
+            //  - the samples are de-interleaved and sent as OSC_FRAME_2_SIGNALS with equal deltaTime, so javascript client draws them the same way as the samples of adc1_get_raw
+            void oscReader_analog_2_signals_i2s (void *sharedMemory) {
+                int samplingTime =                  ((oscSharedMemory *) sharedMemory)->samplingTime;
+                bool positiveTrigger =              ((oscSharedMemory *) sharedMemory)->positiveTrigger;
+                bool negativeTrigger =              ((oscSharedMemory *) sharedMemory)->negativeTrigger;
+                adc1_channel_t adcchannel1 =        ((oscSharedMemory *) sharedMemory)->adcchannel1;
+                adc1_channel_t adcchannel2 =        ((oscSharedMemory *) sharedMemory)->adcchannel2;
+                const uint16_t *calibration =       __oscAdcCalibrationTable__ (((oscSharedMemory *) sharedMemory)->analogUnit);
+                unsigned long screenWidthTime =     ((oscSharedMemory *) sharedMemory)->screenWidthTime; 
+                int preTriggerPercent =             ((oscSharedMemory *) sharedMemory)->preTriggerPercent;
+                oscFrameQueue *frameQueue =         &((oscSharedMemory *) sharedMemory)->frameQueue;
+                oscSamples *readBuffer =            frameQueue->writeSlot ();
+                unsigned int bufferSize = OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE;
+
+                // calculate correct sampling time the same way as oscReader_analog_1_signal_i2s does, but ESP32 has to convert 2 samples in each samplingTime
+                unsigned long sampleRate = 1000000 / (samplingTime); // samplingTime is in us
+                int noOfSamplesToTake = sampleRate * screenWidthTime / 1000000 + 1; // screenWidhtTime is in us, 1 sample more than the distancesbetween them
+                while (samplingTime != 1000000 / sampleRate // integer clculation rounding missmatch
+                  || (unsigned long) samplingTime * (bufferSize - 1) < screenWidthTime // samples do not fill the screen
+                  || noOfSamplesToTake > bufferSize // samples do not fit in the buffer
+                  || samplingTime < 14) // max ESP32 sampling rate = 150 kHz for both signals together (sampling time >= 2 * 6.6 us)
+                {
+                    samplingTime ++;
+                    sampleRate = 1000000 / samplingTime;
+                    noOfSamplesToTake = sampleRate * screenWidthTime / 1000000 + 1;
+                }
+                if (noOfSamplesToTake < 2) noOfSamplesToTake = 2;
+
+                // DMA buffer holds the samples of both signals, its length must be an even number and leave some usefull samples after the warm-up samples
+                int dmaBufferLength = min (2 * noOfSamplesToTake, OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH);
+                if (dmaBufferLength < 16) dmaBufferLength = 16;
+
+                // Calculate screen refresh period. It sholud be arround 50 ms (sustainable screen refresh rate is arround 20 Hz) but it is better if it is a multiple value of screenWidthTime.
+                unsigned long screenRefreshMilliseconds; // screen refresh period
+                int noOfSamplesPerScreen = screenWidthTime / samplingTime; if (noOfSamplesPerScreen * samplingTime < screenWidthTime) noOfSamplesPerScreen ++;
+                unsigned long correctedScreenWidthTime = noOfSamplesPerScreen * samplingTime;                         
+                screenRefreshMilliseconds = correctedScreenWidthTime >= 50000 ? correctedScreenWidthTime / 1000 : ((50500 / correctedScreenWidthTime) * correctedScreenWidthTime) / 1000;
+                __oscilloscope_h_debug__ ("oscReader_analog_2_signals_i2s: samplingTime = " + String (samplingTime) + ", noOfSamplesToTake = " + String (noOfSamplesToTake) + ", dmaBufferLength = " + String (dmaBufferLength));
+
+                // --- set up I2S only once with both ADC channels in the pattern table, it will keep sampling until oscReader gets STOP signal ---
+
+                const char *i2sError = __oscI2sBegin__ (samplingTime, dmaBufferLength, adcchannel1, adcchannel2);
+                if (i2sError) {
+                    ((oscSharedMemory *) sharedMemory)->webSck->sendString (i2sError); // send error to javascript client
+                    __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                    return;
+                }
+
+                // acknowledge the START signal only now that nothing can fail any more
+                __oscReaderStarted__ (sharedMemory, samplingTime, correctedScreenWidthTime);
+
+                // --- do the sampling, samplingTime and screenWidthTime are in us ---
+
+                // triggered or untriggered mode of operation
+                bool triggeredMode = positiveTrigger || negativeTrigger;
+
+                // the screen is built from DMA buffers as they are filled, the trigger condition is also checked across DMA buffer boundaries
+                enum { WAITING_FOR_SCREEN_REFRESH, WAITING_FOR_TRIGGER, FILLING_THE_SCREEN } screenState = triggeredMode ? WAITING_FOR_TRIGGER : FILLING_THE_SCREEN;
+                int16_t dmaBuffer [OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH];             // samples of one DMA buffer, (signal1, signal2) pairs after de-interleaving
+                bool warmUpSamples = true;                                          // the first samples after the initialisation are often false readings
+                int16_t pendingSignal1 = -1;                                        // the last sample of adcchannel1 that is still waiting for its pair
+                int64_t pairMicroseconds = 0;                                       // when the next pair is taken, measured from the beginning of sampling
+                oscPreTriggerBuffer<osc2SignalsSample> preTrigger = { readBuffer->samples2Signals, __oscPreTriggerSamples__ (noOfSamplesToTake, bufferSize, preTriggerPercent), 0, 0 }; // samples taken before the trigger condition occurs
+
+                readBuffer->header = { (int16_t) OSC_FRAME_2_SIGNALS, 0, -1, 0 };
+                readBuffer->sampleCount = 0;
+
+                oscTriggerMode trigger (sharedMemory, screenRefreshMilliseconds);      // trigger mode, holdoff and screen refresh timing
+                oscTriggerEngine triggerEngine (sharedMemory);                          // trigger condition on channel 1 or channel 2, checked across DMA buffer boundaries
+                oscMeasurements measurements (sharedMemory);                        // Vpp, Vrms, frequency, ... of the screen
+                bool singleShotTaken = false;                                       // Single mode stops sampling after the first triggered screen
+
+                // start the next screen in the slot that is going to be filled
+                auto startScreen = [&] () {
+                    readBuffer = frameQueue->writeSlot (); // the next slot if the previous frame has been passed to oscSender
+                    readBuffer->header = { (int16_t) OSC_FRAME_2_SIGNALS, 0, -1, 0 };
+                    readBuffer->sampleCount = 0;
+                    preTrigger.clear (readBuffer->samples2Signals);
+                    screenState = triggeredMode ? WAITING_FOR_TRIGGER : FILLING_THE_SCREEN;
+                    triggerEngine.rearm ();
+                    trigger.arm ();
+                };
+
+                while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED && !singleShotTaken) {
+
+                    // read the next DMA buffer, this blocks only until DMA fills it
+                    size_t bytesRead = 0;
+                    esp_err_t err = i2s_read (I2S_NUM_0, (void *) dmaBuffer, dmaBufferLength << 1, &bytesRead, pdMS_TO_TICKS (1000));
+                    int noOfSamplesRead = bytesRead >> 1; // samples are 16 bit integers 
+                    if (err != ESP_OK || noOfSamplesRead < 2) {
+                        // cout << ( dmesgQueue << "[oscilloscope][oscReader_analog_2_signals_i2s] failed reading  the samples: " << err );
+                        i2s_driver_uninstall (I2S_NUM_0);
+                        ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] failed reading the samples"); // send error to javascript client
+                        __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                        return;
+                    }
+
+                    int from = 0;
+                    if (warmUpSamples) { from = 8; warmUpSamples = false; } // this also keeps the pairs aligned
+                    int noOfPairs = __oscI2sDeinterleave__ (dmaBuffer, from, noOfSamplesRead, adcchannel1, pendingSignal1, calibration);
+
+                    // rearm when the screen refresh is due, DMA has been running all the time so there is no need to wait for anything else
+                    if (screenState == WAITING_FOR_SCREEN_REFRESH && trigger.nextScreenDue ())
+                        startScreen ();
+
+                    for (int i = 0; i < noOfPairs; i ++, pairMicroseconds += samplingTime) {
+                        osc2SignalsSample sample = { dmaBuffer [2 * i], dmaBuffer [2 * i + 1], (int16_t) samplingTime };
+
+                        if (screenState == WAITING_FOR_TRIGGER) {
+                            if (triggerEngine.check (triggerEngine.value (sample), pairMicroseconds)) {
+                                // trigger condition has occured, the screen starts with the samples from circular buffer (in the right order)
+                                readBuffer->sampleCount = preTrigger.linearize ();
+                                readBuffer->header.triggerPosition = readBuffer->sampleCount;
+                                readBuffer->header.flags |= triggerEngine.fraction << 8; // javascript client shifts the screen by this fraction of deltaTime so that the crossing always lands on the same place
+                                screenState = FILLING_THE_SCREEN;
+                            } else {
+                                preTrigger.push (sample);
+                                if (trigger.autoTimeout ()) { // no trigger condition for too long, show untriggered screen starting with the next sample
+                                    readBuffer->sampleCount = 0;
+                                    screenState = FILLING_THE_SCREEN;
+                                }
+                                continue;
+                            }
+                        }
+
+                        if (screenState == FILLING_THE_SCREEN) {
+                            if (!readBuffer->sampleCount) sample.deltaTime = 0; // timeOffset (from left of the screen) = 0
+                            readBuffer->samples2Signals [readBuffer->sampleCount ++] = sample;
+                            if (readBuffer->sampleCount >= (unsigned int) noOfSamplesToTake) {
+                                readBuffer->samples2Signals [0].deltaTime = 0; // the oldest pre-trigger sample starts the screen
+                                bool triggered = readBuffer->header.triggerPosition >= 0;
+                                // measure channel 1 of the screen from the trigger on in one pass, then pass readBuffer to oscSender and just keep the DMA running until the next screen refresh
+                                if (measurements.enabled) {
+                                    for (unsigned int k = triggered ? readBuffer->header.triggerPosition : 0; k < readBuffer->sampleCount; k ++) measurements.add (readBuffer->samples2Signals [k].signal1, (int64_t) k * samplingTime);
+                                    measurements.end (readBuffer);
+                                }
+                                frameQueue->push (true); // viewers that haven't sent the oldest frame yet will skip it
+                                singleShotTaken = !trigger.screenDone (triggered);
+                                screenState = WAITING_FOR_SCREEN_REFRESH;
+                            }
+                        }
+                    }
+
+                    pairMicroseconds += (int64_t) (noOfSamplesRead - from - 2 * noOfPairs) / 2 * samplingTime; // keep the time running over the samples that haven't been paired
+
+                } // while sampling
+
+                // uninstall the driver
+                i2s_driver_uninstall (I2S_NUM_0);
+
+                // Single mode has taken its screen, wait for STOP signal
+                while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED)
+                    vTaskDelay (pdMS_TO_TICKS (10));
+
+                // acknowledge the STOP signal, oscReader worker will wait for the next job
+                __oscReaderStopped__ (sharedMemory);
+            }
+        #endif
+
+
+        // oscReader that takes one deep record of analog samples of 1 signal through I2S interface (DMA) into PSRAM
+        //  - the record is not limited by the frame size, it is taken at full sampling rate and only then sent to javascript client in numbered fragments
+        //  - while waiting for the trigger condition the first part of the record (pre-trigger) is used as circular buffer
+        //  - after the whole record is sent oscReader just waits for STOP signal, javascript client can zoom into the record in the meantime
+        void oscReader_deepRecord_i2s (void *sharedMemory) {
+            int samplingTime =                  ((oscSharedMemory *) sharedMemory)->samplingTime;
+            bool positiveTrigger =              ((oscSharedMemory *) sharedMemory)->positiveTrigger;
+            bool negativeTrigger =              ((oscSharedMemory *) sharedMemory)->negativeTrigger;
+            adc1_channel_t adcchannel1 =        ((oscSharedMemory *) sharedMemory)->adcchannel1;
+            const uint16_t *calibration =       __oscAdcCalibrationTable__ (((oscSharedMemory *) sharedMemory)->analogUnit);
+            int preTriggerPercent =             ((oscSharedMemory *) sharedMemory)->preTriggerPercent;
+            unsigned long recordLength =        ((oscSharedMemory *) sharedMemory)->recordLength;
+            oscFrameQueue *frameQueue =         &((oscSharedMemory *) sharedMemory)->frameQueue;
+
+            // calculate correct sampling time so that it will prefectly aligh with sampleRate (regarding integer calculation rounding), the screen width doesn't limit the number of samples here
+            unsigned long sampleRate = 1000000 / (samplingTime); // samplingTime is in us
+            while (samplingTime != 1000000 / sampleRate // integer clculation rounding missmatch
+              || samplingTime < 7) // max ESP32 sampling rate = 150 kHz (sampling time >= 6.6 us)
+            {
+                samplingTime ++;
+                sampleRate = 1000000 / samplingTime;
+            }
+            __oscilloscope_h_debug__ ("oscReader_deepRecord_i2s: samplingTime = " + String (samplingTime) + ", recordLength = " + String (recordLength));
+
+            // the record is too large for internal RAM
+            int16_t *record = (int16_t *) heap_caps_malloc (recordLength * sizeof (int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (!record) {
+                // cout << ( dmesgQueue << "[oscilloscope][oscReader_deepRecord_i2s] not enough PSRAM for the record" );
+                ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] not enough PSRAM for the record"); // send error to javascript client
+                __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                return;
+            }
+
+            // --- set up I2S, it will keep sampling until the record is full ---
+
+            const char *i2sError = __oscI2sBegin__ (samplingTime, OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH, adcchannel1);
+            if (i2sError) {
+                free (record);
+                ((oscSharedMemory *) sharedMemory)->webSck->sendString (i2sError); // send error to javascript client
+                __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                return;
+            }
+
+            // acknowledge the START signal only now that nothing can fail any more
+            __oscReaderStarted__ (sharedMemory, samplingTime, ((oscSharedMemory *) sharedMemory)->screenWidthTime);
+
+            // --- do the sampling, samplingTime is in us ---
+
+            // triggered or untriggered mode of operation
+            bool triggeredMode = positiveTrigger || negativeTrigger;
+
+            enum { WAITING_FOR_TRIGGER, RECORDING, RECORDED } recordState = triggeredMode ? WAITING_FOR_TRIGGER : RECORDING;
+            int16_t dmaBuffer [OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH];             // samples of one DMA buffer
+            bool warmUpSamples = true;                                          // the first is2_read after the initialisation often contains false readings
+            oscTriggerEngine triggerEngine (sharedMemory);                      // trigger condition, checked across DMA buffer boundaries
+            int64_t sampleMicroseconds = 0;                                     // when the sample has been taken, measured from the beginning of sampling
+            unsigned long preTriggerSamples = triggeredMode ? recordLength * preTriggerPercent / 100 : 0; // the size of circular buffer at the beginning of the record
+            unsigned long sampleCount = 0;                                      // number of samples in the record
+            unsigned long circularHead = 0;                                     // where the next sample goes while waiting for the trigger condition
+            long triggerSample = -1;                                            // index of the first sample after the trigger condition occured
+
+            while (recordState != RECORDED && ((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) {
+
+                // read the next DMA buffer, this blocks only until DMA fills it
+                size_t bytesRead = 0;
+                esp_err_t err = i2s_read (I2S_NUM_0, (void *) dmaBuffer, sizeof (dmaBuffer), &bytesRead, pdMS_TO_TICKS (1000));
+                int noOfSamplesRead = bytesRead >> 1; // samples are 16 bit integers 
+                if (err != ESP_OK || noOfSamplesRead < 2) {
+                    // cout << ( dmesgQueue << "[oscilloscope][oscReader_deepRecord_i2s] failed reading  the samples: " << err );
+                    i2s_driver_uninstall (I2S_NUM_0);
+                    free (record);
+                    ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] failed reading the samples"); // send error to javascript client
+                    __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                    return;
+                }
+
+                int i = 0;
+                if (warmUpSamples) { i = 8; warmUpSamples = false; } // this also keeps the pairs aligned
+                __oscI2sUnswap__ (dmaBuffer, i, noOfSamplesRead, calibration);
+
+                for ( ; i < noOfSamplesRead && recordState != RECORDED; i ++, sampleMicroseconds += samplingTime) {
+                    int16_t newSample = dmaBuffer [i];
+
+                    if (recordState == WAITING_FOR_TRIGGER) {
+                        if (!triggerEngine.check (newSample, sampleMicroseconds)) {
+                            // keep the samples in circular buffer while waiting for trigger condition
+                            if (preTriggerSamples) {
+                                record [circularHead] = newSample;
+                                circularHead = (circularHead + 1) % preTriggerSamples;
+                                if (sampleCount < preTriggerSamples) sampleCount ++;
+                            }
+                            continue;
+                        }
+                        // trigger condition has occured, put the samples from circular buffer in the right order, the oldest first
+                        if (sampleCount == preTriggerSamples) std::rotate (record, record + circularHead, record + sampleCount);
+                        triggerSample = sampleCount;
+                        recordState = RECORDING;
+                    }
+
+                    record [sampleCount ++] = newSample;
+                    if (sampleCount >= recordLength) recordState = RECORDED;
+                }
+
+            } // while recording
+
+            // uninstall the driver
+            i2s_driver_uninstall (I2S_NUM_0);
+
+            // --- send the record in fragments, unlike the screens none of them may be skipped ---
+
+            if (recordState == RECORDED) {
+                unsigned int fragments = (sampleCount + OSCILLOSCOPE_DEEP_RECORD_FRAGMENT_SIZE - 1) / OSCILLOSCOPE_DEEP_RECORD_FRAGMENT_SIZE;
+                for (unsigned int fragment = 0; fragment < fragments && ((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED; ) {
+                    oscSamples *readBuffer = frameQueue->writeSlot ();
+                    unsigned long firstSample = (unsigned long) fragment * OSCILLOSCOPE_DEEP_RECORD_FRAGMENT_SIZE;
+                    readBuffer->header = { OSC_FRAME_DEEP_RECORD, (int16_t) samplingTime, -1, 0 };
+                    readBuffer->deepRecord.fragment = fragment;
+                    readBuffer->deepRecord.fragments = fragments;
+                    readBuffer->deepRecord.triggerFragment = triggerSample < 0 ? 0xFFFF : triggerSample / OSCILLOSCOPE_DEEP_RECORD_FRAGMENT_SIZE;
+                    readBuffer->deepRecord.triggerPosition = triggerSample < 0 ? 0 : triggerSample % OSCILLOSCOPE_DEEP_RECORD_FRAGMENT_SIZE;
+                    readBuffer->sampleCount = min (sampleCount - firstSample, (unsigned long) OSCILLOSCOPE_DEEP_RECORD_FRAGMENT_SIZE);
+                    memcpy (readBuffer->deepRecord.samples, record + firstSample, readBuffer->sampleCount * sizeof (oscI2sSample));
+
+                    if (frameQueue->push ())
+                        fragment ++;
+                    else
+                        vTaskDelay (pdMS_TO_TICKS (1)); // the oldest frame hasn't been sent yet, fill the same slot again when it is
+                }
+            }
+            free (record);
+
+            // the record has been sent, wait for STOP signal
+            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED)
+                vTaskDelay (pdMS_TO_TICKS (10));
+
+            // acknowledge the STOP signal, oscReader worker will wait for the next job
+            __oscReaderStopped__ (sharedMemory);
+        }
+
+        // fills window table with Q15 values of the window function, returns coherent gain of the window (the mean of its values)
+        float __oscSpectrumWindow__ (int16_t *window, unsigned char windowType) {
+            double sum = 0;
+            for (int i = 0; i < OSCILLOSCOPE_FFT_SIZE; i ++) {
+                double x = 2 * M_PI * i / OSCILLOSCOPE_FFT_SIZE; // periodic windows, they fit the continuous signal better than symmetric ones
+                double w;
+                switch (windowType) {
+                    case OSC_WINDOW_HANN:       w = 0.5 - 0.5 * cos (x); break;
+                    case OSC_WINDOW_FLAT_TOP:   w = 0.21557895 - 0.41663158 * cos (x) + 0.277263158 * cos (2 * x) - 0.083578947 * cos (3 * x) + 0.006947368 * cos (4 * x); break;
+                    case OSC_WINDOW_BLACKMAN:   w = 0.42 - 0.5 * cos (x) + 0.08 * cos (2 * x); break;
+                    default:                    w = 1; break; // OSC_WINDOW_RECTANGULAR
+                }
+                window [i] = (int16_t) lround (w * 32767);
+                sum += w;
+            }
+            return sum / OSCILLOSCOPE_FFT_SIZE;
+        }
+
+        // In place radix-2 FFT of OSCILLOSCOPE_FFT_SIZE complex Q15 values (real and imaginary parts interleaved). Each stage is scaled by 1/2 so the result is
+        // divided by OSCILLOSCOPE_FFT_SIZE and can never overflow. esp-dsp library (if present) uses ESP32 DSP or ESP32-S3 SIMD instructions, otherwise plain C++ is used.
+        // Returns false if FFT tables could not be initialized.
+        bool __oscFft__ (int16_t *data) {
+            #if __has_include (<esp_dsp.h>)
+                static bool fftInitialized = dsps_fft2r_init_sc16 (NULL, OSCILLOSCOPE_FFT_SIZE) == ESP_OK; // static initialization runs only once even if more oscilloscopes start at the same time
+                if (!fftInitialized) return false;
+                dsps_fft2r_sc16 (data, OSCILLOSCOPE_FFT_SIZE);
+                dsps_bit_rev_sc16_ansi (data, OSCILLOSCOPE_FFT_SIZE);
+            #else
+                static int16_t twiddle [OSCILLOSCOPE_FFT_SIZE]; // cos and -sin of OSCILLOSCOPE_FFT_SIZE / 2 angles
+                static bool fftInitialized = [] () -> bool { // static initialization runs only once even if more oscilloscopes start at the same time
+                    for (int k = 0; k < OSCILLOSCOPE_FFT_SIZE / 2; k ++) {
+                        twiddle [2 * k] = (int16_t) lround (32767 * cos (2 * M_PI * k / OSCILLOSCOPE_FFT_SIZE));
+                        twiddle [2 * k + 1] = (int16_t) lround (-32767 * sin (2 * M_PI * k / OSCILLOSCOPE_FFT_SIZE));
+                    }
+                    return true;
+                } ();
+                if (!fftInitialized) return false;
+
+                // bit reversal permutation
+                for (int i = 1, j = 0; i < OSCILLOSCOPE_FFT_SIZE; i ++) {
+                    int bit = OSCILLOSCOPE_FFT_SIZE >> 1;
+                    for ( ; j & bit; bit >>= 1) j ^= bit;
+                    j ^= bit;
+                    if (i < j) { std::swap (data [2 * i], data [2 * j]); std::swap (data [2 * i + 1], data [2 * j + 1]); }
+                }
+
+                // butterflies, the magnitudes never grow since each stage is scaled by 1/2
+                for (int length = 2; length <= OSCILLOSCOPE_FFT_SIZE; length <<= 1) {
+                    int step = OSCILLOSCOPE_FFT_SIZE / length;
+                    for (int i = 0; i < OSCILLOSCOPE_FFT_SIZE; i += length)
+                        for (int k = 0; k < length / 2; k ++) {
+                            int16_t *a = data + 2 * (i + k);
+                            int16_t *b = a + length; // length / 2 complex values further
+                            int32_t wr = twiddle [2 * k * step];
+                            int32_t wi = twiddle [2 * k * step + 1];
+                            int32_t tr = (b [0] * wr - b [1] * wi) >> 15;
+                            int32_t ti = (b [0] * wi + b [1] * wr) >> 15;
+                            b [0] = (a [0] - tr) >> 1; b [1] = (a [1] - ti) >> 1;
+                            a [0] = (a [0] + tr) >> 1; a [1] = (a [1] + ti) >> 1;
+                        }
+                }
+            #endif
+            return true;
+        }
+
+        // oscReader that calculates the spectrum of 1 analog signal sampled through I2S interface (DMA)
+        //  - OSCILLOSCOPE_FFT_SIZE continuous samples are windowed and transformed by fixed-point FFT, the powers of spectrumAverage such spectra are averaged
+        //  - only OSCILLOSCOPE_FFT_SIZE / 2 frequency bins (in dB) are sent to javascript client instead of OSCILLOSCOPE_FFT_SIZE samples
+        //  - the trigger is not used, DC component is removed before FFT
+        void oscReader_spectrum_i2s (void *sharedMemory) {
+            int samplingTime =                  ((oscSharedMemory *) sharedMemory)->samplingTime;
+            adc1_channel_t adcchannel1 =        ((oscSharedMemory *) sharedMemory)->adcchannel1;
+            const uint16_t *calibration =       __oscAdcCalibrationTable__ (((oscSharedMemory *) sharedMemory)->analogUnit);
+            int sampleBits =                    ((oscSharedMemory *) sharedMemory)->sampleBits;
+            unsigned char spectrumWindow =      ((oscSharedMemory *) sharedMemory)->spectrumWindow;
+            int spectrumAverage =               ((oscSharedMemory *) sharedMemory)->spectrumAverage;
+            oscFrameQueue *frameQueue =         &((oscSharedMemory *) sharedMemory)->frameQueue;
+
+            // calculate correct sampling time so that it will prefectly aligh with sampleRate (regarding integer calculation rounding), the screen shows frequencies from 0 to sampleRate / 2
+            unsigned long sampleRate = 1000000 / (samplingTime); // samplingTime is in us
+            while (samplingTime != 1000000 / sampleRate // integer clculation rounding missmatch
+              || samplingTime < 7) // max ESP32 sampling rate = 150 kHz (sampling time >= 6.6 us)
+            {
+                samplingTime ++;
+                sampleRate = 1000000 / samplingTime;
+            }
 
-            readBuffer->samplesAreReady = true; // this information will be always copied to sendBuffer together with the samples
+            // one FFT covers OSCILLOSCOPE_FFT_SIZE samples, the screen refresh period should be arround 50 ms (sustainable screen refresh rate is arround 20 Hz) or as long as the averaged spectra take
+            unsigned long fftTime = (unsigned long) OSCILLOSCOPE_FFT_SIZE * samplingTime;
+            unsigned long screenRefreshMilliseconds = max (50UL, fftTime * spectrumAverage / 1000);
+            __oscilloscope_h_debug__ ("oscReader_spectrum_i2s: samplingTime = " + String (samplingTime) + ", screenRefreshMilliseconds = " + String (screenRefreshMilliseconds));
+
+            // window table, complex FFT buffer and accumulated powers of frequency bins are too large for oscReader's stack
+            int16_t *window = (int16_t *) malloc (OSCILLOSCOPE_FFT_SIZE * sizeof (int16_t));
+            int16_t *fftBuffer = (int16_t *) malloc (2 * OSCILLOSCOPE_FFT_SIZE * sizeof (int16_t));
+            uint64_t *power = (uint64_t *) calloc (OSCILLOSCOPE_FFT_SIZE / 2, sizeof (uint64_t));
+            if (!window || !fftBuffer || !power) {
+                free (window); free (fftBuffer); free (power);
+                // cout << ( dmesgQueue << "[oscilloscope][oscReader_spectrum_i2s] out of memory" );
+                ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] out of memory"); // send error to javascript client
+                __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                return;
+            }
+            // 0 dB is full scale sine: the samples are shifted to 15 bits so its amplitude is 2047.5 * 8, window reduces it by its coherent gain, FFT divides it by 2 (the other half is in negative frequencies)
+            float fullScale = 8190 * __oscSpectrumWindow__ (window, spectrumWindow);
+            float fullScalePower = fullScale * fullScale;
+
+            // --- set up I2S only once, it will keep sampling until oscReader gets STOP signal ---
+
+            const char *i2sError = __oscI2sBegin__ (samplingTime, OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH, adcchannel1);
+            if (i2sError) {
+                free (window); free (fftBuffer); free (power);
+                ((oscSharedMemory *) sharedMemory)->webSck->sendString (i2sError); // send error to javascript client
+                __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                return;
+            }
 
-            // wait for the START signal
-            while (((oscSharedMemory *) sharedMemory)->oscReaderState != START) delay (1);
-            ((oscSharedMemory *) sharedMemory)->oscReaderState = STARTED; 
+            // acknowledge the START signal only now that nothing can fail any more
+            __oscReaderStarted__ (sharedMemory, samplingTime, fftTime);
 
-            // --- do the sampling, samplingTime and screenWidthTime are in us ---
+            // --- do the sampling, samplingTime is in us ---
 
-            // triggered or untriggered mode of operation
-            bool triggeredMode = positiveTrigger || negativeTrigger;
-            int noOfSamplesTaken = 0;
-
-            TickType_t lastScreenRefreshTicks = xTaskGetTickCount ();               // for timing screen refresh intervals            
-
-            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) { // sampling from the left of the screen - while not getting STOP signal
-
-                // Insert first dummy sample to read-buffer this tells javascript client to start drawing from the left of the screen. Please note that it also tells javascript client how many signals are in each sample
-                readBuffer->samplesI2sSignal [0].signal1 = -samplingTime; // no real data sample can look like this
-                // readBuffer->sampleCount = 1;
-                // take (the rest of the) samples that fit on one screen: https://www.instructables.com/The-Best-Way-for-Sampling-Audio-With-ESP32
-
-                // setupI2S
-                esp_err_t err;
-
-                #pragma GCC diagnostic push
-                #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
-                i2s_config_t i2s_config = { 
-                    .mode = (i2s_mode_t) (I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN),
-                    .sample_rate = (uint32_t) ((1000000 / samplingTime) * I2S_FREQ_CORRECTION), // = samplingFrequency (samplingTime is in us),
-                    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT, // could only get it to work with 32bits
-                    .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT, // <- mono signal - stereo signal -> I2S_CHANNEL_FMT_RIGHT_LEFT, // although the SEL config should be left, it seems to transmit on right
-                    .communication_format = i2s_comm_format_t (I2S_COMM_FORMAT_STAND_I2S), //// I2S_COMM_FORMAT_STAND_I2S, // I2S_COMM_FORMAT_I2S_MSB, - deprecated
-                    .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1, // Interrupt level 1
-                    .dma_buf_count = 4, // number of buffers
-                    .dma_buf_len = noOfSamplesToTakeFirstTime, // samples per buffer
-                    .use_apll = true // false//,
-                    //.tx_desc_auto_clear = false,
-                    //.fixed_mclk = 1
-                };
-                #pragma GCC diagnostic pop
-              
-                err = i2s_driver_install (I2S_NUM_0, &i2s_config,  0, NULL);  //step 2
-
-                if (err != ESP_OK) {
-                    // DEBUG: Serial.printf ("Failed installing driver: %d\n", err);
-                    // cout << ( dmesgQueue << "[oscilloscope][oscReader_oscReader_analog_1_signal_i2s] failed to install the driver: " << err );
-                    ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] failed to install the i2s driver."); // send error to javascript client
-                    // ((oscSharedMemory *) sharedMemory)->webSck->closeWebSocket ();
-                    // wait for the STOP signal
-                    while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-                    ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED;
-                    vTaskDelete (NULL);
-                }
+            enum { WAITING_FOR_SCREEN_REFRESH, SAMPLING } screenState = SAMPLING;
+            int16_t dmaBuffer [OSCILLOSCOPE_I2S_DMA_BUFFER_LENGTH];             // samples of one DMA buffer
+            bool warmUpSamples = true;                                          // the first is2_read after the initialisation often contains false readings
+            int fftSamples = 0;                                                 // number of samples in fftBuffer
+            int spectra = 0;                                                    // number of spectra accumulated in power
+            oscTriggerMode trigger (sharedMemory, screenRefreshMilliseconds);   // screen refresh timing, Single mode stops after the first spectrum
+            bool singleShotTaken = false;
 
-                err = i2s_set_adc_mode (ADC_UNIT_1, adcchannel1);
-                if (err != ESP_OK) {
-                    // DEBUG: Serial.printf ("Failed setting up adc mode: %d\n", err);
-                    // cout << ( dmesgQueue << "[oscilloscope][oscReader_oscReader_analog_1_signal_i2s] failed setting up adc mode: " << err );
+            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED && !singleShotTaken) {
+
+                // read the next DMA buffer, this blocks only until DMA fills it
+                size_t bytesRead = 0;
+                esp_err_t err = i2s_read (I2S_NUM_0, (void *) dmaBuffer, sizeof (dmaBuffer), &bytesRead, pdMS_TO_TICKS (1000));
+                int noOfSamplesRead = bytesRead >> 1; // samples are 16 bit integers 
+                if (err != ESP_OK || noOfSamplesRead < 2) {
+                    // cout << ( dmesgQueue << "[oscilloscope][oscReader_spectrum_i2s] failed reading  the samples: " << err );
                     i2s_driver_uninstall (I2S_NUM_0);
-                    ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] failed setting up i2s adc mode"); // send error to javascript client
-                    // ((oscSharedMemory *) sharedMemory)->webSck->closeWebSocket ();
-                    // wait for the STOP signal
-                    while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-                    ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED;                
-                    vTaskDelete (NULL);
+                    free (window); free (fftBuffer); free (power);
+                    ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] failed reading the samples"); // send error to javascript client
+                    __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                    return;
                 }
 
-                while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED) {
+                int i = 0;
+                if (warmUpSamples) { i = 8; warmUpSamples = false; } // this also keeps the pairs aligned
+                __oscI2sUnswap__ (dmaBuffer, i, noOfSamplesRead, calibration);
+
+                // DMA has been running all the time so the next spectrum can start as soon as the screen refresh is due
+                if (screenState == WAITING_FOR_SCREEN_REFRESH && trigger.nextScreenDue ())
+                    screenState = SAMPLING;
+
+                for ( ; i < noOfSamplesRead && screenState == SAMPLING; i ++) {
+                    fftBuffer [2 * fftSamples ++] = dmaBuffer [i]; // only the real parts for now
+                    if (fftSamples < OSCILLOSCOPE_FFT_SIZE) continue;
+                    fftSamples = 0;
+
+                    // remove DC component, shift 12 bit samples to 15 bits and apply the window
+                    int32_t sum = 0;
+                    for (int k = 0; k < OSCILLOSCOPE_FFT_SIZE; k ++) sum += fftBuffer [2 * k];
+                    int16_t dc = sum / OSCILLOSCOPE_FFT_SIZE;
+                    for (int k = 0; k < OSCILLOSCOPE_FFT_SIZE; k ++) {
+                        fftBuffer [2 * k] = ((int32_t) (fftBuffer [2 * k] - dc) * 8 * window [k]) >> 15;
+                        fftBuffer [2 * k + 1] = 0;
+                    }
 
-                    // read the whole buffer
-                    size_t bytesRead = 0;
-                    err = i2s_read (I2S_NUM_0, 
-                                    (void *) &readBuffer->samplesI2sSignal [1], // skip the first (dummy) sample
-                                    noOfSamplesToTakeFirstTime << 1, // in bytes
-                                    &bytesRead,
-                                    pdMS_TO_TICKS (1000)); // portMAX_DELAY); // no timeout
-                    noOfSamplesTaken = bytesRead >> 1; // samples are 16 bit integers 
-                    if (err != ESP_OK || noOfSamplesTaken < 10) { // we'll leave first 8 samples out so if we don't have even 2 usable samples there is probably something wrong
-                        Serial.printf ("Failed reading the samples: %d\n", err);
-                        // cout << ( dmesgQueue << "[oscilloscope][oscReader_oscReader_analog_1_signal_i2s] failed reading  the samples: " << err );
+                    if (!__oscFft__ (fftBuffer)) {
+                        // cout << ( dmesgQueue << "[oscilloscope][oscReader_spectrum_i2s] could not initialize FFT" );
                         i2s_driver_uninstall (I2S_NUM_0);
-                        ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] failed reading the samples"); // send error to javascript client
-                        // ((oscSharedMemory *) sharedMemory)->webSck->closeWebSocket ();
-                        // wait for the STOP signal
-                        while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-                        ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED;                    
-                        vTaskDelete (NULL);
+                        free (window); free (fftBuffer); free (power);
+                        ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] could not initialize FFT"); // send error to javascript client
+                        __oscReaderStopped__ (sharedMemory); // no more sampling, tell osc main thread
+                        return;
                     }
+                    for (int k = 0; k < OSCILLOSCOPE_FFT_SIZE / 2; k ++)
+                        power [k] += (int32_t) fftBuffer [2 * k] * fftBuffer [2 * k] + (int32_t) fftBuffer [2 * k + 1] * fftBuffer [2 * k + 1];
+                    if (++ spectra < spectrumAverage) continue;
+
+                    // convert the averaged powers to dB and pass the frame to oscSender
+                    oscSamples *readBuffer = frameQueue->writeSlot ();
+                    readBuffer->header = { (int16_t) (sampleBits == 8 ? OSC_FRAME_SPECTRUM_8_BITS : OSC_FRAME_SPECTRUM), (int16_t) samplingTime, -1, 0 };
+                    for (int k = 0; k < OSCILLOSCOPE_FFT_SIZE / 2; k ++) {
+                        float dB = power [k] ? 10 * log10f ((float) power [k] / spectra / fullScalePower) : -1000;
+                        if (sampleBits == 8) readBuffer->spectrum8Bits [k] = dB >= 0 ? 0 : dB <= -127.5 ? 255 : (uint8_t) (-2 * dB + 0.5f);
+                        else                 readBuffer->spectrum [k] = dB >= 327.67 ? 32767 : dB <= -327.68 ? -32768 : (int16_t) lroundf (dB * 100);
+                        power [k] = 0;
+                    }
+                    readBuffer->sampleCount = OSCILLOSCOPE_FFT_SIZE / 2;
+                    frameQueue->push (true); // viewers that haven't sent the oldest frame yet will skip it
+                    spectra = 0;
+                    singleShotTaken = !trigger.screenDone (false);
+                    screenState = WAITING_FOR_SCREEN_REFRESH;
+                }
 
-                    // For some strange reason the sample come swapped two-by two. Unswap them and filter out only 12 bits that actually hold the value while also skipping the first 8 samples
-                    noOfSamplesTaken -= 8;
-                    #ifdef INVERT_I2S_READ
-                        for (int i = 1; i <= noOfSamplesTaken; i += 2) {
-                            readBuffer->samplesI2sSignal [i].signal1 = ~readBuffer->samplesI2sSignal [i + 9].signal1 & 0xFFF;
-                            readBuffer->samplesI2sSignal [i + 1].signal1 = ~readBuffer->samplesI2sSignal [i + 8].signal1 & 0xFFF;
-                        }
-                    #else
-                        for (int i = 1; i <= noOfSamplesTaken; i += 2) {
-                            readBuffer->samplesI2sSignal [i].signal1 = readBuffer->samplesI2sSignal [i + 9].signal1 & 0xFFF;
-                            readBuffer->samplesI2sSignal [i + 1].signal1 = readBuffer->samplesI2sSignal [i + 8].signal1 & 0xFFF;
-                        }
-                    #endif
-
-                    if (!triggeredMode) break; // if not in triggered modt then we already have what we need
-
-                    // if in triggered mode try to find trigger condition
-                    for (int i = 1; i < noOfSamplesTaken; i++) {
-                        if ( (positiveTrigger && readBuffer->samplesI2sSignal [i].signal1 < positiveTriggerTreshold && readBuffer->samplesI2sSignal [i + 1].signal1 >= positiveTriggerTreshold) || (negativeTrigger && readBuffer->samplesI2sSignal [i].signal1 > negativeTriggerTreshold && readBuffer->samplesI2sSignal [i + 1].signal1 <= negativeTriggerTreshold) ) { 
-                            // trigger condition found at i, copy the rest of the buffer to its beginning and do another i2s_read for the samples that are missing
-                            if (i > 1) {
-                                int noOfSamplesToTakeSecondTime = (i - 1);
-                                // there is a bug in i2s_read: it odd number of samples are to be read the last one is always 0, so make sure we have even number of samples
-                                if (noOfSamplesToTakeSecondTime % 2 != 0) noOfSamplesToTakeSecondTime ++;
-                                if (noOfSamplesToTakeSecondTime < 8) noOfSamplesToTakeSecondTime = 8;
-                                int fromInd = noOfSamplesTaken - (i - 1) + 1;
-                                __oscilloscope_h_debug__ ("oscReader_analog_1_signal_i2s: trigger condition found at " + String (i) + " need to read additional " + String (need to read additional) + " samples at buffer position " + String (fromInd));
-                                memcpy ((void*) &readBuffer->samplesI2sSignal [1], (void*) &readBuffer->samplesI2sSignal [i], (noOfSamplesTaken - (i - 1)) << 1);
-                                err = i2s_read (I2S_NUM_0, 
-                                                (void*) &readBuffer->samplesI2sSignal [fromInd],
-                                                noOfSamplesToTakeSecondTime << 1, // in bytes
-                                                &bytesRead,
-                                                pdMS_TO_TICKS (1000)); // portMAX_DELAY); // no timeout
-                                if (err != ESP_OK || noOfSamplesTaken == 0) {
-                                    Serial.printf ("Failed reading the samples: %d\n", err);
-                                    // cout << ( dmesgQueue << "[oscilloscope][oscReader_oscReader_analog_1_signal_i2s] failed reading the samples: " << err );
-                                    i2s_driver_uninstall (I2S_NUM_0);
-                                    ((oscSharedMemory *) sharedMemory)->webSck->sendString ("[oscilloscope] failed reading the samples"); // send error to javascript client
-                                    // ((oscSharedMemory *) sharedMemory)->webSck->closeWebSocket ();
-                                    // wait for the STOP signal
-                                    while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-                                    ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED;                                
-                                    vTaskDelete (NULL);
-                                }
-                                noOfSamplesTaken = noOfSamplesTaken - (i - 1) + (bytesRead >> 1); // - deleted samples + newly read samples (normally we would end up with the same number)
-                                // for (int j = fromInd; j <= noOfSamplesTaken; j++) readBuffer->samplesI2sSignal [j].signal1 &= 0x0FFF;
-                                // For some strange reason the sample come swapped two-by two. Unswap them and filter out only 12 bits that actually hold the value
-                                #ifdef INVERT_I2S_READ
-                                    for (int j = fromInd; j < noOfSamplesTaken; j += 2) {
-                                        int16_t tmp = readBuffer->samplesI2sSignal [j].signal1;
-                                        readBuffer->samplesI2sSignal [j].signal1 = ~readBuffer->samplesI2sSignal [j + 1].signal1 & 0xFFF;
-                                        readBuffer->samplesI2sSignal [j + 1].signal1 = ~tmp & 0x0FFF;
-                                    }
-                                #else
-                                    for (int j = fromInd; j < noOfSamplesTaken; j += 2) {
-                                        int16_t tmp = readBuffer->samplesI2sSignal [j].signal1;
-                                        readBuffer->samplesI2sSignal [j].signal1 = readBuffer->samplesI2sSignal [j + 1].signal1 & 0xFFF;
-                                        readBuffer->samplesI2sSignal [j + 1].signal1 = tmp & 0x0FFF;
-                                    }
-                                #endif
-                            }
+            } // while sampling
 
-                            goto passSamplesToOscSender;
-                        }
-                    }
-                    // trigger condition not found, continue reading
-                } // while (true)
+            // uninstall the driver
+            i2s_driver_uninstall (I2S_NUM_0);
+            free (window); free (fftBuffer); free (power);
 
-            passSamplesToOscSender:
+            // Single mode has taken its spectrum, wait for STOP signal
+            while (((oscSharedMemory *) sharedMemory)->oscReaderState == STARTED)
+                vTaskDelay (pdMS_TO_TICKS (10));
 
-                // pass readBuffer to oscSender
-                readBuffer->sampleCount = noOfSamplesTaken + 1; // + 1 dummy sample
-                if (!sendBuffer->samplesAreReady) 
-                    *sendBuffer = *readBuffer;
+            // acknowledge the STOP signal, oscReader worker will wait for the next job
+            __oscReaderStopped__ (sharedMemory);
+        }
+    #endif
 
-                // uninstall the driver
-                i2s_driver_uninstall (I2S_NUM_0);
 
-                // wait before next screen refresh
-                vTaskDelayUntil (&lastScreenRefreshTicks, pdMS_TO_TICKS (screenRefreshMilliseconds));
-            
-            } // while sampling
+    // oscilloscope control protocol oscilloscope control protocol oscilloscope control protocol oscilloscope control protocol oscilloscope control protocol
 
-            // wait for the STOP signal
-            while (((oscSharedMemory *) sharedMemory)->oscReaderState != STOP) delay (1);
-            ((oscSharedMemory *) sharedMemory)->oscReaderState = STOPPED; 
+    // receives the next control message and puts it into ESP32 byte order, returns false if the message doesn't follow the protocol
+    bool __oscRecvControl__ (httpServer_t::webSocket_t *webSck, bool clientIsBigEndian, oscControlMessage *msg) {
+        int received = webSck->recvBlock ((byte *) msg, sizeof (oscControlMessage));
+        if (received < (int) sizeof (oscControlHeader)) return false;
+        if (clientIsBigEndian) msg->header.length = ntohs (msg->header.length);
+        if (msg->header.version != OSC_PROTOCOL_VERSION || sizeof (oscControlHeader) + msg->header.length > (size_t) received) return false;
 
-            vTaskDelete (NULL);
+        for (uint16_t i = 0; i + 2 <= msg->header.length; i += 2 + msg->parameters [i + 1]) {
+            uint8_t *value = msg->parameters + i + 2;
+            uint8_t length = msg->parameters [i + 1];
+            if (i + 2 + length > msg->header.length) return false;
+            if (clientIsBigEndian)
+                switch (msg->parameters [i] & 0xC0) {
+                    case OSC_PARAM_16:  for (uint8_t j = 0; j + 1 < length; j += 2) std::swap (value [j], value [j + 1]); break;
+                    case OSC_PARAM_32:  for (uint8_t j = 0; j + 3 < length; j += 4) { std::swap (value [j], value [j + 3]); std::swap (value [j + 1], value [j + 2]); } break;
+                }
         }
-    #endif
+        return true;
+    }
+
+    // sends ESP32 capabilities so javascript client knows which settings make sense
+    bool __oscSendCapabilities__ (httpServer_t::webSocket_t *webSck, bool clientIsBigEndian) {
+        uint32_t readers = OSC_READER_TIMED | OSC_READER_TRANSITIONS | OSC_READER_LOGIC | OSC_READER_PEAK_DETECT;
+        uint32_t sampleFormats = 1;
+        uint32_t deepRecordMaxSamples = 0;
+        uint32_t fftSize = 0;
+        #ifdef USE_I2S_INTERFACE
+            readers |= OSC_READER_I2S | OSC_READER_DEEP_RECORD | OSC_READER_SPECTRUM;
+            #if CONFIG_IDF_TARGET_ESP32
+                readers |= OSC_READER_I2S_2_SIGNALS;
+            #endif
+            sampleFormats |= 2 | 4;
+            deepRecordMaxSamples = OSCILLOSCOPE_DEEP_RECORD_MAX_SAMPLES;
+            fftSize = OSCILLOSCOPE_FFT_SIZE;
+        #endif
+        const uint32_t capabilities [][2] = {
+            { OSC_CAP_PROTOCOL_VERSION,           OSC_PROTOCOL_VERSION },
+            { OSC_CAP_READERS,                    readers },
+            { OSC_CAP_SAMPLE_FORMATS,             sampleFormats },
+            { OSC_CAP_I2S_MIN_SAMPLING_TIME,      7 }, // max ESP32 sampling rate = 150 kHz (sampling time >= 6.6 us)
+            { OSC_CAP_TIMER_MIN_SAMPLING_TIME,    OSCILLOSCOPE_TIMER_MIN_SAMPLING_TIME },
+            { OSC_CAP_PEAK_DETECT_SAMPLING_TIME,  OSCILLOSCOPE_PEAK_DETECT_SAMPLING_TIME },
+            { OSC_CAP_I2S_BUFFER_SIZE,            OSCILLOSCOPE_I2S_BUFFER_SIZE },
+            { OSC_CAP_1SIGNAL_BUFFER_SIZE,        OSCILLOSCOPE_1SIGNAL_BUFFER_SIZE },
+            { OSC_CAP_2SIGNALS_BUFFER_SIZE,       OSCILLOSCOPE_2SIGNALS_BUFFER_SIZE },
+            { OSC_CAP_LOGIC_MAX_SIGNALS,          OSCILLOSCOPE_LOGIC_MAX_SIGNALS },
+            { OSC_CAP_DEEP_RECORD_MAX_SAMPLES,    deepRecordMaxSamples },
+            { OSC_CAP_MAX_VIEWERS,                OSCILLOSCOPE_MAX_VIEWERS },
+            { OSC_CAP_TRIGGER_TYPES,              (1 << (OSC_TRIGGER_RUNT + 1)) - 1 },
+            { OSC_CAP_FFT_SIZE,                   fftSize },
+            { OSC_CAP_ADC_CALIBRATION,            (uint32_t) __oscAdcCalibrationSource__ () }
+        };
+        constexpr size_t noOfCapabilities = sizeof (capabilities) / sizeof (capabilities [0]);
+
+        uint16_t reply [sizeof (oscFrameHeader) / 2 + 3 * noOfCapabilities] = { (uint16_t) OSC_FRAME_CAPABILITIES, 0, (uint16_t) -1, 0 };
+        for (size_t i = 0; i < noOfCapabilities; i ++) {
+            uint16_t *w = reply + sizeof (oscFrameHeader) / 2 + 3 * i;
+            w [0] = capabilities [i][0];
+            w [1] = capabilities [i][1] >> 16;
+            w [2] = capabilities [i][1] & 0xFFFF;
+        }
+        if (clientIsBigEndian)
+            for (uint16_t& w : reply) w = htons (w);
+        return webSck->sendBlock ((byte *) reply, sizeof (reply));
+    }
+
+    // reads the parameters of OSC_CMD_START into shared memory, returns NULL if succeeded or error message for javascript client, the values are checked later
+    const char *__oscParseStartParameters__ (oscSharedMemory *sharedMemory, const uint8_t *parameters, uint16_t length) {
+        // forget previous settings, if any
+        sharedMemory->readType [0] = sharedMemory->samplingTimeUnit [0] = sharedMemory->screenWidthTimeUnit [0] = 0;
+        sharedMemory->gpio1 = sharedMemory->gpio2 = (gpio_num_t) 255; // invalid GPIO
+        sharedMemory->logicSignals = 0;
+        sharedMemory->samplingTime = 0;
+        sharedMemory->screenWidthTime = 0;
+        sharedMemory->positiveTrigger = sharedMemory->negativeTrigger = false;
+        sharedMemory->preTriggerPercent = 0;
+        sharedMemory->triggerMode = OSC_TRIGGER_NORMAL;
+        sharedMemory->holdoff = 0;
+        sharedMemory->triggerType = OSC_TRIGGER_EDGE;
+        sharedMemory->triggerSource = OSC_TRIGGER_SOURCE_CH1;
+        sharedMemory->triggerGpio = 255;
+        sharedMemory->hysteresis = 0;
+        sharedMemory->pulseWidth = 0;
+        sharedMemory->sampleBits = 16; // not packed
+        sharedMemory->peakDetect = false;
+        sharedMemory->recordLength = 0;
+        sharedMemory->spectrum = false;
+        sharedMemory->spectrumWindow = OSC_WINDOW_HANN;
+        sharedMemory->spectrumAverage = 1;
+        sharedMemory->measurements = false;
+        sharedMemory->acquisition = OSC_ACQUISITION_NORMAL;
+        sharedMemory->acquisitionFrames = 1;
+        sharedMemory->analogUnit = OSC_ANALOG_RAW;
+
+        for (uint16_t i = 0; i + 2 <= length; i += 2 + parameters [i + 1]) {
+            uint8_t type = parameters [i];
+            uint8_t valueLength = parameters [i + 1];
+            const uint8_t *value = parameters + i + 2;
+            int16_t value16 = 0; if (valueLength == 2) memcpy (&value16, value, 2);
+            uint32_t value32 = 0; if (valueLength == 4) memcpy (&value32, value, 4);
+            if ((type & 0xC0) == OSC_PARAM_16 && valueLength != 2) return "[oscilloscope] oscilloscope protocol syntax error";
+            if ((type & 0xC0) == OSC_PARAM_32 && valueLength != 4) return "[oscilloscope] oscilloscope protocol syntax error";
+
+            switch (type) {
+                case OSC_PARAM_READ_TYPE:
+                        if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                        switch (*value) {
+                            case OSC_READ_ANALOG:   strcpy (sharedMemory->readType, "analog"); break;
+                            case OSC_READ_DIGITAL:  strcpy (sharedMemory->readType, "digital"); break;
+                            case OSC_READ_LOGIC:    strcpy (sharedMemory->readType, "logic"); break;
+                        }
+                        break;
+                case OSC_PARAM_GPIOS:
+                        if (valueLength < 1 || valueLength > OSCILLOSCOPE_LOGIC_MAX_SIGNALS) return "[oscilloscope] logic analyzer can take samples of up to 16 valid GPIOs";
+                        for (uint8_t k = 0; k < valueLength; k ++) {
+                            if (value [k] >= SOC_GPIO_PIN_COUNT) return "[oscilloscope] invalid GPIO";
+                            sharedMemory->logicGpio [k] = value [k];
+                        }
+                        sharedMemory->logicSignals = valueLength;
+                        sharedMemory->gpio1 = (gpio_num_t) value [0];
+                        if (valueLength > 1) sharedMemory->gpio2 = (gpio_num_t) value [1];
+                        break;
+                case OSC_PARAM_TIME_UNIT:
+                        if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                        strcpy (sharedMemory->samplingTimeUnit, *value == OSC_UNIT_MS ? "ms" : "us");
+                        strcpy (sharedMemory->screenWidthTimeUnit, sharedMemory->samplingTimeUnit);
+                        break;
+                case OSC_PARAM_SAMPLING_TIME:       sharedMemory->samplingTime = (int) min (value32, (uint32_t) 1000000); break; // out of range values are reported when checked
+                case OSC_PARAM_SCREEN_WIDTH:        sharedMemory->screenWidthTime = value32; break;
+                case OSC_PARAM_POSITIVE_TRIGGER:    sharedMemory->positiveTrigger = true; sharedMemory->positiveTriggerTreshold = value16; break;
+                case OSC_PARAM_NEGATIVE_TRIGGER:    sharedMemory->negativeTrigger = true; sharedMemory->negativeTriggerTreshold = value16; break;
+                case OSC_PARAM_PRE_TRIGGER:         if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->preTriggerPercent = *value; break;
+                case OSC_PARAM_SAMPLE_BITS:         if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->sampleBits = *value; break;
+                case OSC_PARAM_PEAK_DETECT:         sharedMemory->peakDetect = true; break;
+                case OSC_PARAM_RECORD_LENGTH:       sharedMemory->recordLength = value32; break;
+                case OSC_PARAM_TRIGGER_MODE:        if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->triggerMode = *value; break;
+                case OSC_PARAM_HOLDOFF:             sharedMemory->holdoff = value32; break;
+                case OSC_PARAM_TRIGGER_TYPE:        if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->triggerType = *value; break;
+                case OSC_PARAM_TRIGGER_SOURCE:      if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->triggerSource = *value; break;
+                case OSC_PARAM_TRIGGER_GPIO:        if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->triggerGpio = *value; break;
+                case OSC_PARAM_HYSTERESIS:          sharedMemory->hysteresis = value16; break;
+                case OSC_PARAM_PULSE_WIDTH:         sharedMemory->pulseWidth = value32; break;
+                case OSC_PARAM_SPECTRUM_WINDOW:     if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->spectrum = true; sharedMemory->spectrumWindow = *value; break;
+                case OSC_PARAM_SPECTRUM_AVERAGE:    if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->spectrumAverage = *value; break;
+                case OSC_PARAM_MEASUREMENTS:        sharedMemory->measurements = true; break;
+                case OSC_PARAM_ACQUISITION:         if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->acquisition = *value; break;
+                case OSC_PARAM_ACQUISITION_FRAMES:  if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->acquisitionFrames = *value; break;
+                case OSC_PARAM_ANALOG_UNIT:         if (valueLength != 1) return "[oscilloscope] oscilloscope protocol syntax error";
+                                                    sharedMemory->analogUnit = *value; break;
+                default:                            break; // skip unknown parameters
+            }
+        }
+        return NULL;
+    }
+
+    // handles control message that arrives while oscilloscope is running, returns the opcode oscSender can't handle by itself (OSC_CMD_STOP, OSC_CMD_RECONFIGURE) or 0
+    uint8_t __oscControl__ (httpServer_t::webSocket_t *webSck, bool clientIsBigEndian, oscControlMessage *msg) {
+        if (!__oscRecvControl__ (webSck, clientIsBigEndian, msg)) return OSC_CMD_STOP; // this also covers errors, ...
+        switch (msg->header.opcode) {
+            case OSC_CMD_STOP:
+            case OSC_CMD_RECONFIGURE:       return msg->header.opcode;
+            case OSC_CMD_GET_CAPABILITIES:  return __oscSendCapabilities__ (webSck, clientIsBigEndian) ? 0 : OSC_CMD_STOP;
+            default:                        webSck->sendString ("[oscilloscope] unknown command"); // ignore it
+                                            return 0;
+        }
+    }
+
+    // acknowledges the settings with the values oscReader is actually using
+    bool __oscSendSettings__ (httpServer_t::webSocket_t *webSck, bool clientIsBigEndian, oscSharedMemory *sharedMemory) {
+        struct {
+            oscFrameHeader header;
+            oscSettingsAck settings;
+        } reply = { { (int16_t) OSC_FRAME_SETTINGS, 0, -1, 0 },
+                    { (uint16_t) (strcmp (sharedMemory->samplingTimeUnit, "ms") ? OSC_UNIT_US : OSC_UNIT_MS),
+                      { (uint16_t) (sharedMemory->correctedSamplingTime >> 16), (uint16_t) (sharedMemory->correctedSamplingTime & 0xFFFF) },
+                      { (uint16_t) (sharedMemory->correctedScreenWidthTime >> 16), (uint16_t) (sharedMemory->correctedScreenWidthTime & 0xFFFF) },
+                      (int16_t) (sharedMemory->positiveTrigger ? sharedMemory->positiveTriggerTreshold : -1),
+                      (int16_t) (sharedMemory->negativeTrigger ? sharedMemory->negativeTriggerTreshold : -1),
+                      (int16_t) sharedMemory->preTriggerPercent,
+                      (int16_t) sharedMemory->triggerMode } };
+        if (clientIsBigEndian) {
+            uint16_t *w = (uint16_t *) &reply;
+            for (size_t i = 0; i < sizeof (reply) / 2; i ++) w [i] = htons (w [i]);
+        }
+        return webSck->sendBlock ((byte *) &reply, sizeof (reply));
+    }
 
 
     // oscSender oscSender oscSender oscSender oscSender oscSender oscSender oscSender oscSender oscSender oscSender oscSender oscSender oscSender oscSender 
+
+    // Creates eventfd through which oscReader wakes up oscSender. This way oscSender can wait for both, the frames from oscReader and the data from javascript client, in a single select (). Returns -1 if eventfd is not available.
+    int __oscCreateFrameReadyEvent__ () {
+        esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT ();
+        config.max_fds = OSCILLOSCOPE_MAX_EVENTFDS;
+        esp_err_t err = esp_vfs_eventfd_register (&config);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) // ESP_ERR_INVALID_STATE means it is already registered (by another oscilloscope) which is OK
+            return -1;
+        return eventfd (0, 0);
+    }
     
-    void oscSender (void *sharedMemory) {
-      // unsigned char gpio1 =                   (unsigned char) ((oscSharedMemory *) sharedMemory)->gpio1; // easier to check validity with unsigned char then with integer 
-      unsigned char gpio2 =                   (unsigned char) ((oscSharedMemory *) sharedMemory)->gpio2; // easier to check validity with unsigned char then with integer
-      unsigned char noOfSignals = 1; if (gpio2 <= 39) noOfSignals = 2;  // monitor 1 or 2 signals
-      oscSamples *sendBuffer =                &((oscSharedMemory *) sharedMemory)->sendBuffer;
-      sendBuffer->samplesAreReady = false;     
-      bool clientIsBigEndian =                ((oscSharedMemory *) sharedMemory)->clientIsBigEndian;
-      httpServer_t::webSocket_t *webSck =     ((oscSharedMemory *) sharedMemory)->webSck; 
+    // the number of bytes the samples of the frame packed by oscReader take, with odd number of 12 bit samples the last one takes 2 bytes
+    inline size_t __oscPackedSize__ (const oscSamples *frame) {
+        if (frame->header.frameType == OSC_FRAME_1_SIGNAL_PACKED_8_BITS) return frame->sampleCount;
+        return frame->sampleCount / 2 * 3 + frame->sampleCount % 2 * 2; // OSC_FRAME_1_SIGNAL_PACKED_12_BITS
+    }
+
+    struct oscViewer {                          // javascript client that watches the samples of its own or shared oscReader
+      httpServer_t::webSocket_t *webSck;      // open webSocket for communication with javascript client
+      bool clientIsBigEndian;                 // true if javascript client is big endian machine
+      oscFrameCursor cursor;                  // the next frame to be sent from oscReader's frame queue
+      oscSamples frame;                       // copy of the frame being sent, it gets packed and swapped only for this javascript client
+      oscControlMessage control;              // the last control message oscSender has received from javascript client
+    };
+
+    // sends the frames to javascript client until it sends OSC_CMD_STOP or OSC_CMD_RECONFIGURE (in viewer->control), returns the opcode, OSC_CMD_STOP also means an error
+    uint8_t oscSender (oscFrameQueue *frameQueue, oscViewer *viewer) {
+      bool clientIsBigEndian =                viewer->clientIsBigEndian;
+      httpServer_t::webSocket_t *webSck =     viewer->webSck; 
+      int sck =                               webSck->getSocket ();
+      int frameReadyEvent =                   viewer->cursor.frameReadyEvent;
+      oscSamples *sendSamples =               &viewer->frame;
     
-      ///unsigned long lastMillis = millis ();
       while (true) { 
-        delay (1);
         // send samples to javascript client if they are ready
-        if (sendBuffer->samplesAreReady && sendBuffer->sampleCount) {
+        while (frameQueue->copyNext (&viewer->cursor, sendSamples)) { // send all the frames that are waiting in the queue and haven't been sent to this viewer yet
+          if (!sendSamples->sampleCount) continue; // nothing to send ('sample at a time' mode may pass an empty frame at the end of the screen)
 
-          // copy buffer with samples within critical section
-          oscSamples sendSamples = *sendBuffer;
-          sendBuffer->samplesAreReady = false; // oscRader will set this flag when buffer is the next time ready for sending
           // swap bytes if javascript client is big endian
           int sendBytes; // calculate the number of bytes in the buffer
 
-          // find out the type of buffer used
-          if (noOfSignals == 1) 
-              if (sendSamples.samplesI2sSignal [0].signal1 < -3) 
-                  sendBytes = sendSamples.sampleCount * sizeof (oscI2sSample);  // 1 I2S signal (I2S signal does not starts with -1, -2 or -3 dummy value)
-              else
-                  sendBytes = sendSamples.sampleCount * sizeof (osc1SignalSample); // 1 signal with deltaTime
-          else                  
-              sendBytes = sendSamples.sampleCount * sizeof (osc2SignalsSample); // 2 signals with deltaTime
+          // find out the type of buffer used from the frame header
+          switch (sendSamples->header.frameType) {
+              case OSC_FRAME_1_SIGNAL_EQUALLY_SPACED:   sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (oscI2sSample); break;      // 1 I2S signal
+              case OSC_FRAME_1_SIGNAL:                  sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (osc1SignalSample); break;  // 1 signal with deltaTime
+              case OSC_FRAME_1_SIGNAL_PACKED_12_BITS:
+              case OSC_FRAME_1_SIGNAL_PACKED_8_BITS:    sendBytes = sizeof (oscFrameHeader) + __oscPackedSize__ (sendSamples); break;                       // 1 I2S signal, packed by oscReader
+              case OSC_FRAME_1_SIGNAL_MIN_MAX:          sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (osc1SignalMinMaxSample); break;  // 1 signal (min, max) with deltaTime
+              case OSC_FRAME_2_SIGNALS_MIN_MAX:         sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (osc2SignalsMinMaxSample); break; // 2 signals (min, max) with deltaTime
+              case OSC_FRAME_DEEP_RECORD:               sendBytes = sizeof (oscFrameHeader) + offsetof (oscDeepRecordFragment, samples) + sendSamples->sampleCount * sizeof (oscI2sSample); break; // 1 fragment of deep record
+              case OSC_FRAME_TRANSITIONS:               sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (oscTransitionSample); break; // 1 or 2 digital signals, only transitions
+              case OSC_FRAME_8_LOGIC_SIGNALS:           sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (osc8LogicSignalsSample); break;  // up to 8 logic signals
+              case OSC_FRAME_16_LOGIC_SIGNALS:          sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (osc16LogicSignalsSample); break; // up to 16 logic signals
+              case OSC_FRAME_SPECTRUM:                  sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (int16_t); break;           // frequency bins in 1/100 dB
+              case OSC_FRAME_SPECTRUM_8_BITS:           sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (uint8_t); break;           // frequency bins in 0.5 dB steps
+              case OSC_FRAME_ENVELOPE:                  sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (oscEnvelopeSample); break; // 1 I2S signal, (min, max) over more screens
+              default:                                  sendBytes = sizeof (oscFrameHeader) + sendSamples->sampleCount * sizeof (osc2SignalsSample); break; // 2 signals with deltaTime
+          }
+          bool measured = sendSamples->header.flags & OSC_FRAME_MEASURED; // check before the header gets swapped
           int sendWords = sendBytes >> 1;                                 // number of 16 bit words = number of bytes / 2
+          if (sendSamples->header.frameType == OSC_FRAME_8_LOGIC_SIGNALS || sendSamples->header.frameType == OSC_FRAME_1_SIGNAL_PACKED_12_BITS || sendSamples->header.frameType == OSC_FRAME_1_SIGNAL_PACKED_8_BITS || sendSamples->header.frameType == OSC_FRAME_SPECTRUM_8_BITS)
+            sendWords = sizeof (oscFrameHeader) >> 1;                     // byte streams don't need swapping, only the header does
 
           if (clientIsBigEndian) {
-            uint16_t *w = (uint16_t *) &sendSamples;
+            uint16_t *w = (uint16_t *) sendSamples;
             for (size_t i = 0; i < sendWords; i ++) w [i] = htons (w [i]);
           }
-          if (!webSck->sendBlock ((byte *) &sendSamples,  sendBytes)) return;
+          if (!webSck->sendBlock ((byte *) sendSamples,  sendBytes)) return OSC_CMD_STOP;
+
+          // the measurements of the screen follow in their own small frame, so javascript clients that only need the numbers don't have to look into the samples
+          if (measured) {
+            struct {
+              oscFrameHeader header;
+              oscMeasurementRecord measurements;
+            } record = { { (int16_t) OSC_FRAME_MEASUREMENTS, 0, -1, 0 }, sendSamples->measurements };
+            if (clientIsBigEndian) {
+              uint16_t *w = (uint16_t *) &record;
+              for (size_t i = 0; i < sizeof (record) / 2; i ++) w [i] = htons (w [i]);
+            }
+            if (!webSck->sendBlock ((byte *) &record, sizeof (record))) return OSC_CMD_STOP;
+          }
         }
     
-        // read (text) stop command form javscrip client if it arrives - according to oscilloscope protocol the string could only be 'stop' - so there is no need checking it
-        if (webSck->peek () != 0) return; // this also covers errors, ...
-        // if (webSck->getSocket () == -1) return; // if the socket has been closed by oscReader
+        // sleep until oscReader pushes the next frame or javascript client sends something (without eventfd only the socket can wake oscSender up so it has to check the frame queue every 1 ms)
+        fd_set readfds;
+        FD_ZERO (&readfds);
+        FD_SET (sck, &readfds);
+        if (frameReadyEvent >= 0) FD_SET (frameReadyEvent, &readfds);
+        struct timeval timeout = { 0, frameReadyEvent >= 0 ? 500000 : 1000 }; // timeout is only a safety net in case the socket gets closed or the data gets buffered above it
+        if (select (max (sck, frameReadyEvent) + 1, &readfds, NULL, NULL, &timeout) < 0) return OSC_CMD_STOP; // socket error
+        if (frameReadyEvent >= 0 && FD_ISSET (frameReadyEvent, &readfds)) {
+            uint64_t frames;
+            read (frameReadyEvent, &frames, sizeof (frames)); // reset the eventfd counter, all the frames waiting in the queue will be sent in the next pass
+        }
+
+        // read control message from javascript client if it arrives - OSC_CMD_STOP ends the session, OSC_CMD_RECONFIGURE is handled by the caller
+        int available = webSck->peek ();
+        if (available < 0) return OSC_CMD_STOP; // error
+        if (available > 0) {
+            uint8_t opcode = __oscControl__ (webSck, clientIsBigEndian, &viewer->control);
+            if (opcode) return opcode; // OSC_CMD_STOP, OSC_CMD_RECONFIGURE or the message doesn't follow oscilloscope protocol
+        }
       }
     }
 
-    // main oscilloscope function - it reads request from javascript client then starts two threads: oscilloscope reader (that reads samples ans packs them into buffer) and oscilloscope sender (that sends buffer to javascript client)
+    // shared acquisitions shared acquisitions shared acquisitions shared acquisitions shared acquisitions shared acquisitions shared acquisitions
+
+    // Javascript clients that send identical start parameters (javascript client always builds them the same way from the same settings) share one oscReader. The client
+    // that has started oscReader also stops it, but only when all the other viewers have left, so the same ADC channel or I2S interface is not sampled twice.
+    oscSharedMemory *__oscSharedAcquisitions__ [OSCILLOSCOPE_READER_WORKERS] = {}; // running oscReaders other viewers can attach to, protected by __oscViewersLock__
+
+    // attaches the viewer to the running oscReader with the same start parameters, returns its shared memory or NULL if there is no such oscReader (or no place for another viewer)
+    oscSharedMemory *__oscAttachViewer__ (const uint8_t *command, uint16_t commandLength, oscViewer *viewer) {
+        oscSharedMemory *attachedTo = NULL;
+        xSemaphoreTake (__oscViewersLock__, portMAX_DELAY);
+            for (oscSharedMemory *sharedMemory : __oscSharedAcquisitions__)
+                if (!attachedTo && sharedMemory && sharedMemory->oscReaderState == STARTED && sharedMemory->commandLength == commandLength && !memcmp (sharedMemory->command, command, commandLength))
+                    for (oscFrameCursor *&c : sharedMemory->frameQueue.cursor)
+                        if (!c) {
+                            viewer->cursor.next = sharedMemory->frameQueue.head.load (std::memory_order_relaxed); // start with the next frame
+                            c = &viewer->cursor;
+                            sharedMemory->viewers ++;
+                            attachedTo = sharedMemory;
+                            break;
+                        }
+        xSemaphoreGive (__oscViewersLock__);
+        return attachedTo;
+    }
 
-    void runOscilloscope (httpServer_t::webSocket_t *webSck) {
-      oscSharedMemory *sharedMemory; 
-      // get some memory that will be shared among all oscilloscope threads and initialize it with zerros
-      sharedMemory = (oscSharedMemory *) malloc (sizeof (oscSharedMemory));
-      if (!sharedMemory) {
-            // cout << ( dmesgQueue << "[oscilloscope] out of memory" );
-            webSck->sendString ("[oscilloscope] out of memory"); // send error also to javascript client
-            return;
-      }
-      memset (sharedMemory, 0, sizeof (oscSharedMemory));
+    // detaches the viewer from oscReader's frame queue, the viewer can be freed after this
+    void __oscDetachViewer__ (oscSharedMemory *sharedMemory, oscViewer *viewer) {
+        xSemaphoreTake (__oscViewersLock__, portMAX_DELAY);
+            for (oscFrameCursor *&c : sharedMemory->frameQueue.cursor)
+                if (c == &viewer->cursor) {
+                    c = NULL;
+                    sharedMemory->viewers --;
+                }
+        xSemaphoreGive (__oscViewersLock__);
+    }
 
-      sharedMemory->webSck = webSck;                                 // put webSocket rference into shared memory
-      sharedMemory->readBuffer.samplesAreReady = true;               // this value will be copied into sendBuffer later where this flag will be checked
-    
-      // oscilloscope protocol starts with binary endian identification from the client
-      uint16_t endianIdentification = 0;
-      if (webSck->recvBlock ((byte *) &endianIdentification, sizeof (endianIdentification)) == sizeof (endianIdentification))
-        sharedMemory->clientIsBigEndian = (endianIdentification == 0xBBAA); // cient has sent 0xAABB
-      if (!(endianIdentification == 0xAABB || endianIdentification == 0xBBAA)) {
-        // cout << ( dmesgQueue << "[oscilloscope] communication does not follow oscilloscope protocol - expected endian identification" );
-        webSck->sendString ("[oscilloscope] communication does not follow oscilloscope protocol - expected endian identification"); // send error also to javascript client
-        free (sharedMemory);
-        return;
-      }
-    
-      // oscilloscope protocol continues with (text) start command in the following forms:
-      // start digital sampling on GPIO 36 every 250 ms screen width = 10000 ms
-      // start analog sampling on GPIO 22, 23 every 100 ms screen width = 400 ms set positive slope trigger to 512 set negative slope trigger to 0
-      Cstring<300> s;
-      if (!webSck->recvString ((char *) s, s.max_size ())) {
-            // cout << ( dmesgQueue << "[oscilloscope] communication does not follow oscilloscope protocol - expected start oscilloscope parameters" );
-            webSck->sendString ("[oscilloscope] communication does not follow oscilloscope protocol - expected start oscilloscope parameters"); // send error also to javascript client
-            free (sharedMemory);
-            return;
-      }
-      __oscilloscope_h_debug__ ("runOscilloscope: command =  " + String ((char *) s));
+    // lets other viewers attach to oscReader (deep record is never shared since it is taken only once)
+    void __oscShareAcquisition__ (oscSharedMemory *sharedMemory) {
+        xSemaphoreTake (__oscViewersLock__, portMAX_DELAY);
+            for (oscSharedMemory *&a : __oscSharedAcquisitions__)
+                if (!a) { a = sharedMemory; break; }
+        xSemaphoreGive (__oscViewersLock__);
+    }
+
+    // stops sharing oscReader if there are no more than remainingViewers viewers attached to it, returns false if there are more
+    bool __oscUnshareAcquisition__ (oscSharedMemory *sharedMemory, unsigned char remainingViewers = 0) {
+        bool unshared = false;
+        xSemaphoreTake (__oscViewersLock__, portMAX_DELAY);
+            if (sharedMemory->viewers <= remainingViewers) {
+                for (oscSharedMemory *&a : __oscSharedAcquisitions__)
+                    if (a == sharedMemory) a = NULL;
+                unshared = true;
+            }
+        xSemaphoreGive (__oscViewersLock__);
+        return unshared;
+    }
+
+
+    // oscReader workers oscReader workers oscReader workers oscReader workers oscReader workers oscReader workers oscReader workers oscReader workers 
+
+    // oscReader tasks are created only once and then wait for jobs (shared memory of each new oscilloscope) in a queue, so their stacks are not allocated and freed with each oscilloscope
+    QueueHandle_t __oscReaderJobs__ = NULL;             // oscSharedMemory * of the oscilloscopes that are about to start
+    SemaphoreHandle_t __oscIdleReaderWorkers__ = NULL;  // counts the oscReader workers that are waiting for a job
+
+    void __oscReaderWorker__ (void *parameters) {
+        while (true) {
+            oscSharedMemory *sharedMemory;
+            if (xQueueReceive (__oscReaderJobs__, &sharedMemory, portMAX_DELAY) == pdTRUE) {
+                sharedMemory->oscReader (sharedMemory); // returns after it acknowledges STOP signal
+                xSemaphoreGive (__oscIdleReaderWorkers__);
+            }
+        }
+    }
+
+    // create oscReader workers, this can be called from setup () but runOscilloscope will call it anyway if it hasn't been called yet
+    bool startOscReaderWorkers () {
+        static bool workersStarted = [] () -> bool { // static initialization runs only once even if more oscilloscopes start at the same time
+            __oscReaderJobs__ = xQueueCreate (OSCILLOSCOPE_READER_WORKERS, sizeof (oscSharedMemory *));
+            __oscIdleReaderWorkers__ = xSemaphoreCreateCounting (OSCILLOSCOPE_READER_WORKERS, 0);
+            __oscViewersLock__ = xSemaphoreCreateMutex ();
+            if (!__oscReaderJobs__ || !__oscIdleReaderWorkers__ || !__oscViewersLock__) {
+                cout << ( dmesgQueue << "[oscilloscope] out of memory" );
+                return false;
+            }
+            for (int i = 0; i < OSCILLOSCOPE_READER_WORKERS; i ++)
+                #if OSCILLOSCOPE_ISOLATION_PROFILE == OSC_ISOLATION_NONE
+                    if (pdPASS == xTaskCreate (__oscReaderWorker__, "oscReader", 4 * 1024, NULL, OSCILLOSCOPE_READER_PRIORITY, NULL))
+                #elif portNUM_PROCESSORS > 1
+                    if (pdPASS == xTaskCreatePinnedToCore (__oscReaderWorker__, "oscReader", 4 * 1024, NULL, OSCILLOSCOPE_ISOLATED_READER_PRIORITY, NULL, APP_CPU_NUM)) // keep oscReader away from WiFi and lwIP on PRO_CPU
+                #else
+                    if (pdPASS == xTaskCreate (__oscReaderWorker__, "oscReader", 4 * 1024, NULL, OSCILLOSCOPE_ISOLATED_READER_PRIORITY, NULL)) // single core, only the priority can be elevated
+                #endif
+                    xSemaphoreGive (__oscIdleReaderWorkers__);
+                else
+                    cout << ( dmesgQueue << "[oscilloscope] could not start oscReader" );
+            return uxSemaphoreGetCount (__oscIdleReaderWorkers__) > 0;
+        } ();
+        return workersStarted;
+    }
+
+    // passes the job to idle oscReader worker (START signal) and waits until oscReader STARTED, the viewer is the first one watching it, returns false (and reports the error to javascript client) if all oscReader workers are busy or oscReader has failed
+    bool __oscStartReader__ (oscSharedMemory *sharedMemory, oscViewer *viewer) {
+        if (xSemaphoreTake (__oscIdleReaderWorkers__, pdMS_TO_TICKS (100)) != pdTRUE) { // wait a little in case the previous oscilloscope is just finishing
+            // cout << ( dmesgQueue << "[oscilloscope] all oscReaders are busy" );
+            viewer->webSck->sendString ("[oscilloscope] all oscReaders are busy, try again later"); // send error also to javascript client
+            return false;
+        }
+
+        // oscReader hasn't started yet (or it has stopped to change the settings) so there is no need to lock
+        viewer->cursor.next = sharedMemory->frameQueue.head.load (std::memory_order_relaxed); // skip the frames taken with the previous settings, if any
+        sharedMemory->frameQueue.cursor [0] = &viewer->cursor;
+        sharedMemory->viewers = 1;
+
+        sharedMemory->controllerTask = xTaskGetCurrentTaskHandle ();
+        while (ulTaskNotifyTake (pdTRUE, 0)); // clear any notification that may be left from before
+        sharedMemory->oscReaderState = START; 
+        xQueueSend (__oscReaderJobs__, &sharedMemory, portMAX_DELAY); // there is always place in the queue for an idle worker
+        while (sharedMemory->oscReaderState == START) // STARTED, or STOPPED if oscReader has failed to start (oscReaders acknowledge START only after everything that can fail)
+            ulTaskNotifyTake (pdFALSE, pdMS_TO_TICKS (100));
+        if (sharedMemory->oscReaderState != STARTED) return false; // oscReader has already reported the error to javascript client, don't let anybody attach to it
+
+        // let javascript clients with the same settings attach to this oscReader
+        if (!sharedMemory->recordLength)
+            __oscShareAcquisition__ (sharedMemory);
+        return true;
+    }
+
+    // stops oscReader - we can not simply vTaskDelete (oscReaderHandle) since this could happen in the middle of analogRead which would leave its internal semaphore locked
+    void __oscStopReader__ (oscSharedMemory *sharedMemory, bool atFrameBoundary = false) {
+        // oscReaders check STOP signal between the samples, so let oscReader first push the frame it is filling, but don't wait for the trigger condition for too long
+        if (atFrameBoundary) {
+            unsigned int head = sharedMemory->frameQueue.head.load (std::memory_order_acquire);
+            TickType_t waitingSince = xTaskGetTickCount ();
+            while (sharedMemory->oscReaderState == STARTED && sharedMemory->frameQueue.head.load (std::memory_order_acquire) == head && xTaskGetTickCount () - waitingSince < pdMS_TO_TICKS (OSCILLOSCOPE_RECONFIGURE_TIMEOUT))
+                vTaskDelay (1);
+        }
+
+        // send oscReader STOP signal, oscReaders check it between the samples and the frames
+        sharedMemory->oscReaderState = STOP; 
+
+        // wait until oscReader STOPPED or error, the notification may also come from oscReader this javascript client has left to other viewers so check the state as well
+        while (sharedMemory->oscReaderState != STOPPED)
+            ulTaskNotifyTake (pdFALSE, pdMS_TO_TICKS (100));
+    }
+
+    // reads and checks the parameters of OSC_CMD_START or OSC_CMD_RECONFIGURE, calculates derived values and chooses the oscReader, returns false (and reports the error to javascript client) if the parameters are not valid
+    bool __oscConfigure__ (oscSharedMemory *sharedMemory, const uint8_t *parameters, uint16_t length) {
+      httpServer_t::webSocket_t *webSck = sharedMemory->webSck;
 
       // try to parse what we have got from client
-      char posNeg1 [9] = "";
-      char posNeg2 [9] = "";
-      int treshold1;
-      int treshold2;
-      char *cmdPart1 = (char *) s;
-      char *cmdPart2 = strstr (cmdPart1, " every"); 
-      char *cmdPart3 = NULL;
-      if (cmdPart2) {
-        *(cmdPart2++) = 0;
-        cmdPart3 = strstr (cmdPart2, " set"); 
-        if (cmdPart3) 
-          *(cmdPart3++) = 0;
+      const char *parseError = __oscParseStartParameters__ (sharedMemory, parameters, length);
+      if (parseError) {
+        // cout << ( dmesgQueue << parseError );
+        webSck->sendString (parseError); // send error also to javascript client
+        return false;
       }
-      // parse 1st part
-      sharedMemory->gpio1 = sharedMemory->gpio2 = (gpio_num_t) 255; // invalid GPIO
-      int gpio1 = 255;
-      int gpio2 = 255;
-      if (sscanf (cmdPart1, "start %7s sampling on GPIO %2i, %2i", sharedMemory->readType, &gpio1, &gpio2) < 2) {
-        // cout << ( dmesgQueue << "[oscilloscope] oscilloscope protocol syntax error" );
-        webSck->sendString ("[oscilloscope] oscilloscope protocol syntax error"); // send error also to javascript client
-        free (sharedMemory);
-        return;
+
+      // OSC_PARAM_GPIOS is optional in the protocol, but each read type needs at least gpio1 (it stays 255 if the parameter is missing)
+      if (sharedMemory->gpio1 < 0 || sharedMemory->gpio1 >= SOC_GPIO_PIN_COUNT || sharedMemory->gpio2 < 0) {
+        // cout << ( dmesgQueue << "[oscilloscope] invalid or missing GPIO" );
+        webSck->sendString ("[oscilloscope] invalid or missing GPIO"); // send error also to javascript client
+        return false;
       }
-        sharedMemory->gpio1 = (gpio_num_t) gpio1;
-        sharedMemory->gpio2 = (gpio_num_t) gpio2;
 
       // use adc1_get_raw instead of analogRead
       if (!strcmp (sharedMemory->readType, "analog")) {
@@ -1164,8 +3509,7 @@
                   // ADC2 (GPIOs 4, 0, 2, 15, 13, 12, 14, 27, 25, 26), the reading blocks when used together with WiFi?
                   // other GPIOs do not have ADC
                   default:  webSck->sendString ((char *) (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio1) + ".")); // send the error also to javascript client
-                            free (sharedMemory);  
-                            return;
+                            return false;
               }
               switch ((uint8_t) sharedMemory->gpio2) {
                   // ADC1
@@ -1182,8 +3526,7 @@
                   // ADC2 (GPIOs 4, 0, 2, 15, 13, 12, 14, 27, 25, 26), the reading blocks when used together with WiFi?
                   // other GPIOs do not have ADC
                   default:  webSck->sendString ((char *) (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio2) + ".")); // send the error also to javascript client
-                            free (sharedMemory);  
-                            return;
+                            return false;
               }
 
 
@@ -1207,8 +3550,7 @@
                   // ADC2 (GPIOs 11, 12, 13, 14, 15, 16, 17, 18, 19, 20), the reading blocks when used together with WiFi?
                   // other GPIOs do not have ADC
                   default:  webSck->sendString (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio1) + "."); // send error also to javascript client
-                            free (sharedMemory);
-                            return;  
+                            return false;
               }
               switch ((uint8_t) sharedMemory->gpio2) {
                   // ADC1
@@ -1227,8 +3569,7 @@
                   // ADC2 (GPIOs 11, 12, 13, 14, 15, 16, 17, 18, 19, 20), the reading blocks when used together with WiFi?
                   // other GPIOs do not have ADC
                   default:  webSck->sendString (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio2) + "."); // send error also to javascript client
-                            free (sharedMemory);
-                            return;
+                            return false;
               }
 
           // #elif CONFIG_IDF_TARGET_ESP32C2
@@ -1252,8 +3593,7 @@
                   // ADC2 (GPIOs 11, 12, 13, 14, 15, 16, 17, 18, 19, 20), the reading blocks when used together with WiFi?
                   // other GPIOs do not have ADC
                   default:  webSck->sendString (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio1) + "."); // send error also to javascript client
-                            free (sharedMemory);
-                            return;
+                            return false;
               }
               switch ((uint8_t) sharedMemory->gpio2) {
                   // ADC1
@@ -1272,8 +3612,7 @@
                   // ADC2 (GPIOs 11, 12, 13, 14, 15, 16, 17, 18, 19, 20), the reading blocks when used together with WiFi?
                   // other GPIOs do not have ADC
                   default:  webSck->sendString (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio2) + "."); // send error also to javascript client
-                            free (sharedMemory);
-                            return;
+                            return false;
               }
 
           #elif CONFIG_IDF_TARGET_ESP32C3
@@ -1290,8 +3629,7 @@
                   // ADC2 (GPIO 5), the reading blocks when used together with WiFi?
                   // other GPIOs do not have ADC
                   default:  webSck->sendString (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio1) + "."); // send error also to javascript client
-                            free (sharedMemory);
-                            return;
+                            return false;
               }
               switch ((uint8_t) sharedMemory->gpio2) {
                   // ADC1
@@ -1305,8 +3643,7 @@
                   // ADC2 (GPIO 5), the reading blocks when used together with WiFi?
                   // other GPIOs do not have ADC
                   default:  webSck->sendString (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio2) + "."); // send error also to javascript client
-                            free (sharedMemory);
-                            return;
+                            return false;
               }
 
           #elif CONFIG_IDF_TARGET_ESP32C6
@@ -1322,8 +3659,7 @@
                   case  6: sharedMemory->adcchannel1 = ADC1_CHANNEL_6; break;
                   // ESP32 C5 does not have ADC2
                   default:  webSck->sendString (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio1) + "."); // send error also to javascript client
-                            free (sharedMemory);
-                            return;
+                            return false;
               }
               switch ((uint8_t) sharedMemory->gpio2) {
                   // ADC1
@@ -1338,8 +3674,7 @@
                   case 255: break;
                   // ESP32 C5 does not have ADC2
                   default:  webSck->sendString (Cstring<64> ("[oscilloscope] can't analogRead GPIO ") + Cstring<64> (sharedMemory->gpio2) + "."); // send error also to javascript client
-                            free (sharedMemory);
-                            return;
+                            return false;
               }
 
           // #elif CONFIG_IDF_TARGET_ESP32H2
@@ -1348,87 +3683,84 @@
               #error "Your board (CONFIG_IDF_TARGET) is not supported by oscilloscope.h"
           #endif
 
+          // set the attenuation explicitly, since ADC calibration tables are built for OSCILLOSCOPE_ADC_ATTENUATION
+          adc1_config_channel_atten (sharedMemory->adcchannel1, OSCILLOSCOPE_ADC_ATTENUATION);
+          if (sharedMemory->gpio2 != 255) adc1_config_channel_atten (sharedMemory->adcchannel2, OSCILLOSCOPE_ADC_ATTENUATION);
       }
       
-      // parse 2nd part
-      if (!cmdPart2) {
-        // cout << ( dmesgQueue << "[oscilloscope] oscilloscope protocol syntax error" );
-        webSck->sendString ("[oscilloscope] oscilloscope protocol syntax error"); // send error also to javascript client
-        free (sharedMemory);    
-        return;
-      }
-      if (sscanf (cmdPart2, "every %i %2s screen width = %lu %2s", &sharedMemory->samplingTime, sharedMemory->samplingTimeUnit, &sharedMemory->screenWidthTime, sharedMemory->screenWidthTimeUnit) != 4) {
-        // cout << ( dmesgQueue << "[oscilloscope] oscilloscope protocol syntax error" );
-        webSck->sendString ("[oscilloscope] oscilloscope protocol syntax error"); // send error also to javascript client
-        free (sharedMemory);
-        return;
-      }
-          
-      // parse 3rd part
-      if (cmdPart3) { 
-        switch (sscanf (cmdPart3, "set %8s slope trigger to %i set %8s slope trigger to %i", posNeg1, &treshold1, posNeg2, &treshold2)) {
-          case 0: // no trigger
-                  break;
-          case 4: // two triggers
-                  if (!strcmp (posNeg2, "positive")) {
-                    sharedMemory->positiveTrigger = true;
-                    sharedMemory->positiveTriggerTreshold = treshold2;
-                  }
-                  if (!strcmp (posNeg2, "negative")) {
-                    sharedMemory->negativeTrigger = true;
-                    sharedMemory->negativeTriggerTreshold = treshold2;
-                  }    
-                  // don't break, continue to the next case
-                  [[fallthrough]];
-          case 2: // one trigger
-                  if (!strcmp (posNeg1, "positive")) {
-                    sharedMemory->positiveTrigger = true;
-                    sharedMemory->positiveTriggerTreshold = treshold1;
-                  }
-                  if (!strcmp (posNeg1, "negative")) {
-                    sharedMemory->negativeTrigger = true;
-                    sharedMemory->negativeTriggerTreshold = treshold1;
-                  }
-                  break;
-          default:
-                    // cout << ( dmesgQueue << "[oscilloscope] oscilloscope protocol syntax error" );
-                    webSck->sendString ("[oscilloscope] oscilloscope protocol syntax error"); // send error also to javascript client
-                    free (sharedMemory);
-                    return;
-        }
-      }
-
       // check the values and calculate derived values
-      if (!(!strcmp (sharedMemory->readType, "analog") || !strcmp (sharedMemory->readType, "digital"))) {
-        // cout << ( dmesgQueue << "[oscilloscope] wrong readType - read type can only be analog or digital" );
-        webSck->sendString ("[oscilloscope] wrong readType -read type can only be analog or digital"); // send error also to javascript client
-        free (sharedMemory);
-        return;
-      }
-      if (sharedMemory->gpio1 < 0 || sharedMemory->gpio2 < 0) {
-        // cout << ( dmesgQueue << "[oscilloscope] invalid GPIO" );
-        webSck->sendString ("[oscilloscope] invalid GPIO"); // send error also to javascript client
-        free (sharedMemory);
-        return; 
+      if (!(!strcmp (sharedMemory->readType, "analog") || !strcmp (sharedMemory->readType, "digital") || !strcmp (sharedMemory->readType, "logic"))) {
+        // cout << ( dmesgQueue << "[oscilloscope] wrong readType - read type can only be analog, digital or logic" );
+        webSck->sendString ("[oscilloscope] wrong readType -read type can only be analog, digital or logic"); // send error also to javascript client
+        return false;
       }
       if (!(sharedMemory->samplingTime >= 1 && sharedMemory->samplingTime <= 25000)) {
         // cout << ( dmesgQueue << "[oscilloscope] invalid sampling time. Sampling time must be between 1 and 25000" );
         webSck->sendString ("[oscilloscope] invalid sampling time. Sampling time must be between 1 and 25000"); // send error also to javascript client
-        free (sharedMemory);
-        return;
+        return false;
       }
       if (strcmp (sharedMemory->samplingTimeUnit, "ms") && strcmp (sharedMemory->samplingTimeUnit, "us")) {
         // cout << ( dmesgQueue << "[oscilloscope] wrong samplingTimeUnit. Sampling time unit can only be ms or us" );
         webSck->sendString ("[oscilloscope] wrong samplingTimeUnit. Sampling time unit can only be ms or us"); // send error also to javascript client
-        free (sharedMemory);
-        return;
+        return false;
       }
 
       if (strcmp (sharedMemory->screenWidthTimeUnit, sharedMemory->samplingTimeUnit)) {
         // cout << ( dmesgQueue << "[oscilloscope] screenWidthTimeUnit must be the same as samplingTimeUnit" );
         webSck->sendString ("[oscilloscope] screenWidthTimeUnit must be the same as samplingTimeUnit"); // send error also to javascript client
-        free (sharedMemory);
-        return;
+        return false;
+      }
+
+      if (!(sharedMemory->preTriggerPercent >= 0 && sharedMemory->preTriggerPercent <= 100)) {
+        // cout << ( dmesgQueue << "[oscilloscope] invalid pre-trigger. Pre-trigger must be between 0 and 100 %" );
+        webSck->sendString ("[oscilloscope] invalid pre-trigger. Pre-trigger must be between 0 and 100 %"); // send error also to javascript client
+        return false;
+      }
+
+      if (!(sharedMemory->triggerMode <= OSC_TRIGGER_SINGLE && sharedMemory->holdoff <= 10000000)) {
+        // cout << ( dmesgQueue << "[oscilloscope] invalid trigger mode or holdoff. Trigger mode can only be normal, auto or single and holdoff can not be longer than 10 s" );
+        webSck->sendString ("[oscilloscope] invalid trigger mode or holdoff. Trigger mode can only be normal, auto or single and holdoff can not be longer than 10 s"); // send error also to javascript client
+        return false;
+      }
+
+      if (!(sharedMemory->sampleBits == 16 || sharedMemory->sampleBits == 12 || sharedMemory->sampleBits == 8)) {
+        // cout << ( dmesgQueue << "[oscilloscope] invalid sample format. Samples can only be sent in 16, 12 or 8 bits" );
+        webSck->sendString ("[oscilloscope] invalid sample format. Samples can only be sent in 16, 12 or 8 bits"); // send error also to javascript client
+        return false;
+      }
+
+      if (sharedMemory->recordLength) {
+        #ifdef USE_I2S_INTERFACE
+          if (!(sharedMemory->recordLength <= OSCILLOSCOPE_DEEP_RECORD_MAX_SAMPLES && !strcmp (sharedMemory->readType, "analog") && !strcmp (sharedMemory->samplingTimeUnit, "us") && (unsigned char) sharedMemory->gpio2 >= SOC_GPIO_PIN_COUNT)) {
+            // cout << ( dmesgQueue << "[oscilloscope] invalid record length. Deep record can only be taken of 1 analog signal sampled in us and can not have more than OSCILLOSCOPE_DEEP_RECORD_MAX_SAMPLES samples" );
+            webSck->sendString ("[oscilloscope] invalid record length. Deep record can only be taken of 1 analog signal sampled in us and can not have more than OSCILLOSCOPE_DEEP_RECORD_MAX_SAMPLES samples"); // send error also to javascript client
+            return false;
+          }
+        #else
+          // cout << ( dmesgQueue << "[oscilloscope] deep record needs I2S interface" );
+          webSck->sendString ("[oscilloscope] deep record needs I2S interface"); // send error also to javascript client
+          return false;
+        #endif
+      }
+
+      if (sharedMemory->spectrum) {
+        #ifdef USE_I2S_INTERFACE
+          if (!(sharedMemory->spectrumWindow <= OSC_WINDOW_BLACKMAN && sharedMemory->spectrumAverage >= 1 && sharedMemory->spectrumAverage <= 64 && sharedMemory->sampleBits != 12 && !sharedMemory->peakDetect && !sharedMemory->recordLength && !strcmp (sharedMemory->readType, "analog") && !strcmp (sharedMemory->samplingTimeUnit, "us") && (unsigned char) sharedMemory->gpio2 >= SOC_GPIO_PIN_COUNT)) {
+            // cout << ( dmesgQueue << "[oscilloscope] invalid spectrum settings. Spectrum can only be calculated of 1 analog signal sampled in us, without peak detect or deep record, with 16 or 8 bit bins and averaging of 1 - 64 spectra" );
+            webSck->sendString ("[oscilloscope] invalid spectrum settings. Spectrum can only be calculated of 1 analog signal sampled in us, without peak detect or deep record, with 16 or 8 bit bins and averaging of 1 - 64 spectra"); // send error also to javascript client
+            return false;
+          }
+        #else
+          // cout << ( dmesgQueue << "[oscilloscope] spectrum needs I2S interface" );
+          webSck->sendString ("[oscilloscope] spectrum needs I2S interface"); // send error also to javascript client
+          return false;
+        #endif
+      }
+
+      if (sharedMemory->measurements && !(!strcmp (sharedMemory->readType, "analog") && !strcmp (sharedMemory->samplingTimeUnit, "us") && !sharedMemory->recordLength && !sharedMemory->spectrum)) {
+        // cout << ( dmesgQueue << "[oscilloscope] measurements can only be taken of analog signals sampled in us, not of deep record or spectrum" );
+        webSck->sendString ("[oscilloscope] measurements can only be taken of analog signals sampled in us, not of deep record or spectrum"); // send error also to javascript client
+        return false;
       }
 
       if (sharedMemory->positiveTrigger) {
@@ -1437,8 +3769,7 @@
         } else {
             // cout << ( dmesgQueue << "[oscilloscope] invalid positive slope trigger treshold (according to other settings)" );
             webSck->sendString ("[oscilloscope] invalid positive slope trigger treshold (according to other settings)"); // send error also to javascript client
-            free (sharedMemory);
-            return;
+            return false;
         }
       }
       if (sharedMemory->negativeTrigger) {
@@ -1447,51 +3778,272 @@
         } else {
             // cout << ( dmesgQueue << "[oscilloscope] invalid negative slope trigger treshold (according to other settings)" );
             webSck->sendString ("[oscilloscope] invalid negative slope trigger treshold (according to other settings)"); // send error also to javascript client
-            free (sharedMemory);
-            return;
+            return false;
         }
       }
 
       // choose the corect oscReader
       void (*oscReader) (void *sharedMemory);
+      unsigned char noOfSignals = 1; if ((unsigned char) sharedMemory->gpio2 < SOC_GPIO_PIN_COUNT) noOfSignals = 2;  // monitor 1 or 2 signals
       if (strcmp (sharedMemory->readType, "analog")) {
-          oscReader = oscReader_digital; // us sampling interval, 1-2 signals, digital reader
+          oscReader = noOfSignals == 1 ? oscReader_transitions<1> : oscReader_transitions<2>; // us sampling interval, 1-2 signals, digital reader that only passes transitions
       } else {
-          oscReader = oscReader_analog; // us sampling interval, 1-2 signals, analog reader
+          oscReader = __oscReaderTimed__<true, false> (noOfSignals); // us sampling interval, 1-2 signals, analog reader
           #ifdef USE_I2S_INTERFACE
-            if (sharedMemory->gpio2 > 39 && sharedMemory->samplingTime <= 1000) // 1 signal only, sampling time is short enough
+            if (noOfSignals == 1 && sharedMemory->samplingTime <= 1000) // 1 signal only, sampling time is short enough
                 oscReader = oscReader_analog_1_signal_i2s; // us sampling interval, 1 signal, (fast, DMA) I2S analog reader
+            #if CONFIG_IDF_TARGET_ESP32
+              if (noOfSignals == 2 && sharedMemory->samplingTime <= 1000) // sampling time is short enough
+                  oscReader = oscReader_analog_2_signals_i2s; // us sampling interval, 2 signals, (fast, DMA) I2S analog reader scanning ADC pattern table
+            #endif
+          #endif
+          if (sharedMemory->peakDetect)
+              oscReader = noOfSignals == 1 ? oscReader_peakDetect<1> : oscReader_peakDetect<2>; // us sampling interval, 1-2 signals, (min, max) of raw analog samples
+          #ifdef USE_I2S_INTERFACE
+            if (sharedMemory->recordLength)
+                oscReader = oscReader_deepRecord_i2s; // us sampling interval, 1 signal, a single deep record in PSRAM taken by I2S analog reader
+            if (sharedMemory->spectrum)
+                oscReader = oscReader_spectrum_i2s; // us sampling interval, 1 signal, FFT spectrum of I2S analog samples
           #endif
       }
-      if (!strcmp (sharedMemory->samplingTimeUnit, "ms")) {
-          oscReader = oscReader_millis; // ms sampling intervl, 1-2 signals, digital or analog reader with 'sample at a time' or 'screen at a time' options
+      if (!strcmp (sharedMemory->samplingTimeUnit, "ms")) { // ms sampling intervl, 1-2 signals, digital or analog reader with 'sample at a time' or 'screen at a time' options
+          if (strcmp (sharedMemory->readType, "analog")) oscReader = __oscReaderTimed__<false, true> (noOfSignals);
+          else                                           oscReader = __oscReaderTimed__<true, true> (noOfSignals);
+      }
+      if (!strcmp (sharedMemory->readType, "logic")) { // ms or us sampling interval, up to 16 digital signals sampled at the same time, 'screen at a time' mode only
+          if (sharedMemory->logicSignals <= 8) oscReader = oscReader_logic<osc8LogicSignalsSample>;
+          else                                 oscReader = oscReader_logic<osc16LogicSignalsSample>;
       }
 
-      sharedMemory->oscReaderState = INITIAL;
+      // analogRead can't take enough samples of such a short screen
+      if (oscReader == __oscReaderTimed__<true, false> (noOfSignals) && ((noOfSignals == 2 && sharedMemory->screenWidthTime <= 200) || (noOfSignals == 1 && sharedMemory->screenWidthTime <= 100))) {
+        // cout << ( dmesgQueue << "[oscilloscope] the settings exceed oscilloscope capabilities" );
+        webSck->sendString ("[oscilloscope] the settings exceed oscilloscope capabilities"); // send error also to javascript client
+        return false;
+      }
 
-      BaseType_t taskCreated = xTaskCreate (oscReader, "oscReader", 4 * 1024, (void *) sharedMemory, OSCILLOSCOPE_READER_PRIORITY, NULL);
-      if (pdPASS != taskCreated) {
-            // cout << ( dmesgQueue << "[oscilloscope] could not start oscReader" );
-            webSck->sendString ("[oscilloscope] could not start oscReader"); // send error also to javascript client
-      } else {
+      // advanced triggers depend on the signals and oscReader
+      if (sharedMemory->positiveTrigger || sharedMemory->negativeTrigger) {
+        bool windowOrRunt = sharedMemory->triggerType == OSC_TRIGGER_WINDOW_ENTER || sharedMemory->triggerType == OSC_TRIGGER_WINDOW_EXIT || sharedMemory->triggerType == OSC_TRIGGER_RUNT;
+        bool pulseWidth = sharedMemory->triggerType == OSC_TRIGGER_PULSE_LONGER || sharedMemory->triggerType == OSC_TRIGGER_PULSE_SHORTER;
+        if (!(sharedMemory->triggerType <= OSC_TRIGGER_RUNT && (!windowOrRunt || (sharedMemory->positiveTrigger && sharedMemory->negativeTrigger && !strcmp (sharedMemory->readType, "analog") && sharedMemory->triggerSource != OSC_TRIGGER_SOURCE_GPIO)) && (!pulseWidth || sharedMemory->pulseWidth > 0))) {
+          // cout << ( dmesgQueue << "[oscilloscope] invalid trigger type. Window and runt triggers need both tresholds on analog signal and pulse width triggers need pulse width" );
+          webSck->sendString ("[oscilloscope] invalid trigger type. Window and runt triggers need both tresholds on analog signal and pulse width triggers need pulse width"); // send error also to javascript client
+          return false;
+        }
+        bool i2sReader = false;
+        #ifdef USE_I2S_INTERFACE
+          i2sReader = oscReader == oscReader_analog_1_signal_i2s || oscReader == oscReader_deepRecord_i2s || oscReader == oscReader_spectrum_i2s;
+          #if CONFIG_IDF_TARGET_ESP32
+            i2sReader = i2sReader || oscReader == oscReader_analog_2_signals_i2s;
+          #endif
+        #endif
+        if (!((sharedMemory->triggerSource == OSC_TRIGGER_SOURCE_CH1) || (sharedMemory->triggerSource == OSC_TRIGGER_SOURCE_CH2 && noOfSignals == 2) || (sharedMemory->triggerSource == OSC_TRIGGER_SOURCE_GPIO && sharedMemory->triggerGpio < SOC_GPIO_PIN_COUNT && !i2sReader))) {
+          // cout << ( dmesgQueue << "[oscilloscope] invalid trigger source. Channel 2 needs the second GPIO and separate trigger GPIO can't be used with I2S interface" );
+          webSck->sendString ("[oscilloscope] invalid trigger source. Channel 2 needs the second GPIO and separate trigger GPIO can't be used with I2S interface"); // send error also to javascript client
+          return false;
+        }
+        if (!(sharedMemory->hysteresis >= 0 && sharedMemory->hysteresis < 4095)) {
+          // cout << ( dmesgQueue << "[oscilloscope] invalid hysteresis. Hysteresis must be between 0 and 4094" );
+          webSck->sendString ("[oscilloscope] invalid hysteresis. Hysteresis must be between 0 and 4094"); // send error also to javascript client
+          return false;
+        }
+      }
+
+      // screens can only be combined when they are sampled continuously (through I2S interface) and aligned by the trigger
+      if (sharedMemory->acquisition != OSC_ACQUISITION_NORMAL) {
+        bool i2sReader = false;
+        #ifdef USE_I2S_INTERFACE
+          i2sReader = oscReader == oscReader_analog_1_signal_i2s;
+        #endif
+        if (!(i2sReader && sharedMemory->acquisition <= OSC_ACQUISITION_PERSISTENCE && sharedMemory->acquisitionFrames >= 1 && sharedMemory->acquisitionFrames <= 64 && (sharedMemory->acquisition == OSC_ACQUISITION_AVERAGE || !sharedMemory->measurements))) {
+          // cout << ( dmesgQueue << "[oscilloscope] invalid acquisition mode. Average, envelope and persistence of 1 - 64 screens need 1 analog signal sampled through I2S interface and envelope can't be measured" );
+          webSck->sendString ("[oscilloscope] invalid acquisition mode. Average, envelope and persistence of 1 - 64 screens need 1 analog signal sampled through I2S interface and envelope can't be measured"); // send error also to javascript client
+          return false;
+        }
+      }
+
+      // calibrated analog values need ADC calibration table, spectrum is always relative to full scale
+      if (sharedMemory->analogUnit != OSC_ANALOG_RAW) {
+        bool spectrum = false;
+        #ifdef USE_I2S_INTERFACE
+          spectrum = oscReader == oscReader_spectrum_i2s;
+        #endif
+        if (!(sharedMemory->analogUnit <= OSC_ANALOG_MILLIVOLTS && !strcmp (sharedMemory->readType, "analog") && !(spectrum && sharedMemory->analogUnit == OSC_ANALOG_MILLIVOLTS) && __oscAdcCalibrationTable__ (sharedMemory->analogUnit))) {
+          // cout << ( dmesgQueue << "[oscilloscope] invalid analog unit. Calibrated and mV values need analog signals and ADC calibration and spectrum can't be in mV" );
+          webSck->sendString ("[oscilloscope] invalid analog unit. Calibrated and mV values need analog signals and ADC calibration and spectrum can't be in mV"); // send error also to javascript client
+          return false;
+        }
+      }
+
+      sharedMemory->oscReader = oscReader;
+      memcpy (sharedMemory->command, parameters, length); // javascript clients that send the same parameters share the same oscReader
+      sharedMemory->commandLength = length;
+      return true;
+    }
+
+    // main oscilloscope function - it reads request from javascript client then starts two threads: oscilloscope reader (that reads samples ans packs them into buffer) and oscilloscope sender (that sends buffer to javascript client)
+
+    void runOscilloscope (httpServer_t::webSocket_t *webSck) {
+      oscSharedMemory *sharedMemory; 
+      // get some memory that will be shared among all oscilloscope threads and initialize it with zerros
+      sharedMemory = (oscSharedMemory *) malloc (sizeof (oscSharedMemory));
+      if (!sharedMemory) {
+            // cout << ( dmesgQueue << "[oscilloscope] out of memory" );
+            webSck->sendString ("[oscilloscope] out of memory"); // send error also to javascript client
+            return;
+      }
+      memset ((void *) sharedMemory, 0, sizeof (oscSharedMemory)); // this also sets frame queue (lock-free atomic) indices to 0
 
-                // send oscReader START signal and wait until STARTED
-                sharedMemory->oscReaderState = START; 
-                while (sharedMemory->oscReaderState == START) delay (1); 
+      sharedMemory->webSck = webSck;                                 // put webSocket rference into shared memory
+    
+      // oscilloscope protocol starts with binary endian identification from the client
+      uint16_t endianIdentification = 0;
+      if (webSck->recvBlock ((byte *) &endianIdentification, sizeof (endianIdentification)) == sizeof (endianIdentification))
+        sharedMemory->clientIsBigEndian = (endianIdentification == 0xBBAA); // cient has sent 0xAABB
+      if (!(endianIdentification == 0xAABB || endianIdentification == 0xBBAA)) {
+        // cout << ( dmesgQueue << "[oscilloscope] communication does not follow oscilloscope protocol - expected endian identification" );
+        webSck->sendString ("[oscilloscope] communication does not follow oscilloscope protocol - expected endian identification"); // send error also to javascript client
+        free (sharedMemory);
+        return;
+      }
+    
+      // oscilloscope protocol continues with binary control messages, javascript client may ask for ESP32 capabilities before it sends OSC_CMD_START with sampling parameters, for example:
+      // analog sampling on GPIO 36 every 10 us screen width = 5000 us set positive slope trigger to 1000 set pre-trigger to 25 %:
+      //    OSC_PARAM_READ_TYPE = OSC_READ_ANALOG, OSC_PARAM_GPIOS = 36, OSC_PARAM_TIME_UNIT = OSC_UNIT_US, OSC_PARAM_SAMPLING_TIME = 10, OSC_PARAM_SCREEN_WIDTH = 5000, OSC_PARAM_POSITIVE_TRIGGER = 1000, OSC_PARAM_PRE_TRIGGER = 25
+      // logic sampling on GPIO 4, 16, 17, 18 every 10 us screen width = 5000 us set positive slope trigger to 1:
+      //    OSC_PARAM_READ_TYPE = OSC_READ_LOGIC, OSC_PARAM_GPIOS = 4, 16, 17, 18, OSC_PARAM_TIME_UNIT = OSC_UNIT_US, OSC_PARAM_SAMPLING_TIME = 10, OSC_PARAM_SCREEN_WIDTH = 5000, OSC_PARAM_POSITIVE_TRIGGER = 1
+      oscControlMessage msg;
+      while (true) {
+        if (!__oscRecvControl__ (webSck, sharedMemory->clientIsBigEndian, &msg)) {
+            // cout << ( dmesgQueue << "[oscilloscope] communication does not follow oscilloscope protocol - expected start oscilloscope parameters" );
+            webSck->sendString ("[oscilloscope] communication does not follow oscilloscope protocol - expected start oscilloscope parameters"); // send error also to javascript client
+            free (sharedMemory);
+            return;
+        }
+        if (msg.header.opcode == OSC_CMD_START) break;
+        if (msg.header.opcode != OSC_CMD_GET_CAPABILITIES || !__oscSendCapabilities__ (webSck, sharedMemory->clientIsBigEndian)) {
+            // cout << ( dmesgQueue << "[oscilloscope] communication does not follow oscilloscope protocol - expected start oscilloscope parameters" );
+            webSck->sendString ("[oscilloscope] communication does not follow oscilloscope protocol - expected start oscilloscope parameters"); // send error also to javascript client
+            free (sharedMemory);
+            return;
+        }
+      }
+      if (!__oscConfigure__ (sharedMemory, msg.parameters, msg.header.length)) { // the error has already been reported to javascript client
+        free (sharedMemory);
+        return;
+      }
 
-        // start oscilloscope sender in this thread
+      sharedMemory->oscReaderState = INITIAL;
 
-        oscSender ((void *) sharedMemory); 
-        // stop reader - we can not simply vTaskDelete (oscReaderHandle) since this could happen in the middle of analogRead which would leave its internal semaphore locked
+      oscViewer *viewer = (oscViewer *) malloc (sizeof (oscViewer));
+      if (!viewer) {
+            // cout << ( dmesgQueue << "[oscilloscope] out of memory" );
+            webSck->sendString ("[oscilloscope] out of memory"); // send error also to javascript client
+            free (sharedMemory);
+            return;
+      }
+      viewer->webSck = webSck;
+      viewer->clientIsBigEndian = sharedMemory->clientIsBigEndian;
+      viewer->cursor.next = 0;
+      viewer->cursor.frameReadyEvent = __oscCreateFrameReadyEvent__ ();
+      if (viewer->cursor.frameReadyEvent < 0)
+          cout << ( dmesgQueue << "[oscilloscope] eventfd is not available, oscSender will poll for the frames" );
+
+      // sharedMemory belongs to this javascript client, runningOscReader is the oscReader it is watching (its own or shared by another javascript client)
+      oscSharedMemory *runningOscReader = NULL;
+      oscSharedMemory *leftBehind = NULL; // oscReader this javascript client has started but left to other viewers when it has changed the settings, it stops it when they leave
+      if (!startOscReaderWorkers ()) {
+            // cout << ( dmesgQueue << "[oscilloscope] could not start oscReader" );
+            webSck->sendString ("[oscilloscope] could not start oscReader"); // send error also to javascript client
+      } else while (true) { // OSC_CMD_RECONFIGURE may move javascript client to another oscReader, the session ends with OSC_CMD_STOP
+
+        if (!sharedMemory->recordLength && (runningOscReader = __oscAttachViewer__ (sharedMemory->command, sharedMemory->commandLength, viewer))) {
+                // another javascript client has already started oscReader with the same settings, just send its frames
+                free (sharedMemory);
+                sharedMemory = NULL;
+        } else if (__oscStartReader__ (sharedMemory, viewer)) {
+                // this javascript client is the first viewer, it will also stop oscReader when all the other viewers leave
+                runningOscReader = sharedMemory;
+        } else {
+                break; // the error has already been reported to javascript client
+        }
+        __oscSendSettings__ (webSck, viewer->clientIsBigEndian, runningOscReader);
+
+        // start oscilloscope sender in this thread, new settings are applied between the frames, without closing the session
+
+        oscSharedMemory *reconfigured = NULL;
+        bool readerRunning = true;
+        while (readerRunning && oscSender (&runningOscReader->frameQueue, viewer) == OSC_CMD_RECONFIGURE) {
+                if (leftBehind && __oscUnshareAcquisition__ (leftBehind)) {
+                    // the other viewers have left oscReader this javascript client has left to them
+                    __oscStopReader__ (leftBehind);
+                    free (leftBehind);
+                    leftBehind = NULL;
+                }
+                if (sharedMemory && __oscUnshareAcquisition__ (sharedMemory, 1)) {
+                    // nobody else is watching this oscReader, restart it with new settings in the same shared memory as soon as it pushes the frame it is filling
+                    __oscStopReader__ (sharedMemory, true);
+                    uint8_t previousCommand [sizeof (sharedMemory->command)];
+                    uint16_t previousCommandLength = sharedMemory->commandLength;
+                    memcpy (previousCommand, sharedMemory->command, previousCommandLength);
+                    bool configured = __oscConfigure__ (sharedMemory, viewer->control.parameters, viewer->control.header.length);
+                    if (!configured) // the error has already been reported to javascript client
+                        __oscConfigure__ (sharedMemory, previousCommand, previousCommandLength); // keep running with the previous settings
+                    readerRunning = __oscStartReader__ (sharedMemory, viewer);
+                    if (!readerRunning && configured && __oscConfigure__ (sharedMemory, previousCommand, previousCommandLength)) // the error has already been reported to javascript client
+                        readerRunning = __oscStartReader__ (sharedMemory, viewer); // keep running with the previous settings, the session ends only if even this fails
+                    if (readerRunning)
+                        __oscSendSettings__ (webSck, viewer->clientIsBigEndian, sharedMemory);
+                } else if (sharedMemory && leftBehind) {
+                    // other javascript clients are still watching oscReader this javascript client has left to them before, it can not leave another one
+                    webSck->sendString ("[oscilloscope] other viewers are watching the same signals, the settings can not be changed now"); // send error also to javascript client
+                } else {
+                    // watching oscReader of another javascript client or other viewers are watching this one (it can not be changed under their feet), move to oscReader with new settings
+                    reconfigured = (oscSharedMemory *) malloc (sizeof (oscSharedMemory));
+                    if (!reconfigured) {
+                        // cout << ( dmesgQueue << "[oscilloscope] out of memory" );
+                        webSck->sendString ("[oscilloscope] out of memory"); // send error also to javascript client
+                        continue;
+                    }
+                    memset ((void *) reconfigured, 0, sizeof (oscSharedMemory));
+                    reconfigured->webSck = webSck;
+                    reconfigured->clientIsBigEndian = viewer->clientIsBigEndian;
+                    if (__oscConfigure__ (reconfigured, viewer->control.parameters, viewer->control.header.length)) {
+                        if (sharedMemory) {
+                            // leave oscReader running for the other viewers, this javascript client still has to stop it when they leave
+                            leftBehind = sharedMemory;
+                            sharedMemory = NULL;
+                        }
+                        break;
+                    }
+                    free (reconfigured); // the error has already been reported to javascript client, keep watching with the previous settings
+                    reconfigured = NULL;
+                }
+        }
+        __oscDetachViewer__ (runningOscReader, viewer); // the client that has started oscReader will stop it when all the viewers leave
 
-                // send oscReader STOP signal
-                sharedMemory->oscReaderState = STOP; 
+        if (sharedMemory) {
+                // keep oscReader running while the other viewers are still watching
+                while (!__oscUnshareAcquisition__ (sharedMemory))
+                    vTaskDelay (pdMS_TO_TICKS (100));
+                if (readerRunning) __oscStopReader__ (sharedMemory);
+        }
+        if (!reconfigured) break;
+        sharedMemory = reconfigured; // attach to oscReader with new settings or start it
+      }
 
-                // wait until oscReader STOPPED or error
-                while (sharedMemory->oscReaderState != STOPPED) delay (1); 
+      if (leftBehind) {
+            // keep oscReader running while the other viewers are still watching
+            while (!__oscUnshareAcquisition__ (leftBehind))
+                vTaskDelay (pdMS_TO_TICKS (100));
+            __oscStopReader__ (leftBehind);
+            free (leftBehind);
       }
 
-      free (sharedMemory);
+      if (viewer->cursor.frameReadyEvent >= 0) close (viewer->cursor.frameReadyEvent);
+      free (viewer);
+      if (sharedMemory) free (sharedMemory);
       return;
     }
 